@@ -7,30 +7,48 @@
 #include <lora_phy/phy.hpp>
 
 /*!
- * Generate a chirp into a caller supplied buffer.  `samps` must reference at
- * least `NN` elements; the function writes the generated complex samples but
- * never allocates or frees memory.  All buffers remain owned by the caller.
+ * Generate the next `NN` samples of a chirp whose state is carried by the
+ * caller, so one chirp can be produced over several calls.  `start` begins
+ * a new chirp at frequency offset `f0`; otherwise generation continues from
+ * the instantaneous frequency `f` and phase `phaseAccum` the previous call
+ * left.  Unlike genChirp() the phase is not wrapped at the end.  Splitting a
+ * chirp at multiples of 64 samples reproduces genChirp() bit for bit, since
+ * the vector path stages phases in blocks of 64 from the chirp start.
  *
- * \param [out] samps pointer to the output samples
- * \param N samples per chirp sans the oversampling
- * \param osr oversampling ratio (1 = base rate)
- * \param NN the number of samples to generate
- * \param f0 the phase offset/transmit symbol
- * \param down true for downchirp, false for up
- * \param ampl the chrip amplitude
- * \param [inout] phaseAccum running phase accumulator value
+ * \param [inout] f instantaneous frequency state
+ * \param start true for the first segment of a chirp
+ * Other parameters as for genChirp().
  * \return the number of samples generated
  */
 template <typename Type>
-int genChirp(std::complex<Type> *samps, int N, int osr, int NN, Type f0, bool down,
-             const Type ampl, Type &phaseAccum, Type bw_scale = Type(1))
+int genChirpSegment(std::complex<Type> *samps, int N, int osr, int NN, Type f0, bool down,
+                    const Type ampl, Type &phaseAccum, float &f, bool start,
+                    Type bw_scale = Type(1),
+                    void (*polar)(std::complex<Type>*, const Type*, Type, size_t) = nullptr)
 {
     const Type fMin = -lora_phy::PI * bw_scale / osr;
     const Type fMax = lora_phy::PI * bw_scale / osr;
     const Type fStep = (2 * lora_phy::PI * bw_scale) / (N * osr * osr);
-    float f = fMin + f0;
+    if (start) f = fMin + f0;
     int i;
-    if (down) {
+    if (polar != nullptr) {
+        // Same phase recursion as below, staged through a small block so
+        // the transcendental part runs in the vector kernel.
+        const Type dir = down ? Type(-1) : Type(1);
+        Type phases[64];
+        for (i = 0; i < NN;) {
+            const int block = NN - i < 64 ? NN - i : 64;
+            for (int j = 0; j < block; j++) {
+                f += fStep;
+                if (f > fMax) f -= (fMax - fMin);
+                phaseAccum += dir * f;
+                phases[j] = phaseAccum;
+            }
+            polar(samps + i, phases, ampl, size_t(block));
+            i += block;
+        }
+    }
+    else if (down) {
         for (i = 0; i < NN; i++) {
             f += fStep;
             if (f > fMax) f -= (fMax - fMin);
@@ -46,6 +64,36 @@ int genChirp(std::complex<Type> *samps, int N, int osr, int NN, Type f0, bool do
             samps[i] = std::polar(ampl, phaseAccum);
         }
     }
+    return i;
+}
+
+/*!
+ * Generate a chirp into a caller supplied buffer.  `samps` must reference at
+ * least `NN` elements; the function writes the generated complex samples but
+ * never allocates or frees memory.  All buffers remain owned by the caller.
+ *
+ * \param [out] samps pointer to the output samples
+ * \param N samples per chirp sans the oversampling
+ * \param osr oversampling ratio (1 = base rate)
+ * \param NN the number of samples to generate
+ * \param f0 the phase offset/transmit symbol
+ * \param down true for downchirp, false for up
+ * \param ampl the chrip amplitude
+ * \param [inout] phaseAccum running phase accumulator value
+ * \param bw_scale bandwidth relative to 125 kHz
+ * \param polar optional vector kernel evaluating ampl*exp(j*phase) over a
+ *        block of phases (see lora_phy::dsp_kernels::polar); std::polar
+ *        per sample when null
+ * \return the number of samples generated
+ */
+template <typename Type>
+int genChirp(std::complex<Type> *samps, int N, int osr, int NN, Type f0, bool down,
+             const Type ampl, Type &phaseAccum, Type bw_scale = Type(1),
+             void (*polar)(std::complex<Type>*, const Type*, Type, size_t) = nullptr)
+{
+    float f = 0.0f;
+    const int i = genChirpSegment(samps, N, osr, NN, f0, down, ampl, phaseAccum, f, true,
+                                  bw_scale, polar);
     phaseAccum -= floor(phaseAccum / (2 * lora_phy::PI)) * 2 * lora_phy::PI;
     return i;
 }
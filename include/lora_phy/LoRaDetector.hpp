@@ -4,6 +4,9 @@
 #pragma once
 
 #include <complex>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
 #include <lora_phy/kissfft.hh>
 
 /**
@@ -11,22 +14,78 @@
  * buffers and the kissfft instance; the class does not allocate or free memory
  * and merely reads or writes to the provided arrays for the duration of the
  * call.
+ *
+ * Passing fft_out == nullptr (or fft_out == fft_in) selects the in-place
+ * mode: detect() transforms fft_in into itself, so one N point buffer is the
+ * whole working set.  The spectrum then replaces the fed samples.
+ *
+ * Type may be int16_t for Q15 samples: the transform then runs in block
+ * floating point, magnitudes are accumulated in 64-bit integers and the
+ * reported powers are corrected by the block exponent, so they read in dB
+ * relative to a full-scale (32768) tone just like the float detector's
+ * relative to amplitude 1.  Batch detection is float only.
+ *
+ * The metrics level trims what detect() derives from the spectrum beyond
+ * the argmax: DetectorMetrics::none skips the logarithms, square roots and
+ * interpolation entirely (power, powerAvg and fIndex read 0), peak reports
+ * the peak power and fIndex but no noise floor, full reports all three.
  */
 
+//! what detect() and detectBatch() report besides the peak bin
+enum class DetectorMetrics
+{
+    none, //!< argmax only
+    peak, //!< plus peak power and fractional bin offset
+    full, //!< plus the noise floor
+};
+
 template <typename Type>
 class LoRaDetector
 {
 public:
+    //! |x|^2 accumulator: wide integers for fixed point samples
+    using mag_type = typename std::conditional<std::is_integral<Type>::value,
+                                               std::int64_t, Type>::type;
+
+    //! type of the reported power, noise floor and bin offsets
+    using real_type = typename std::conditional<std::is_integral<Type>::value,
+                                                float, Type>::type;
+
+    //! optional fused magnitude/argmax/energy kernel (dsp_kernels::
+    //! mag2_argmax): returns the first index of the largest |x|^2 and
+    //! reports that value and the sum over all bins
+    using argmax_fn = size_t (*)(const std::complex<Type>*, size_t, mag_type*, double*);
+
+    //! one spectral peak reported by findPeaks/detectPeaks
+    struct Peak
+    {
+        size_t index;        //!< FFT bin of the local maximum
+        real_type magnitude; //!< |X| at that bin, in spectrum units
+        real_type offset;    //!< parabolic sub-bin offset, like fIndex
+    };
+
+    //! most peaks findPeaks reports at once
+    static const size_t MAX_PEAKS = 8;
+
+    //! most bits per symbol softBits handles (N up to 2^16)
+    static const unsigned MAX_SOFT_BITS = 16;
+
     LoRaDetector(const size_t N,
         std::complex<Type>* fft_in,
         std::complex<Type>* fft_out,
-        kissfft<Type>& fft):
+        kissfft<Type>& fft,
+        argmax_fn argmax = nullptr,
+        DetectorMetrics metrics = DetectorMetrics::full):
         N(N),
         fft_in(fft_in),
-        fft_out(fft_out),
-        _fft(fft)
+        fft_out(fft_out != nullptr ? fft_out : fft_in),
+        _fft(fft),
+        _argmax(argmax),
+        _metrics(metrics)
     {
         _powerScale = 20*std::log10(N);
+        _bits = 0;
+        while (_bits < MAX_SOFT_BITS && (size_t(2) << _bits) <= N) _bits++;
     }
 
     //! feed simply sets an input sample
@@ -35,19 +94,37 @@ public:
         fft_in[i] = samp;
     }
 
+    //! select what detect() and detectBatch() report besides the argmax
+    void setMetrics(const DetectorMetrics metrics)
+    {
+        _metrics = metrics;
+    }
+
+    DetectorMetrics metrics() const
+    {
+        return _metrics;
+    }
+
+    //! true when detect() transforms fft_in into itself
+    bool inPlace() const
+    {
+        return fft_out == fft_in;
+    }
+
     //! calculates argmax(abs(fft(input)))
-    size_t detect(Type &power, Type &powerAvg, Type &fIndex, std::complex<Type> *fftOutput = nullptr)
+    size_t detect(real_type &power, real_type &powerAvg, real_type &fIndex, std::complex<Type> *fftOutput = nullptr)
     {
         if (fftOutput == nullptr) fftOutput = fft_out;
-        _fft.transform(fft_in, fftOutput);
+        const int exponent = _fft.transform_scaled(fft_in, fftOutput);
         size_t maxIndex = 0;
-        Type maxValue = 0;
+        mag_type maxValue = 0;
         double total = 0;
-        for (size_t i = 0; i < N; i++)
+        if (_argmax != nullptr) maxIndex = _argmax(fftOutput, N, &maxValue, &total);
+        else for (size_t i = 0; i < N; i++)
         {
             auto bin = fftOutput[i];
-            auto re = bin.real();
-            auto im = bin.imag();
+            const mag_type re = bin.real();
+            const mag_type im = bin.imag();
             auto mag2 = re*re + im*im;
             total += mag2;
             if (mag2 > maxValue)
@@ -57,26 +134,345 @@ public:
             }
         }
 
-        const auto noise = std::sqrt(Type(total - maxValue));
-        const auto fundamental = std::sqrt(maxValue);
+        finish(maxIndex, maxValue, total, fftOutput, 1, power, powerAvg, fIndex);
+        if constexpr (std::is_integral<Type>::value)
+        {
+            // undo the block floating point scaling and the Q15 unit
+            if (_metrics == DetectorMetrics::none) return maxIndex;
+            const real_type gain = real_type(20*std::log10(2.0)*(exponent - 15));
+            power += gain;
+            if (_metrics == DetectorMetrics::full) powerAvg += gain;
+        }
+        return maxIndex;
+    }
 
-        powerAvg = 20*std::log10(noise) - _powerScale;
-        power = 20*std::log10(fundamental) - _powerScale;
+    //! transform the input and report its K strongest peaks, see findPeaks
+    size_t detectPeaks(const size_t K, Peak* peaks, std::complex<Type> *fftOutput = nullptr)
+    {
+        if (fftOutput == nullptr) fftOutput = fft_out;
+        _fft.transform(fft_in, fftOutput);
+        return findPeaks(fftOutput, 1, K, peaks);
+    }
 
-        auto left = std::abs(fftOutput[maxIndex > 0?maxIndex-1:N-1]);
-        auto right = std::abs(fftOutput[maxIndex < N-1?maxIndex+1:0]);
+    //! the K (at most MAX_PEAKS) strongest local maxima of |X| in a spectrum
+    //! whose bins are stride elements apart, strongest first, lowest index
+    //! first on equal magnitude; the first one is detect()'s argmax.  One
+    //! pass over the bins keeps a sorted K-entry buffer and rejects most
+    //! bins with a single compare against its weakest entry.  A peak is a
+    //! bin, or a run of equal bins reported at its first bin, strictly above
+    //! both neighbours, so a flat spectrum has none.  Returns the number of
+    //! peaks written, which is below K only for spectra with fewer local
+    //! maxima.
+    size_t findPeaks(const std::complex<Type>* spectrum, const size_t stride,
+                     size_t K, Peak* peaks) const
+    {
+        if (K > MAX_PEAKS) K = MAX_PEAKS;
+        mag_type kept[MAX_PEAKS];
+        size_t at[MAX_PEAKS];
+        size_t count = 0;
+        mag_type cur = mag2(spectrum[0]);
+        // a plateau wrapping from bin N-1 to bin 0 counts at bin 0, like
+        // detect()'s argmax, so its tail bins are not visited at all and the
+        // bin before it is the one before the tail
+        size_t end = N;
+        while (end > 1 && mag2(spectrum[(end-1)*stride]) == cur) end--;
+        mag_type prev = mag2(spectrum[(end-1)*stride]);
+        for (size_t i = 0; i < end && K > 0; i++)
+        {
+            const mag_type next = mag2(spectrum[(i < N-1 ? i+1 : 0)*stride]);
+            bool isPeak = cur > prev && cur >= next && (count < K || cur > kept[K-1]);
+            if (isPeak && cur == next)
+            {
+                // a plateau must also fall after its last bin; the scan
+                // stops at the latest on bin i-1, which is below it
+                size_t j = i + 2;
+                while (mag2(spectrum[(j % N)*stride]) == cur) j++;
+                isPeak = mag2(spectrum[(j % N)*stride]) < cur;
+            }
+            if (isPeak)
+            {
+                size_t j = count < K ? count++ : K-1;
+                for (; j > 0 && kept[j-1] < cur; j--)
+                {
+                    kept[j] = kept[j-1];
+                    at[j] = at[j-1];
+                }
+                kept[j] = cur;
+                at[j] = i;
+            }
+            prev = cur;
+            cur = next;
+        }
+        for (size_t j = 0; j < count; j++)
+        {
+            const real_type magnitude = std::sqrt(real_type(kept[j]));
+            peaks[j].index = at[j];
+            peaks[j].magnitude = magnitude;
+            peaks[j].offset = interpolate(at[j], magnitude, spectrum, stride);
+        }
+        return count;
+    }
 
-        const auto demon = (2.0 * fundamental) - right - left;
-        if (demon == 0.0) fIndex = 0.0; //check for divide by 0
-        else fIndex = 0.5 * (right - left) / demon;
+    //! dB between the strongest and the second strongest local maximum of
+    //! |X| in a spectrum whose bins are stride elements apart (see
+    //! findPeaks); infinite when there is no second peak.  A collision or a
+    //! near miss reads close to 0, a clean symbol well above the SNR.
+    real_type peakToSecond(const std::complex<Type>* spectrum, const size_t stride) const
+    {
+        Peak peaks[2];
+        if (findPeaks(spectrum, stride, 2, peaks) < 2 || !(peaks[1].magnitude > 0))
+            return std::numeric_limits<real_type>::infinity();
+        return 20*std::log10(peaks[0].magnitude/peaks[1].magnitude);
+    }
 
-        return maxIndex;
+    //! bits carried by one symbol, log2(N), i.e. the LLRs softBits writes
+    unsigned bitsPerSymbol() const
+    {
+        return _bits;
+    }
+
+    //! max-log LLRs of the log2(N) bits of the symbol index, LSB first, from
+    //! a spectrum whose bins are stride elements apart (N a power of two up
+    //! to KISSFFT_MAX_N): llr[k] = (max |X|^2 over bins with bit k clear -
+    //! max over bins with bit k set) / noise, noise being the mean |X|^2 of
+    //! the bins other than the peak.  Positive favours 0 and the sign always
+    //! agrees with the argmax.
+    //!
+    //! The bins with bit k clear are the even blocks of 2^k bins, so a max
+    //! tree yields every bit's two maxima in about 2N compares: SOFT_CHUNK
+    //! bins at a time on the stack for the low bits, then the chunk maxima
+    //! for the high ones.
+    void softBits(const std::complex<Type>* spectrum, const size_t stride,
+                  real_type* llr) const
+    {
+        mag_type best[2][MAX_SOFT_BITS] = {};
+        mag_type tops[kissfft_utils::KISSFFT_MAX_N/SOFT_CHUNK + 1] = {};
+        mag_type level[SOFT_CHUNK];
+        double total = 0;
+        unsigned low = 0;
+        while (low < _bits && (size_t(2) << low) <= SOFT_CHUNK) low++;
+        const size_t chunk = size_t(1) << low;
+        for (size_t c = 0; c < N/chunk; c++)
+        {
+            const std::complex<Type>* bins = spectrum + c*chunk*stride;
+            mag_type sum[4] = {};
+            for (size_t i = 0; i < chunk; i++)
+            {
+                level[i] = mag2(bins[i*stride]);
+                sum[i & 3] += level[i];
+            }
+            total += double(sum[0] + sum[1]) + double(sum[2] + sum[3]);
+            tops[c] = reduceBits(level, chunk, 0, low, best);
+        }
+        const mag_type peak = reduceBits(tops, N/chunk, low, _bits, best);
+        double noise = N > 1 ? (total - double(peak))/double(N - 1) : 0.0;
+        if (!(noise > 0.0)) noise = 1.0;
+        const double scale = 1.0/noise;
+        for (unsigned k = 0; k < _bits; k++)
+            llr[k] = real_type(double(best[0][k] - best[1][k])*scale);
+    }
+
+    //! batch detect over count symbols stored interleaved in input (sample i
+    //! of symbol b at input[i*count + b]); spectra are written to output in
+    //! the same layout, which may be input itself.  index receives count bin
+    //! indices; power, powerAvg and fIndex are optional per-symbol arrays,
+    //! each filled according to the metrics level unless it is null.
+    void detectBatch(const std::complex<Type>* input, std::complex<Type>* output,
+                     const size_t count, size_t* index,
+                     Type* power = nullptr, Type* powerAvg = nullptr,
+                     Type* fIndex = nullptr)
+    {
+        _fft.transform_batch(input, output, count);
+        for (size_t b0 = 0; b0 < count; b0 += MAX_LANES)
+        {
+            const size_t lanes = count - b0 < MAX_LANES ? count - b0 : MAX_LANES;
+            size_t maxIndex[MAX_LANES] = {};
+            Type maxValue[MAX_LANES] = {};
+            double total[MAX_LANES] = {};
+            for (size_t i = 0; i < N; i++)
+            {
+                const std::complex<Type>* row = output + i*count + b0;
+                for (size_t b = 0; b < lanes; b++)
+                {
+                    auto re = row[b].real();
+                    auto im = row[b].imag();
+                    auto mag2 = re*re + im*im;
+                    total[b] += mag2;
+                    if (mag2 > maxValue[b])
+                    {
+                        maxIndex[b] = i;
+                        maxValue[b] = mag2;
+                    }
+                }
+            }
+            for (size_t b = 0; b < lanes; b++)
+            {
+                index[b0 + b] = maxIndex[b];
+                if ((power == nullptr && powerAvg == nullptr && fIndex == nullptr) ||
+                    _metrics == DetectorMetrics::none) continue;
+                real_type p, pav, fi;
+                finish(maxIndex[b], maxValue[b], total[b], output + b0 + b, count, p, pav, fi);
+                if (power != nullptr) power[b0 + b] = p;
+                if (powerAvg != nullptr) powerAvg[b0 + b] = pav;
+                if (fIndex != nullptr) fIndex[b0 + b] = fi;
+            }
+        }
+    }
+
+    //! sub-bin peak position around maxIndex (from detect on the current
+    //! input) by a zoom DFT: a chirp-z evaluation of a handful of fine bins
+    //! within +-0.5 bins, narrowed once, followed by a parabolic fit on the
+    //! fine grid.  Costs about 2*ZOOM_POINTS*N complex MACs instead of a
+    //! zero-padded FFT; returns the offset in bins and optionally the
+    //! spectrum there.  In-place mode must feed the symbol again first.
+    real_type refine(const size_t maxIndex, std::complex<real_type>* peak = nullptr) const
+    {
+        std::complex<double> bins[ZOOM_POINTS];
+        double mag2[ZOOM_POINTS];
+        double center = 0.0;
+        double spacing = 0.25;
+        size_t best = 0;
+        for (int level = 0; level < 2; level++)
+        {
+            const double first = center - spacing*(ZOOM_POINTS/2);
+            zoom(double(maxIndex) + first, spacing, bins);
+            best = 0;
+            for (size_t m = 0; m < ZOOM_POINTS; m++)
+            {
+                mag2[m] = std::norm(bins[m]);
+                if (mag2[m] > mag2[best]) best = m;
+            }
+            center = first + spacing*best;
+            if (level == 0) spacing /= 2;
+        }
+
+        double offset = center;
+        if (best > 0 && best < ZOOM_POINTS-1)
+        {
+            const double l = std::sqrt(mag2[best-1]);
+            const double c = std::sqrt(mag2[best]);
+            const double r = std::sqrt(mag2[best+1]);
+            const double demon = 2.0*c - r - l;
+            if (demon > 0.0) offset += spacing * 0.5*(r - l)/demon;
+        }
+        if (peak != nullptr)
+        {
+            std::complex<double> at;
+            zoom(double(maxIndex) + offset, 0.0, &at, 1);
+            *peak = std::complex<real_type>(real_type(at.real()), real_type(at.imag()));
+        }
+        return real_type(offset);
     }
 
 private:
+    //! symbols scanned together by detectBatch
+    static const size_t MAX_LANES = 16;
+
+    //! fine bins evaluated per refine() level
+    static const size_t ZOOM_POINTS = 5;
+
+    //! bins softBits reduces on the stack at once
+    static const size_t SOFT_CHUNK = 64;
+
+    //! fold len block maxima (len a power of two) pairwise for bits first to
+    //! last-1: at bit k the even entries have it clear and the odd ones set.
+    //! Updates best and returns the overall maximum.
+    static mag_type reduceBits(mag_type* v, size_t len, const unsigned first,
+                               const unsigned last, mag_type (*best)[MAX_SOFT_BITS])
+    {
+        for (unsigned k = first; k < last; k++)
+        {
+            mag_type even = best[0][k], odd = best[1][k];
+            len /= 2;
+            for (size_t t = 0; t < len; t++)
+            {
+                const mag_type e = v[2*t], o = v[2*t + 1];
+                even = e > even ? e : even;
+                odd = o > odd ? o : odd;
+                v[t] = e > o ? e : o;
+            }
+            best[0][k] = even;
+            best[1][k] = odd;
+        }
+        return v[0];
+    }
+
+    //! X(f0 + m*df) = sum_n fft_in[n] * exp(-2*pi*i*(f0 + m*df)*n/N) for
+    //! m < points, with f in bins; one pass over the input, phasors in double
+    void zoom(const double f0, const double df, std::complex<double>* out,
+              const size_t points = ZOOM_POINTS) const
+    {
+        const double pi = std::acos(-1.0);
+        std::complex<double> w[ZOOM_POINTS], step[ZOOM_POINTS];
+        for (size_t m = 0; m < points; m++)
+        {
+            const double ph = -2*pi*(f0 + m*df)/double(N);
+            step[m] = std::complex<double>(std::cos(ph), std::sin(ph));
+            w[m] = 1.0;
+            out[m] = 0.0;
+        }
+        for (size_t n = 0; n < N; n++)
+        {
+            const std::complex<double> x(fft_in[n].real(), fft_in[n].imag());
+            for (size_t m = 0; m < points; m++)
+            {
+                out[m] += x * w[m];
+                w[m] *= step[m];
+            }
+        }
+    }
+
+    //! power, noise floor and fractional bin offset around maxIndex of a
+    //! spectrum whose bins are stride elements apart, as far as the metrics
+    //! level asks for them; the rest read 0
+    void finish(const size_t maxIndex, const mag_type maxValue, const double total,
+                const std::complex<Type>* spectrum, const size_t stride,
+                real_type &power, real_type &powerAvg, real_type &fIndex) const
+    {
+        power = powerAvg = fIndex = 0;
+        if (_metrics == DetectorMetrics::none) return;
+        // powers straight from |X|^2; only the peak needs its magnitude
+        power = 10*std::log10(real_type(maxValue)) - _powerScale;
+        fIndex = interpolate(maxIndex, std::sqrt(real_type(maxValue)), spectrum, stride);
+        if (_metrics == DetectorMetrics::full)
+            powerAvg = 10*std::log10(real_type(total - maxValue)) - _powerScale;
+    }
+
+    //! parabolic sub-bin offset of the peak at maxIndex with magnitude
+    //! fundamental, from its two neighbours
+    real_type interpolate(const size_t maxIndex, const real_type fundamental,
+                          const std::complex<Type>* spectrum, const size_t stride) const
+    {
+        auto left = magnitude(spectrum[(maxIndex > 0?maxIndex-1:N-1)*stride]);
+        auto right = magnitude(spectrum[(maxIndex < N-1?maxIndex+1:0)*stride]);
+
+        const auto demon = (2.0 * fundamental) - right - left;
+        if (demon == 0.0) return 0.0; //check for divide by 0
+        return real_type(0.5 * (right - left) / demon);
+    }
+
+    static mag_type mag2(const std::complex<Type> &x)
+    {
+        const mag_type re = x.real();
+        const mag_type im = x.imag();
+        return re*re + im*im;
+    }
+
+    //! sqrt(re^2 + im^2) without the overflow guarding of std::abs/hypot,
+    //! which no FFT bin needs
+    static real_type magnitude(const std::complex<Type> &x)
+    {
+        const real_type re = real_type(x.real());
+        const real_type im = real_type(x.imag());
+        return std::sqrt(re*re + im*im);
+    }
+
     const size_t N;
-    Type _powerScale;
+    unsigned _bits;
+    real_type _powerScale;
     std::complex<Type>* fft_in;
     std::complex<Type>* fft_out;
     kissfft<Type>& _fft;
+    argmax_fn _argmax;
+    DetectorMetrics _metrics;
 };
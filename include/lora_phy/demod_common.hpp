@@ -0,0 +1,64 @@
+/**
+ * @file demod_common.hpp
+ * Definitions shared by every demodulator: demodulate()/demodulate_soft(),
+ * lora_demodulate()/lora_demodulate_sc16() and modem<SF, OSR>.  Keeping the
+ * timing shift, the sync word packing and the packet metrics in one place
+ * means the demodulators cannot drift apart on them.  Library internals,
+ * not part of the API.
+ */
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+#include <lora_phy/phy.hpp>
+
+namespace lora_phy {
+namespace detail {
+
+/** Start of symbol @p s of @p step samples once the timing offset @p t_off
+ * is applied.  Shifts that would run past either end of the @p sample_count
+ * samples are dropped. */
+inline std::size_t symbol_base(std::size_t s, std::size_t step, int t_off,
+                               std::size_t sample_count)
+{
+    std::size_t base = s * step;
+    if (t_off > 0) {
+        if (base + std::size_t(t_off) + step <= sample_count) base += std::size_t(t_off);
+    } else if (t_off < 0) {
+        const std::size_t off = std::size_t(-t_off);
+        if (off <= base) base -= off;
+    }
+    return base;
+}
+
+/** Sync word from the top nibbles of the two sync symbols of an N-bin
+ * symbol. */
+inline uint8_t pack_sync(std::size_t N, uint16_t sw0, uint16_t sw1)
+{
+    unsigned sf = 0;
+    while ((std::size_t(1) << sf) < N) ++sf;
+    const unsigned shift = sf > 4 ? sf - 4 : 0;
+    return static_cast<uint8_t>(((sw0 >> shift) & 0x0f) << 4 | ((sw1 >> shift) & 0x0f));
+}
+
+/** Packet metrics in @p m from the per-symbol peak and noise powers summed
+ * over @p count payload symbols: their means as far as @p level computed
+ * them, 0 otherwise.  SNR and RSSI follow from the two means, so no pass
+ * over the samples is needed. */
+inline void payload_metrics(lora_metrics& m, metrics_level level, float sum_power,
+                            float sum_noise, std::size_t count)
+{
+    m.peak_power = m.noise_power = m.snr = m.rssi = 0.0f;
+    if (count == 0 || level == metrics_level::none) return;
+    m.peak_power = sum_power / static_cast<float>(count);
+    if (level != metrics_level::full) return;
+    m.noise_power = sum_noise / static_cast<float>(count);
+    m.snr = m.peak_power - m.noise_power;
+    m.rssi = 10.0f * std::log10(std::pow(10.0f, 0.1f * m.peak_power) +
+                                std::pow(10.0f, 0.1f * m.noise_power));
+}
+
+} // namespace detail
+} // namespace lora_phy
@@ -0,0 +1,99 @@
+/**
+ * @file dsp_kernels.hpp
+ * Runtime selected implementations of the modem's hot inner loops.  The
+ * library is built once for the baseline ISA; wider variants are compiled
+ * per function and picked at init()/lora_demod_init() time from the CPU
+ * features reported by the host.  Tables are static and immutable, so a
+ * pointer obtained from get_dsp_kernels() stays valid for the process
+ * lifetime and may be shared between threads.
+ */
+#pragma once
+
+#include <complex>
+#include <cstddef>
+#include <cstdint>
+
+namespace lora_phy {
+
+/** Instruction set used by a kernel table. */
+enum class cpu_backend {
+    automatic, ///< best backend supported by the host (request only)
+    scalar,    ///< portable C++ loops
+    sse42,     ///< 128-bit SSE4.2
+    avx2,      ///< 256-bit AVX2 + FMA
+    avx512,    ///< 512-bit AVX-512F
+};
+
+/** Function table for one backend.  All kernels work on caller buffers and
+ * never allocate. */
+struct dsp_kernels {
+    cpu_backend backend;
+
+    /** One radix-4 pass of the power-of-two FFT over @p n points; see
+     * kissfft_utils::pow2_radix4_pass for the data and twiddle layout. */
+    void (*fft_radix4)(std::complex<float>* x, const std::complex<float>* tw,
+                       std::size_t m, std::size_t n, bool inverse);
+
+    /** Radix-4 pass over @p count interleaved transforms (point i of
+     * transform b at x[i * count + b]); vector lanes run across transforms.
+     * See kissfft_utils::pow2_radix4_pass_batch. */
+    void (*fft_radix4_batch)(std::complex<float>* x, const std::complex<float>* tw,
+                             std::size_t m, std::size_t n, std::size_t count,
+                             bool inverse);
+
+    /** Dechirp multiply: dst[i] = a[i * stride] * b[i] for i < n.  Stride 0
+     * scales b by the single phasor a[0], as the chirp table modulator does. */
+    void (*cmul)(std::complex<float>* dst, const std::complex<float>* a,
+                 std::size_t stride, const std::complex<float>* b, std::size_t n);
+
+    /** Fused derotate + dechirp + window: dst[i] = a[i * stride] *
+     * (b[i] * (z[0] * c[i])) for i < n, in one pass.  @p b is the
+     * (windowed) downchirp, @p c a block of oscillator phasors and @p z the
+     * block's start phasor; see nco::dechirp.  The products are taken in
+     * the order cmul takes them, so the result is bit exact with cmul(z, 0,
+     * c), then cmul(b, 1, .), then cmul(a, stride, .).  @p dst may alias
+     * @p b. */
+    void (*derotate)(std::complex<float>* dst, const std::complex<float>* a,
+                     std::size_t stride, const std::complex<float>* b,
+                     const std::complex<float>* c, const std::complex<float>* z,
+                     std::size_t n);
+
+    /** Index of the first largest |x[i]|^2; writes that magnitude squared to
+     * @p max_mag2 and the sum over all bins to @p total.  One fused pass:
+     * vector backends run two compare/select chains side by side and sum in
+     * float lanes, folded into the double total every few vectors. */
+    std::size_t (*mag2_argmax)(const std::complex<float>* x, std::size_t n,
+                               float* max_mag2, double* total);
+
+    /** dst[i] = ampl * exp(j * phase[i]).  Vector backends evaluate sin/cos
+     * with a minimax polynomial after Cody-Waite reduction; the absolute
+     * error stays below 1e-6 for |phase| < 32768, which covers the
+     * accumulated phase of any chirp genChirp produces (at most
+     * pi * N * bw_scale / 4 before its final wrap). */
+    void (*polar)(std::complex<float>* dst, const float* phase, float ampl,
+                  std::size_t n);
+
+    /** Q15 radix-4 pass with block floating point; see
+     * kissfft_utils::pow2_radix4_pass_q15.  Results are bit exact across
+     * backends.  The avx512 table reuses the AVX2 kernel because AVX-512F
+     * has no 16-bit integer arithmetic. */
+    int (*fft_radix4_q15)(std::complex<int16_t>* x, const std::complex<int16_t>* tw,
+                          std::size_t m, std::size_t n, bool inverse, int shift);
+
+    /** Q15 dechirp multiply, dst[i] = kissfft_utils::q15_cmul(a[i * stride],
+     * b[i]); @p b must stay within +-32767 per component. */
+    void (*cmul_q15)(std::complex<int16_t>* dst, const std::complex<int16_t>* a,
+                     std::size_t stride, const std::complex<int16_t>* b, std::size_t n);
+};
+
+/** Best backend supported by the running CPU. */
+cpu_backend detect_cpu_backend();
+
+/** Kernel table for @p backend, or nullptr when the host cannot run it.
+ * cpu_backend::automatic resolves to detect_cpu_backend(). */
+const dsp_kernels* get_dsp_kernels(cpu_backend backend = cpu_backend::automatic);
+
+/** Human readable backend name ("scalar", "sse4.2", "avx2", "avx512"). */
+const char* cpu_backend_name(cpu_backend backend);
+
+} // namespace lora_phy
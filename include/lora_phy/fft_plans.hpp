@@ -0,0 +1,88 @@
+/**
+ * @file fft_plans.hpp
+ * FFT plan selection and the process-wide registry of read-only plans.
+ *
+ * Planning: fft_planning::estimate (the default) picks the engine and
+ * factorization with a fixed rule, exactly like kissfft::init, so results
+ * are reproducible across hosts.  fft_planning::measure times a handful of
+ * candidates (the iterative power-of-two engine and several mixed-radix
+ * factor orders) with the caller's DSP kernels and keeps the fastest.
+ * Measured choices are remembered as "wisdom" per (nfft, direction, backend)
+ * and can be saved to and loaded from a small text file so later process
+ * starts skip the measurement.
+ *
+ * Registry: every workspace running the same spreading factor references one
+ * forward (and one inverse) plan instead of carrying its own KISSFFT_MAX_N
+ * twiddle and bit-reversal tables.  Plans are built on first request into a
+ * static arena whose slot for each length holds exactly nfft entries, so the
+ * registry never touches the heap.  Measured plans get one slot per backend
+ * because the fastest plan depends on the kernels it was timed with.  A slot
+ * keeps its plan for the rest of the process once built, so wisdom loaded or
+ * forgotten afterwards only affects slots that have not been requested yet
+ * and direct plan_fft() calls.  Builds configured with
+ * LORA_PHY_EMBEDDED_PLANS keep a kissfft_embedded_plan inside each workspace
+ * instead and do not compile the registry.
+ */
+#pragma once
+
+#include <lora_phy/kissfft.hh>
+#include <lora_phy/dsp_kernels.hpp>
+
+// Set by the LORA_PHY_EMBEDDED_PLANS CMake option; must be identical for the
+// library and every translation unit including phy.hpp.
+#ifndef LORA_PHY_EMBEDDED_PLANS
+#define LORA_PHY_EMBEDDED_PLANS 0
+#endif
+
+namespace lora_phy {
+
+/** How an FFT plan is chosen. */
+enum class fft_planning {
+    estimate, ///< fixed heuristic, deterministic (default)
+    measure,  ///< time candidate plans on this host, or reuse wisdom
+};
+
+/** Build @p plan over caller storage; @p twiddles and @p bitrev must each
+ * hold nfft entries and outlive the plan.  With fft_planning::measure the
+ * candidates are timed with @p kernels (nullptr selects the host's best
+ * backend) unless wisdom for the same (nfft, inverse, backend) exists.
+ * Returns 0, or -EINVAL when nfft is outside [1, KISSFFT_MAX_N]. */
+int plan_fft(kissfft_plan<float>& plan, int nfft, bool inverse,
+             std::complex<float>* twiddles, unsigned short* bitrev,
+             fft_planning planning, const dsp_kernels* kernels = nullptr);
+
+/** Merge wisdom from the file at @p path into the in-process table.  Returns
+ * 0, -errno when the file cannot be opened or -EINVAL for malformed content
+ * (entries before the bad line are kept).  Load it before the first measured
+ * init() or shared_fft_plan() call: registry plans already built are not
+ * replaced. */
+int load_fft_wisdom(const char* path);
+
+/** Write every measured or loaded choice to @p path.  Returns 0 or -errno. */
+int save_fft_wisdom(const char* path);
+
+/** Drop all wisdom; the next measured plan_fft() call is timed again.
+ * Registry plans already built are kept. */
+void forget_fft_wisdom();
+
+#if !LORA_PHY_EMBEDDED_PLANS
+
+/** Shared plan for a power-of-two @p nfft in [1, KISSFFT_MAX_N], or nullptr
+ * for any other length.  The first call for a given (nfft, inverse,
+ * planning) triple builds the plan; measured plans are additionally keyed by
+ * the backend of @p kernels (nullptr selects the host's best) and timed with
+ * it.  Later calls, from any thread, return the same pointer without
+ * locking.  Returned plans are immutable and live for the rest of the
+ * process. */
+const kissfft_plan<float>* shared_fft_plan(int nfft, bool inverse,
+                                           fft_planning planning = fft_planning::estimate,
+                                           const dsp_kernels* kernels = nullptr);
+
+/** Q15 counterpart of shared_fft_plan() for the fixed point demodulator.
+ * Always built with the estimate rule: the Q15 engine has a single
+ * candidate per power-of-two length. */
+const kissfft_plan<std::int16_t>* shared_fft_plan_q15(int nfft, bool inverse);
+
+#endif
+
+} // namespace lora_phy
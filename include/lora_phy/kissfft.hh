@@ -4,22 +4,49 @@
 #define KISSFFT_CLASS_HH
 #include <complex>
 #include <cstddef>
+#include <cstdint>
 #include <cmath>
+#include <type_traits>
+#include <utility>
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
 
 // The implementation below is a minimal subset of KISS FFT adapted for use in
 // fixed-size workspaces. All memory required for the transform is provided by a
-// plan structure containing statically sized arrays.  Callers are responsible
-// for allocating the plan and the input/output buffers; no dynamic allocations
-// are performed and the library never frees caller owned memory.
+// plan whose tables live either in a kissfft_embedded_plan or in caller
+// supplied storage.  Callers are responsible for allocating the plan and the
+// input/output buffers; no dynamic allocations are performed and the library
+// never frees caller owned memory.
+//
+// Besides float, the scalar type may be std::int16_t (Q15): see
+// traits<std::int16_t> and kissfft::transform_scaled for the fixed point
+// scaling rules.
 
 namespace kissfft_utils {
 
-// Traits helper used for generating twiddle factors.
+// Traits helper used for generating twiddle factors and for the scalar
+// arithmetic of the mixed-radix butterflies.
 template <typename T_scalar>
 struct traits
 {
     using scalar_type = T_scalar;
     using cpx_type = std::complex<scalar_type>;
+    // Optional replacements for the power-of-two passes, see kissfft.
+    using radix4_fn = void (*)(cpx_type*, const cpx_type*, std::size_t,
+                               std::size_t, bool);
+    using radix4_batch_fn = void (*)(cpx_type*, const cpx_type*, std::size_t,
+                                     std::size_t, std::size_t, bool);
+    static constexpr bool fixed_point = false;
+
+    static void C_ADD(cpx_type& c, const cpx_type& a, const cpx_type& b) { c = a + b; }
+    static void C_MUL(cpx_type& c, const cpx_type& a, const cpx_type& b) { c = a * b; }
+    static void C_SUB(cpx_type& c, const cpx_type& a, const cpx_type& b) { c = a - b; }
+    static void C_ADDTO(cpx_type& c, const cpx_type& a) { c += a; }
+    static void C_FIXDIV(cpx_type&, int) {} // NO-OP for float types
+    static scalar_type S_MUL(const scalar_type& a, const scalar_type& b) { return a*b; }
+    static scalar_type HALF_OF(const scalar_type& a) { return a*scalar_type(.5); }
+    static void C_MULBYSCALAR(cpx_type& c, const scalar_type& a) { c *= a; }
 
     static void fill_twiddles(cpx_type* dst, int nfft, bool inverse)
     {
@@ -27,6 +54,144 @@ struct traits
         for (int i = 0; i < nfft; ++i)
             dst[i] = std::exp(cpx_type(0, i*phinc));
     }
+
+    // Single twiddle exp(+-2*pi*i*k/n) evaluated in double precision so the
+    // power-of-two stage tables do not inherit the accumulated phase error of
+    // i*phinc for large k.
+    static cpx_type twiddle(int k, int n, bool inverse)
+    {
+        const double ph = (inverse?2:-2)*acos(-1.0)*k/n;
+        return cpx_type(scalar_type(std::cos(ph)), scalar_type(std::sin(ph)));
+    }
+};
+
+// Q15 fixed point: int16_t with 32768 standing for 1.0.  Products round to
+// nearest exactly like the SSSE3/AVX2 mulhrs instructions, so vector kernels
+// reproduce the scalar reference bit for bit.
+inline int q15_mul(int a, int b)
+{
+    return (a*b + 0x4000) >> 15;
+}
+
+inline std::int16_t q15_sat(int v)
+{
+    return std::int16_t(v > 32767 ? 32767 : v < -32768 ? -32768 : v);
+}
+
+// Q15 value of v in [-1, 1], rounded and clamped to +-32767.
+inline std::int16_t q15_unit(double v)
+{
+    const long q = std::lround(32768.0*v);
+    return std::int16_t(q > 32767 ? 32767 : q < -32767 ? -32767 : q);
+}
+
+// Complex Q15 product; each partial product is rounded, the sums saturate.
+inline std::complex<std::int16_t> q15_cmul(const std::complex<std::int16_t>& a,
+                                           const std::complex<std::int16_t>& b)
+{
+    return std::complex<std::int16_t>(
+        q15_sat(q15_mul(a.real(), b.real()) - q15_mul(a.imag(), b.imag())),
+        q15_sat(q15_mul(a.real(), b.imag()) + q15_mul(a.imag(), b.real())));
+}
+
+// v / 2^shift rounded to nearest (the same as mulhrs by 2^(15-shift)).
+inline std::int16_t q15_shift(int v, int shift)
+{
+    return shift ? std::int16_t((v + (1 << (shift - 1))) >> shift) : std::int16_t(v);
+}
+
+inline std::complex<std::int16_t> q15_shift(const std::complex<std::int16_t>& v, int shift)
+{
+    return std::complex<std::int16_t>(q15_shift(v.real(), shift), q15_shift(v.imag(), shift));
+}
+
+// Largest |component| of x[0..n).
+inline int q15_peak(const std::complex<std::int16_t>* x, std::size_t n)
+{
+    int peak = 0;
+    for (std::size_t i = 0; i < n; ++i) {
+        const int re = x[i].real() < 0 ? -x[i].real() : x[i].real();
+        const int im = x[i].imag() < 0 ? -x[i].imag() : x[i].imag();
+        if (re > peak) peak = re;
+        if (im > peak) peak = im;
+    }
+    return peak;
+}
+
+// Block floating point: the smallest rounding right shift of data whose
+// largest component is `peak` that keeps the next stage from overflowing.
+// A radix-2 stage without twiddles at most doubles a component; a twiddled
+// radix-4 stage grows one by at most 1 + 3*sqrt(2) < 5.25.
+inline int q15_headroom_shift(int peak, int radix)
+{
+    const int limit = radix == 2 ? 16383 : 6241;
+    int shift = 0;
+    while (shift < 3 && ((peak + ((1 << shift) >> 1)) >> shift) > limit) ++shift;
+    return shift;
+}
+
+template <>
+struct traits<std::int16_t>
+{
+    using scalar_type = std::int16_t;
+    using cpx_type = std::complex<scalar_type>;
+    // Power-of-two passes take the block floating point shift to apply to
+    // their input and return the largest |component| they wrote.
+    using radix4_fn = int (*)(cpx_type*, const cpx_type*, std::size_t,
+                              std::size_t, bool, int);
+    using radix4_batch_fn = void (*)(cpx_type*, const cpx_type*, std::size_t,
+                                     std::size_t, std::size_t, bool);
+    static constexpr bool fixed_point = true;
+
+    static void fill_twiddles(cpx_type* dst, int nfft, bool inverse)
+    {
+        for (int i = 0; i < nfft; ++i)
+            dst[i] = twiddle(i, nfft, inverse);
+    }
+
+    // Clamped to +-32767 so that no product with a twiddle can hit the
+    // -32768 * -32768 corner where mulhrs and q15_mul differ.
+    static cpx_type twiddle(int k, int n, bool inverse)
+    {
+        const double ph = (inverse?2:-2)*acos(-1.0)*k/n;
+        return cpx_type(q15_unit(std::cos(ph)), q15_unit(std::sin(ph)));
+    }
+
+    static void C_ADD(cpx_type& c, const cpx_type& a, const cpx_type& b)
+    {
+        c = cpx_type(scalar_type(a.real() + b.real()), scalar_type(a.imag() + b.imag()));
+    }
+    static void C_MUL(cpx_type& c, const cpx_type& a, const cpx_type& b) { c = q15_cmul(a, b); }
+    static void C_SUB(cpx_type& c, const cpx_type& a, const cpx_type& b)
+    {
+        c = cpx_type(scalar_type(a.real() - b.real()), scalar_type(a.imag() - b.imag()));
+    }
+    static void C_ADDTO(cpx_type& c, const cpx_type& a) { C_ADD(c, c, a); }
+    // Divide by the stage radix so a mixed-radix transform cannot overflow;
+    // the result is scaled by 1/nfft overall.
+    static void C_FIXDIV(cpx_type& c, int div)
+    {
+        c = cpx_type(S_MUL(c.real(), scalar_type(32767/div)),
+                     S_MUL(c.imag(), scalar_type(32767/div)));
+    }
+    static scalar_type S_MUL(const scalar_type& a, const scalar_type& b)
+    {
+        return scalar_type(q15_mul(a, b));
+    }
+    static scalar_type HALF_OF(const scalar_type& a) { return scalar_type(a >> 1); }
+    static void C_MULBYSCALAR(cpx_type& c, const scalar_type& a)
+    {
+        c = cpx_type(S_MUL(c.real(), a), S_MUL(c.imag(), a));
+    }
+};
+
+// Transform engines a plan can be bound to.  `pow2` is the iterative
+// radix-4/radix-2 decimation-in-time engine used for N = 2^k; `mixed_radix`
+// is the recursive KISS FFT path which supports any length.
+enum class fft_engine {
+    automatic,
+    mixed_radix,
+    pow2,
 };
 
 // Maximum supported FFT length and factorization depth. These values cover the
@@ -35,11 +200,257 @@ constexpr std::size_t KISSFFT_MAX_N = 4096;
 constexpr std::size_t KISSFFT_MAX_FACTORS = 32;
 constexpr std::size_t KISSFFT_MAX_FFT_RADIX = 32;
 
+inline bool is_pow2(int n) { return n > 0 && (n & (n - 1)) == 0; }
+
+inline int ilog2(int n)
+{
+    int l = 0;
+    while ((1 << l) < n) ++l;
+    return l;
+}
+
+// Complex multiply without the C99 Annex G NaN/Inf recovery that
+// std::complex<float>::operator* pulls in (a libcall per product at -O2).
+template <typename T>
+inline std::complex<T> cmul(const std::complex<T>& a, const std::complex<T>& b)
+{
+    return std::complex<T>(a.real()*b.real() - a.imag()*b.imag(),
+                           a.real()*b.imag() + a.imag()*b.real());
+}
+
+// Multiply by -j (forward) or +j (inverse).
+template <typename T>
+inline std::complex<T> rot90(const std::complex<T>& a, bool inverse)
+{
+    return inverse ? std::complex<T>(-a.imag(), a.real())
+                   : std::complex<T>(a.imag(), -a.real());
+}
+
+// One radix-2^2 decimation-in-time pass over a bit-reversed buffer of
+// length n.  Each group of 4*m outputs is built from four length-m sub-DFTs
+// stored in bit-reversed order (residues 0, 2, 1, 3).  `tw` holds the stage
+// table: m twiddles W_{4m}^k followed by m twiddles W_{4m}^{2k}.
+template <typename T>
+inline void pow2_radix4_pass(std::complex<T>* x, const std::complex<T>* tw,
+                             std::size_t m, std::size_t n, bool inverse)
+{
+    const std::complex<T>* w1 = tw;
+    const std::complex<T>* w2 = tw + m;
+    for (std::size_t j = 0; j < n; j += 4*m) {
+        std::complex<T>* b0 = x + j;
+        std::complex<T>* b1 = b0 + m;
+        std::complex<T>* b2 = b1 + m;
+        std::complex<T>* b3 = b2 + m;
+        for (std::size_t k = 0; k < m; ++k) {
+            const std::complex<T> t1 = cmul(b1[k], w2[k]);
+            const std::complex<T> t3 = cmul(b3[k], w2[k]);
+            const std::complex<T> e0 = b0[k] + t1;
+            const std::complex<T> e0m = b0[k] - t1;
+            const std::complex<T> u = cmul(b2[k] + t3, w1[k]);
+            const std::complex<T> v = rot90(cmul(b2[k] - t3, w1[k]), inverse);
+            b0[k] = e0 + u;
+            b2[k] = e0 - u;
+            b1[k] = e0m + v;
+            b3[k] = e0m - v;
+        }
+    }
+}
+
+// Batched pow2_radix4_pass over `count` transforms stored interleaved: point
+// i of transform b lives at x[i*count + b].  Every butterfly row is then
+// `count` contiguous values sharing one twiddle, so the inner loop runs
+// across transforms rather than within one.
+template <typename T>
+inline void pow2_radix4_pass_batch(std::complex<T>* x, const std::complex<T>* tw,
+                                   std::size_t m, std::size_t n, std::size_t count,
+                                   bool inverse)
+{
+    for (std::size_t j = 0; j < n; j += 4*m) {
+        for (std::size_t k = 0; k < m; ++k) {
+            const std::complex<T> w1 = tw[k];
+            const std::complex<T> w2 = tw[m + k];
+            std::complex<T>* b0 = x + (j + k)*count;
+            std::complex<T>* b1 = b0 + m*count;
+            std::complex<T>* b2 = b1 + m*count;
+            std::complex<T>* b3 = b2 + m*count;
+            for (std::size_t b = 0; b < count; ++b) {
+                const std::complex<T> t1 = cmul(b1[b], w2);
+                const std::complex<T> t3 = cmul(b3[b], w2);
+                const std::complex<T> e0 = b0[b] + t1;
+                const std::complex<T> e0m = b0[b] - t1;
+                const std::complex<T> u = cmul(b2[b] + t3, w1);
+                const std::complex<T> v = rot90(cmul(b2[b] - t3, w1), inverse);
+                b0[b] = e0 + u;
+                b2[b] = e0 - u;
+                b1[b] = e0m + v;
+                b3[b] = e0m - v;
+            }
+        }
+    }
+}
+
+#if defined(__SSE2__)
+// Two interleaved complex products {a0*b0, a1*b1}.
+inline __m128 cmul_ps(__m128 a, __m128 b)
+{
+    const __m128 sign = _mm_castsi128_ps(_mm_set_epi32(0, int(0x80000000u), 0, int(0x80000000u)));
+    const __m128 br = _mm_shuffle_ps(b, b, _MM_SHUFFLE(2, 2, 0, 0));
+    const __m128 bi = _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 3, 1, 1));
+    const __m128 as = _mm_shuffle_ps(a, a, _MM_SHUFFLE(2, 3, 0, 1));
+    return _mm_add_ps(_mm_mul_ps(a, br), _mm_xor_ps(_mm_mul_ps(as, bi), sign));
+}
+
+// Multiply two packed complex values by -j (forward) or +j (inverse).
+inline __m128 rot90_ps(__m128 a, bool inverse)
+{
+    const __m128 sw = _mm_shuffle_ps(a, a, _MM_SHUFFLE(2, 3, 0, 1));
+    const __m128 sign = inverse
+        ? _mm_castsi128_ps(_mm_set_epi32(0, int(0x80000000u), 0, int(0x80000000u)))
+        : _mm_castsi128_ps(_mm_set_epi32(int(0x80000000u), 0, int(0x80000000u), 0));
+    return _mm_xor_ps(sw, sign);
+}
+#endif
+
+#if defined(__AVX2__) && defined(__FMA__)
+// Four interleaved complex products.
+inline __m256 cmul_ps256(__m256 a, __m256 b)
+{
+    const __m256 br = _mm256_moveldup_ps(b);
+    const __m256 bi = _mm256_movehdup_ps(b);
+    const __m256 as = _mm256_permute_ps(a, _MM_SHUFFLE(2, 3, 0, 1));
+    return _mm256_fmaddsub_ps(a, br, _mm256_mul_ps(as, bi));
+}
+
+inline __m256 rot90_ps256(__m256 a, bool inverse)
+{
+    const __m256 sw = _mm256_permute_ps(a, _MM_SHUFFLE(2, 3, 0, 1));
+    const __m256 neg_re = _mm256_castsi256_ps(_mm256_set_epi32(
+        0, int(0x80000000u), 0, int(0x80000000u), 0, int(0x80000000u), 0, int(0x80000000u)));
+    const __m256 neg_im = _mm256_castsi256_ps(_mm256_set_epi32(
+        int(0x80000000u), 0, int(0x80000000u), 0, int(0x80000000u), 0, int(0x80000000u), 0));
+    return _mm256_xor_ps(sw, inverse ? neg_re : neg_im);
+}
+#endif
+
+#if defined(__SSE2__)
+// Vectorised float pass: AVX2 handles four butterflies per iteration when
+// the build enables it, SSE2 two, and the m == 1 first stage stays scalar.
+inline void pow2_radix4_pass(std::complex<float>* x, const std::complex<float>* tw,
+                             std::size_t m, std::size_t n, bool inverse)
+{
+    if (m < 2) {
+        pow2_radix4_pass<float>(x, tw, m, n, inverse);
+        return;
+    }
+    float* xf = reinterpret_cast<float*>(x);
+    const float* w1 = reinterpret_cast<const float*>(tw);
+    const float* w2 = reinterpret_cast<const float*>(tw + m);
+    for (std::size_t j = 0; j < n; j += 4*m) {
+        float* b0 = xf + 2*j;
+        float* b1 = b0 + 2*m;
+        float* b2 = b1 + 2*m;
+        float* b3 = b2 + 2*m;
+        std::size_t k = 0;
+#if defined(__AVX2__) && defined(__FMA__)
+        for (; k + 4 <= m; k += 4) {
+            const __m256 vw1 = _mm256_loadu_ps(w1 + 2*k);
+            const __m256 vw2 = _mm256_loadu_ps(w2 + 2*k);
+            const __m256 a0 = _mm256_loadu_ps(b0 + 2*k);
+            const __m256 t1 = cmul_ps256(_mm256_loadu_ps(b1 + 2*k), vw2);
+            const __m256 a2 = _mm256_loadu_ps(b2 + 2*k);
+            const __m256 t3 = cmul_ps256(_mm256_loadu_ps(b3 + 2*k), vw2);
+            const __m256 e0 = _mm256_add_ps(a0, t1);
+            const __m256 e0m = _mm256_sub_ps(a0, t1);
+            const __m256 u = cmul_ps256(_mm256_add_ps(a2, t3), vw1);
+            const __m256 v = rot90_ps256(cmul_ps256(_mm256_sub_ps(a2, t3), vw1), inverse);
+            _mm256_storeu_ps(b0 + 2*k, _mm256_add_ps(e0, u));
+            _mm256_storeu_ps(b2 + 2*k, _mm256_sub_ps(e0, u));
+            _mm256_storeu_ps(b1 + 2*k, _mm256_add_ps(e0m, v));
+            _mm256_storeu_ps(b3 + 2*k, _mm256_sub_ps(e0m, v));
+        }
+#endif
+        for (; k < m; k += 2) {
+            const __m128 vw1 = _mm_loadu_ps(w1 + 2*k);
+            const __m128 vw2 = _mm_loadu_ps(w2 + 2*k);
+            const __m128 a0 = _mm_loadu_ps(b0 + 2*k);
+            const __m128 t1 = cmul_ps(_mm_loadu_ps(b1 + 2*k), vw2);
+            const __m128 a2 = _mm_loadu_ps(b2 + 2*k);
+            const __m128 t3 = cmul_ps(_mm_loadu_ps(b3 + 2*k), vw2);
+            const __m128 e0 = _mm_add_ps(a0, t1);
+            const __m128 e0m = _mm_sub_ps(a0, t1);
+            const __m128 u = cmul_ps(_mm_add_ps(a2, t3), vw1);
+            const __m128 v = rot90_ps(cmul_ps(_mm_sub_ps(a2, t3), vw1), inverse);
+            _mm_storeu_ps(b0 + 2*k, _mm_add_ps(e0, u));
+            _mm_storeu_ps(b2 + 2*k, _mm_sub_ps(e0, u));
+            _mm_storeu_ps(b1 + 2*k, _mm_add_ps(e0m, v));
+            _mm_storeu_ps(b3 + 2*k, _mm_sub_ps(e0m, v));
+        }
+    }
+}
+#endif
+
+// Q15 radix-2 stage (first stage of odd-log2 lengths, no twiddles) over
+// input shifted right by `shift`; returns the largest |component| written.
+inline int pow2_radix2_pass_q15(std::complex<std::int16_t>* x, std::size_t n, int shift)
+{
+    for (std::size_t j = 0; j < n; j += 2) {
+        const std::complex<std::int16_t> a = q15_shift(x[j], shift);
+        const std::complex<std::int16_t> b = q15_shift(x[j+1], shift);
+        x[j] = std::complex<std::int16_t>(std::int16_t(a.real() + b.real()),
+                                          std::int16_t(a.imag() + b.imag()));
+        x[j+1] = std::complex<std::int16_t>(std::int16_t(a.real() - b.real()),
+                                            std::int16_t(a.imag() - b.imag()));
+    }
+    return q15_peak(x, n);
+}
+
+// Q15 pow2_radix4_pass: the four inputs of every butterfly are first
+// shifted right by `shift` (see q15_headroom_shift), after which no
+// intermediate can overflow.  Returns the largest |component| written.
+inline int pow2_radix4_pass_q15(std::complex<std::int16_t>* x,
+                                const std::complex<std::int16_t>* tw,
+                                std::size_t m, std::size_t n, bool inverse, int shift)
+{
+    using cpx = std::complex<std::int16_t>;
+    auto add = [](const cpx& a, const cpx& b) {
+        return cpx(std::int16_t(a.real() + b.real()), std::int16_t(a.imag() + b.imag()));
+    };
+    auto sub = [](const cpx& a, const cpx& b) {
+        return cpx(std::int16_t(a.real() - b.real()), std::int16_t(a.imag() - b.imag()));
+    };
+    const cpx* w1 = tw;
+    const cpx* w2 = tw + m;
+    for (std::size_t j = 0; j < n; j += 4*m) {
+        cpx* b0 = x + j;
+        cpx* b1 = b0 + m;
+        cpx* b2 = b1 + m;
+        cpx* b3 = b2 + m;
+        for (std::size_t k = 0; k < m; ++k) {
+            const cpx a0 = q15_shift(b0[k], shift);
+            const cpx t1 = q15_cmul(q15_shift(b1[k], shift), w2[k]);
+            const cpx a2 = q15_shift(b2[k], shift);
+            const cpx t3 = q15_cmul(q15_shift(b3[k], shift), w2[k]);
+            const cpx e0 = add(a0, t1);
+            const cpx e0m = sub(a0, t1);
+            const cpx u = q15_cmul(add(a2, t3), w1[k]);
+            const cpx v = rot90(q15_cmul(sub(a2, t3), w1[k]), inverse);
+            b0[k] = add(e0, u);
+            b2[k] = sub(e0, u);
+            b1[k] = add(e0m, v);
+            b3[k] = sub(e0m, v);
+        }
+    }
+    return q15_peak(x, n);
+}
+
 } // namespace kissfft_utils
 
-// Plan structure holding all preallocated buffers required by the FFT. The
-// arrays are statically sized to avoid any dynamic memory allocation at run
-// time. A plan must be initialised with `kissfft::init` before use.
+// Plan descriptor: transform parameters plus pointers to the twiddle and
+// bit-reversal tables.  The tables are only read by `transform`, so a single
+// initialised plan may back any number of kissfft instances on any number of
+// threads.  Storage for the tables is supplied to `kissfft::init`, either by a
+// kissfft_embedded_plan or by a shared registry such as lora_phy's
+// shared_fft_plan().
 template <typename T_scalar>
 struct kissfft_plan
 {
@@ -49,9 +460,29 @@ struct kissfft_plan
     int nfft{};                           // FFT length
     bool inverse{};                       // true for inverse transform
     int stages{};                         // number of factorization stages
-    cpx_type twiddles[kissfft_utils::KISSFFT_MAX_N];
-    int stageRadix[kissfft_utils::KISSFFT_MAX_FACTORS];
-    int stageRemainder[kissfft_utils::KISSFFT_MAX_FACTORS];
+    kissfft_utils::fft_engine engine{kissfft_utils::fft_engine::mixed_radix};
+    int log2n{};                          // log2(nfft) for pow2 plans
+    // mixed_radix: exp(-+2*pi*i*k/nfft); pow2: per-stage packed tables
+    const cpx_type* twiddles{};
+    const unsigned short* bitrev{};       // pow2 input permutation
+    int stageRadix[kissfft_utils::KISSFFT_MAX_FACTORS]{};
+    int stageRemainder[kissfft_utils::KISSFFT_MAX_FACTORS]{};
+};
+
+// Plan carrying its own statically sized tables (KISSFFT_MAX_N entries each)
+// for builds that must not depend on process-wide state.  The descriptor
+// points into the object itself, so it is not copyable.
+template <typename T_scalar>
+struct kissfft_embedded_plan : kissfft_plan<T_scalar>
+{
+    using cpx_type = typename kissfft_plan<T_scalar>::cpx_type;
+
+    kissfft_embedded_plan() = default;
+    kissfft_embedded_plan(const kissfft_embedded_plan&) = delete;
+    kissfft_embedded_plan& operator=(const kissfft_embedded_plan&) = delete;
+
+    cpx_type twiddle_storage[kissfft_utils::KISSFFT_MAX_N];
+    unsigned short bitrev_storage[kissfft_utils::KISSFFT_MAX_N];
 };
 
 template <typename T_Scalar,
@@ -64,23 +495,63 @@ public:
     using scalar_type = typename traits_type::scalar_type;
     using cpx_type = std::complex<scalar_type>;
     using plan_type = kissfft_plan<T_Scalar>;
+    // Optional replacement for kissfft_utils::pow2_radix4_pass (or
+    // pow2_radix4_pass_q15 for fixed point traits), e.g. a runtime selected
+    // SIMD kernel.  nullptr keeps the built-in pass.
+    using radix4_fn = typename traits_type::radix4_fn;
+
+    // Optional replacement for kissfft_utils::pow2_radix4_pass_batch.
+    using radix4_batch_fn = typename traits_type::radix4_batch_fn;
+
+    explicit kissfft(const plan_type& plan, radix4_fn radix4 = nullptr,
+                     radix4_batch_fn radix4_batch = nullptr)
+        : _p(plan), _radix4(radix4), _radix4_batch(radix4_batch) {}
+
+    static void init(kissfft_embedded_plan<T_Scalar>& plan, int nfft, bool inverse,
+                     const traits_type& traits = traits_type())
+    {
+        init(plan, nfft, inverse, kissfft_utils::fft_engine::automatic, traits);
+    }
 
-    explicit kissfft(plan_type& plan)
-        : _p(plan) {}
+    // Select the engine explicitly.  `automatic` binds power-of-two lengths
+    // to the iterative engine and everything else to the mixed-radix path.
+    static void init(kissfft_embedded_plan<T_Scalar>& plan, int nfft, bool inverse,
+                     kissfft_utils::fft_engine engine,
+                     const traits_type& traits = traits_type())
+    {
+        init(plan, nfft, inverse, plan.twiddle_storage, plan.bitrev_storage,
+             engine, traits);
+    }
 
+    // Build @p plan over caller storage: @p twiddles and @p bitrev must each
+    // hold at least nfft entries and outlive the plan.  The bit-reversal table
+    // is only written for pow2 plans.
     static void init(plan_type& plan, int nfft, bool inverse,
+                     cpx_type* twiddles, unsigned short* bitrev,
+                     kissfft_utils::fft_engine engine = kissfft_utils::fft_engine::automatic,
                      const traits_type& traits = traits_type())
     {
-        plan.nfft = nfft;
-        plan.inverse = inverse;
+        using kissfft_utils::fft_engine;
+        if (engine == fft_engine::automatic)
+            engine = kissfft_utils::is_pow2(nfft) ? fft_engine::pow2
+                                                  : fft_engine::mixed_radix;
+        if (engine == fft_engine::pow2 && kissfft_utils::is_pow2(nfft)) {
+            init_pow2(plan, nfft, inverse, twiddles, bitrev, traits);
+            return;
+        }
 
-        // Generate twiddle factors
-        traits.fill_twiddles(plan.twiddles, nfft, inverse);
+        int radix[kissfft_utils::KISSFFT_MAX_FACTORS];
+        const int stages = factorize(nfft, radix);
+        init_factors(plan, nfft, inverse, twiddles, radix, stages, traits);
+    }
 
-        // Factorize nfft and store in plan
+    // Default mixed-radix factorization: radix 4 first, then 2, 3, 5, ...
+    // Writes the radices in execution order and returns their count.
+    static int factorize(int nfft, int* radix)
+    {
         int n = nfft;
         int p = 4;
-        plan.stages = 0;
+        int stages = 0;
         do {
             while (n % p) {
                 switch (p) {
@@ -91,18 +562,266 @@ public:
                 if (p*p > n) p = n; // no more factors
             }
             n /= p;
-            plan.stageRadix[plan.stages] = p;
-            plan.stageRemainder[plan.stages] = n;
-            ++plan.stages;
+            radix[stages++] = p;
         } while (n > 1);
+        return stages;
     }
 
+    // Mixed-radix plan over caller storage using radix[0..stages) in
+    // execution order.  Returns false, leaving @p plan untouched, when the
+    // radices do not multiply to nfft or one exceeds KISSFFT_MAX_FFT_RADIX.
+    static bool init_factors(plan_type& plan, int nfft, bool inverse,
+                             cpx_type* twiddles, const int* radix, int stages,
+                             const traits_type& traits = traits_type())
+    {
+        if (nfft < 1 || stages < 1 ||
+            std::size_t(stages) > kissfft_utils::KISSFFT_MAX_FACTORS)
+            return false;
+        int n = nfft;
+        for (int s = 0; s < stages; ++s) {
+            const int p = radix[s];
+            if (p < 1 || std::size_t(p) > kissfft_utils::KISSFFT_MAX_FFT_RADIX ||
+                n % p != 0 || (p == 1 && nfft != 1))
+                return false;
+            n /= p;
+        }
+        if (n != 1) return false;
+
+        plan.nfft = nfft;
+        plan.inverse = inverse;
+        plan.engine = kissfft_utils::fft_engine::mixed_radix;
+        plan.log2n = 0;
+        plan.twiddles = twiddles;
+        plan.bitrev = nullptr;
+
+        // Generate twiddle factors
+        traits.fill_twiddles(twiddles, nfft, inverse);
+
+        n = nfft;
+        plan.stages = stages;
+        for (int s = 0; s < stages; ++s) {
+            n /= radix[s];
+            plan.stageRadix[s] = radix[s];
+            plan.stageRemainder[s] = n;
+        }
+        return true;
+    }
+
+    // src may equal dst, see transform_inplace().
     void transform(const cpx_type* src, cpx_type* dst) const
     {
+        transform_scaled(src, dst);
+    }
+
+    // transform() reporting the block exponent e: dst holds DFT(src) / 2^e.
+    // Floating point plans never scale and return 0.  Fixed point (Q15)
+    // pow2 plans use block floating point: before every stage the data is
+    // shifted right just far enough that the stage cannot overflow, so weak
+    // signals keep their resolution.  Fixed point mixed-radix plans divide
+    // by the radix at every stage through C_FIXDIV, 1/nfft overall, and
+    // report ilog2(nfft), which is exact for power-of-two lengths.
+    int transform_scaled(const cpx_type* src, cpx_type* dst) const
+    {
+        if (src == dst)
+            return transform_inplace(dst);
+        if (_p.engine == kissfft_utils::fft_engine::pow2)
+            return kf_pow2(src, dst);
         kf_work(0, dst, src, 1, 1);
+        return traits_type::fixed_point ? kissfft_utils::ilog2(_p.nfft) : 0;
+    }
+
+    // Transform x into itself, returning the block exponent as
+    // transform_scaled() does.  pow2 plans permute by swapping in place and
+    // touch no other memory; mixed-radix plans copy the input to a stack
+    // buffer of KISSFFT_MAX_N points first.
+    int transform_inplace(cpx_type* x) const
+    {
+        if (_p.engine == kissfft_utils::fft_engine::pow2) {
+            const unsigned short* rev = _p.bitrev;
+            for (int i = 0; i < _p.nfft; ++i) {
+                const int r = rev[i];
+                if (i < r) std::swap(x[i], x[r]);
+            }
+            return kf_pow2_stages(x);
+        }
+        cpx_type tmp[kissfft_utils::KISSFFT_MAX_N];
+        for (int i = 0; i < _p.nfft; ++i) tmp[i] = x[i];
+        kf_work(0, x, tmp, 1, 1);
+        return traits_type::fixed_point ? kissfft_utils::ilog2(_p.nfft) : 0;
+    }
+
+    // Transform `count` inputs stored interleaved: sample i of input b is
+    // src[i*count + b], and bin i of its spectrum is written to
+    // dst[i*count + b].  pow2 plans run each butterfly across all inputs at
+    // once; mixed-radix plans transform one input at a time through a stack
+    // buffer of KISSFFT_MAX_N points.  src may equal dst.
+    void transform_batch(const cpx_type* src, cpx_type* dst, std::size_t count) const
+    {
+        static_assert(!traits_type::fixed_point,
+                      "batched transforms would lose the per-input block exponent");
+        if (count == 1) {
+            transform(src, dst);
+            return;
+        }
+        if (_p.engine == kissfft_utils::fft_engine::pow2) {
+            kf_pow2_batch(src, dst, count);
+            return;
+        }
+        // Each column is read completely into col before it is written
+        // back, so this also works in place.
+        cpx_type col[kissfft_utils::KISSFFT_MAX_N];
+        for (std::size_t b = 0; b < count; ++b) {
+            kf_work(0, col, src + b, 1, count);
+            for (int i = 0; i < _p.nfft; ++i)
+                dst[size_t(i)*count + b] = col[i];
+        }
     }
 
 private:
+    // Power-of-two plan: bit-reversal table plus one radix-2 stage when
+    // log2(nfft) is odd followed by radix-4 stages.  stageRadix/Remainder
+    // record (radix, sub-DFT length m) per stage in execution order and the
+    // twiddle array is packed stage by stage as described for
+    // kissfft_utils::pow2_radix4_pass.
+    static void init_pow2(plan_type& plan, int nfft, bool inverse,
+                          cpx_type* twiddles, unsigned short* bitrev,
+                          const traits_type& traits)
+    {
+        plan.nfft = nfft;
+        plan.inverse = inverse;
+        plan.engine = kissfft_utils::fft_engine::pow2;
+        plan.log2n = kissfft_utils::ilog2(nfft);
+        plan.twiddles = twiddles;
+        plan.bitrev = bitrev;
+        for (int i = 0; i < nfft; ++i) {
+            unsigned r = 0;
+            for (int b = 0; b < plan.log2n; ++b)
+                r |= ((unsigned(i) >> b) & 1u) << (plan.log2n - 1 - b);
+            bitrev[i] = static_cast<unsigned short>(r);
+        }
+        plan.stages = 0;
+        int m = 1;
+        if (plan.log2n & 1) {
+            plan.stageRadix[plan.stages] = 2;
+            plan.stageRemainder[plan.stages] = 1;
+            ++plan.stages;
+            m = 2;
+        }
+        cpx_type* tw = twiddles;
+        for (; 4*m <= nfft; m *= 4) {
+            for (int k = 0; k < m; ++k) {
+                tw[k] = traits.twiddle(k, 4*m, inverse);
+                tw[m + k] = traits.twiddle(2*k, 4*m, inverse);
+            }
+            tw += 2*m;
+            plan.stageRadix[plan.stages] = 4;
+            plan.stageRemainder[plan.stages] = m;
+            ++plan.stages;
+        }
+    }
+
+    int kf_pow2(const cpx_type* src, cpx_type* dst) const
+    {
+        const int n = _p.nfft;
+        const unsigned short* rev = _p.bitrev;
+        for (int i = 0; i < n; ++i)
+            dst[i] = src[rev[i]];
+        return kf_pow2_stages(dst);
+    }
+
+    // Butterfly stages over bit-reversed input in dst; returns the block
+    // exponent (always 0 for floating point).
+    int kf_pow2_stages(cpx_type* dst) const
+    {
+        const int n = _p.nfft;
+        const cpx_type* tw = _p.twiddles;
+        if constexpr (traits_type::fixed_point) {
+            int peak = kissfft_utils::q15_peak(dst, size_t(n));
+            int exponent = 0;
+            for (int s = 0; s < _p.stages; ++s) {
+                const int m = _p.stageRemainder[s];
+                const int shift = kissfft_utils::q15_headroom_shift(peak, _p.stageRadix[s]);
+                exponent += shift;
+                if (_p.stageRadix[s] == 2) {
+                    peak = kissfft_utils::pow2_radix2_pass_q15(dst, size_t(n), shift);
+                } else {
+                    if (_radix4)
+                        peak = _radix4(dst, tw, size_t(m), size_t(n), _p.inverse, shift);
+                    else
+                        peak = kissfft_utils::pow2_radix4_pass_q15(dst, tw, size_t(m), size_t(n),
+                                                                   _p.inverse, shift);
+                    tw += 2*m;
+                }
+            }
+            return exponent;
+        } else {
+            for (int s = 0; s < _p.stages; ++s) {
+                const int m = _p.stageRemainder[s];
+                if (_p.stageRadix[s] == 2) {
+                    for (int j = 0; j < n; j += 2) {
+                        const cpx_type a = dst[j];
+                        const cpx_type b = dst[j+1];
+                        dst[j] = a + b;
+                        dst[j+1] = a - b;
+                    }
+                } else {
+                    if (_radix4)
+                        _radix4(dst, tw, size_t(m), size_t(n), _p.inverse);
+                    else
+                        kissfft_utils::pow2_radix4_pass(dst, tw, size_t(m), size_t(n), _p.inverse);
+                    tw += 2*m;
+                }
+            }
+            return 0;
+        }
+    }
+
+    void kf_pow2_batch(const cpx_type* src, cpx_type* dst, std::size_t count) const
+    {
+        const int n = _p.nfft;
+        const unsigned short* rev = _p.bitrev;
+        if (src == dst) {
+            // Bit reversal is an involution: swap each pair of rows once.
+            for (int i = 0; i < n; ++i) {
+                const int r = rev[i];
+                if (i >= r) continue;
+                cpx_type* a = dst + size_t(i)*count;
+                cpx_type* c = dst + size_t(r)*count;
+                for (std::size_t b = 0; b < count; ++b)
+                    std::swap(a[b], c[b]);
+            }
+        } else {
+            for (int i = 0; i < n; ++i) {
+                const cpx_type* from = src + size_t(rev[i])*count;
+                cpx_type* to = dst + size_t(i)*count;
+                for (std::size_t b = 0; b < count; ++b)
+                    to[b] = from[b];
+            }
+        }
+        const cpx_type* tw = _p.twiddles;
+        for (int s = 0; s < _p.stages; ++s) {
+            const int m = _p.stageRemainder[s];
+            if (_p.stageRadix[s] == 2) {
+                for (int j = 0; j < n; j += 2) {
+                    cpx_type* r0 = dst + size_t(j)*count;
+                    cpx_type* r1 = r0 + count;
+                    for (std::size_t b = 0; b < count; ++b) {
+                        const cpx_type a = r0[b];
+                        r0[b] = a + r1[b];
+                        r1[b] = a - r1[b];
+                    }
+                }
+            } else {
+                if (_radix4_batch)
+                    _radix4_batch(dst, tw, size_t(m), size_t(n), count, _p.inverse);
+                else
+                    kissfft_utils::pow2_radix4_pass_batch(dst, tw, size_t(m), size_t(n),
+                                                          count, _p.inverse);
+                tw += 2*m;
+            }
+        }
+    }
+
     void kf_work(int stage, cpx_type* Fout, const cpx_type* f,
                  size_t fstride, size_t in_stride) const
     {
@@ -143,21 +862,23 @@ private:
     }
 
     // these were #define macros in the original kiss_fft
-    static void C_ADD(cpx_type& c, const cpx_type& a, const cpx_type& b) { c = a + b; }
-    static void C_MUL(cpx_type& c, const cpx_type& a, const cpx_type& b) { c = a * b; }
-    static void C_SUB(cpx_type& c, const cpx_type& a, const cpx_type& b) { c = a - b; }
-    static void C_ADDTO(cpx_type& c, const cpx_type& a) { c += a; }
-    static void C_FIXDIV(cpx_type&, int) {} // NO-OP for float types
-    static scalar_type S_MUL(const scalar_type& a, const scalar_type& b) { return a*b; }
-    static scalar_type HALF_OF(const scalar_type& a) { return a*scalar_type(.5); }
-    static void C_MULBYSCALAR(cpx_type& c, const scalar_type& a) { c *= a; }
+    static void C_ADD(cpx_type& c, const cpx_type& a, const cpx_type& b) { traits_type::C_ADD(c, a, b); }
+    static void C_MUL(cpx_type& c, const cpx_type& a, const cpx_type& b) { traits_type::C_MUL(c, a, b); }
+    static void C_SUB(cpx_type& c, const cpx_type& a, const cpx_type& b) { traits_type::C_SUB(c, a, b); }
+    static void C_ADDTO(cpx_type& c, const cpx_type& a) { traits_type::C_ADDTO(c, a); }
+    static void C_FIXDIV(cpx_type& c, int div) { traits_type::C_FIXDIV(c, div); }
+    static scalar_type S_MUL(const scalar_type& a, const scalar_type& b) { return traits_type::S_MUL(a, b); }
+    static scalar_type HALF_OF(const scalar_type& a) { return traits_type::HALF_OF(a); }
+    static void C_MULBYSCALAR(cpx_type& c, const scalar_type& a) { traits_type::C_MULBYSCALAR(c, a); }
 
     void kf_bfly2(cpx_type* Fout, const size_t fstride, int m) const
     {
         for (int k = 0; k < m; ++k) {
-            cpx_type t = Fout[m+k] * _p.twiddles[k*fstride];
-            Fout[m+k] = Fout[k] - t;
-            Fout[k] += t;
+            C_FIXDIV(Fout[k],2); C_FIXDIV(Fout[m+k],2);
+            cpx_type t;
+            C_MUL(t, Fout[m+k], _p.twiddles[k*fstride]);
+            C_SUB(Fout[m+k], Fout[k], t);
+            C_ADDTO(Fout[k], t);
         }
     }
 
@@ -166,21 +887,23 @@ private:
         cpx_type scratch[7];
         int negative_if_inverse = _p.inverse * -2 + 1;
         for (size_t k = 0; k < m; ++k) {
-            scratch[0] = Fout[k+m] * _p.twiddles[k*fstride];
-            scratch[1] = Fout[k+2*m] * _p.twiddles[k*fstride*2];
-            scratch[2] = Fout[k+3*m] * _p.twiddles[k*fstride*3];
-            scratch[5] = Fout[k] - scratch[1];
-
-            Fout[k] += scratch[1];
-            scratch[3] = scratch[0] + scratch[2];
-            scratch[4] = scratch[0] - scratch[2];
+            C_FIXDIV(Fout[k],4); C_FIXDIV(Fout[k+m],4);
+            C_FIXDIV(Fout[k+2*m],4); C_FIXDIV(Fout[k+3*m],4);
+            C_MUL(scratch[0], Fout[k+m], _p.twiddles[k*fstride]);
+            C_MUL(scratch[1], Fout[k+2*m], _p.twiddles[k*fstride*2]);
+            C_MUL(scratch[2], Fout[k+3*m], _p.twiddles[k*fstride*3]);
+            C_SUB(scratch[5], Fout[k], scratch[1]);
+
+            C_ADDTO(Fout[k], scratch[1]);
+            C_ADD(scratch[3], scratch[0], scratch[2]);
+            C_SUB(scratch[4], scratch[0], scratch[2]);
             scratch[4] = cpx_type(scratch[4].imag()*negative_if_inverse,
                                  -scratch[4].real()*negative_if_inverse);
 
-            Fout[k+2*m] = Fout[k] - scratch[3];
-            Fout[k] += scratch[3];
-            Fout[k+m] = scratch[5] + scratch[4];
-            Fout[k+3*m] = scratch[5] - scratch[4];
+            C_SUB(Fout[k+2*m], Fout[k], scratch[3]);
+            C_ADDTO(Fout[k], scratch[3]);
+            C_ADD(Fout[k+m], scratch[5], scratch[4]);
+            C_SUB(Fout[k+3*m], scratch[5], scratch[4]);
         }
     }
 
@@ -188,7 +911,7 @@ private:
     {
         size_t k = m;
         const size_t m2 = 2*m;
-        cpx_type *tw1, *tw2;
+        const cpx_type *tw1, *tw2;
         cpx_type scratch[5];
         cpx_type epi3;
         epi3 = _p.twiddles[fstride*m];
@@ -226,8 +949,8 @@ private:
         cpx_type *Fout0, *Fout1, *Fout2, *Fout3, *Fout4;
         size_t u;
         cpx_type scratch[13];
-        cpx_type* twiddles = &_p.twiddles[0];
-        cpx_type *tw;
+        const cpx_type* twiddles = &_p.twiddles[0];
+        const cpx_type *tw;
         cpx_type ya, yb;
         ya = twiddles[fstride*m];
         yb = twiddles[fstride*2*m];
@@ -287,7 +1010,7 @@ private:
     void kf_bfly_generic(cpx_type* Fout, const size_t fstride, int m, int p) const
     {
         int u, k, q1, q;
-        cpx_type* twiddles = &_p.twiddles[0];
+        const cpx_type* twiddles = &_p.twiddles[0];
         cpx_type t;
         int Norig = _p.nfft;
         cpx_type scratchbuf[kissfft_utils::KISSFFT_MAX_FFT_RADIX];
@@ -315,6 +1038,8 @@ private:
         }
     }
 
-    plan_type& _p;
+    const plan_type& _p;
+    radix4_fn _radix4;
+    radix4_batch_fn _radix4_batch;
 };
 #endif
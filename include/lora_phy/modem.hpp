@@ -0,0 +1,180 @@
+/**
+ * @file modem.hpp
+ * Modem specialised at compile time for one spreading factor and
+ * oversampling ratio, layered on the high level API.
+ *
+ * modem<SF, OSR> knows N, the symbol step and the sync word shift as
+ * constants.  It owns its buffers: FFT input and output of exactly N
+ * entries, the chirp table and the dechirp reference
+ * (lora_workspace::dechirp).  Its per-symbol loops therefore have fixed
+ * trip counts and strides.  The FFT runs on the workspace's forward plan
+ * bound by init(): the shared registry plan, or with
+ * LORA_PHY_EMBEDDED_PLANS the workspace's own KISSFFT_MAX_N plan storage.
+ * Decisions and offset estimates are those of demodulate() on a workspace
+ * with the same configuration.  The modem always detects at the FFT argmax
+ * (metrics_level::none).  Per-symbol metrics, quality, soft bits and batched
+ * transforms remain with the generic API, on workspace().
+ *
+ * find_modem() is the runtime switch.  It maps a lora_params to the
+ * modem_ops table of the matching specialisation: SF 5 to 12, OSR 1, 2, 4
+ * or 8.  The caller provides ops->size bytes of storage (ops->align
+ * aligned) and runs ops->init() on it.
+ */
+#pragma once
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <complex>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <sys/types.h>
+
+#include <lora_phy/demod_common.hpp>
+#include <lora_phy/nco.hpp>
+#include <lora_phy/phy.hpp>
+
+namespace lora_phy {
+
+template <unsigned SF, unsigned OSR>
+class modem {
+    static_assert(SF <= 12, "N = 2^SF must fit KISSFFT_MAX_N");
+    static_assert(OSR >= 1, "oversampling ratio must be at least 1");
+
+public:
+    static constexpr std::size_t N = std::size_t(1) << SF;
+    static constexpr std::size_t STEP = N * OSR;
+    static constexpr unsigned SYNC_SHIFT = SF > 4 ? SF - 4 : 0;
+
+    modem() = default;
+    modem(const modem&) = delete;
+    modem& operator=(const modem&) = delete;
+
+    /** Configure for @p cfg, whose sf and osr must be SF and OSR.  Returns
+     * 0, -EINVAL or the error of init() on the internal workspace. */
+    int init(const lora_params* cfg)
+    {
+        if (!cfg || cfg->sf != SF || (cfg->osr ? cfg->osr : 1u) != OSR) return -EINVAL;
+        ws_.fft_in = fft_in_;
+        ws_.fft_out = fft_out_;
+        ws_.window = window_;
+        ws_.chirp_buf = chirp_;
+        ws_.dechirp = down_;
+        return lora_phy::init(&ws_, cfg);
+    }
+
+    /** modulate() on the internal workspace: the sync word and symbols from
+     * the chirp table, (symbol_count + 2) * STEP samples. */
+    ssize_t modulate(const uint16_t* symbols, std::size_t symbol_count,
+                     std::complex<float>* iq, std::size_t iq_cap)
+    {
+        if (!symbols || !iq) return -EINVAL;
+        if ((symbol_count + 2) * STEP > iq_cap) return -ERANGE;
+        return static_cast<ssize_t>(lora_modulate_table(&ws_.chirp, symbols, symbol_count, iq,
+                                                        1.0f, ws_.sync_word, ws_.kernels));
+    }
+
+    /** demodulate() on the internal workspace, with the same return codes;
+     * the received sync word and offset estimates land in metrics() and
+     * workspace(). */
+    ssize_t demodulate(const std::complex<float>* iq, std::size_t sample_count,
+                       uint16_t* symbols, std::size_t symbol_cap)
+    {
+        if (!iq || !symbols) return -EINVAL;
+        if (sample_count % STEP != 0) return -EINVAL;
+        const std::size_t total = sample_count / STEP;
+        if (total < 2) return -ERANGE;
+        if (total - 2 > symbol_cap) return -ERANGE;
+
+        estimate_offsets(&ws_, iq, std::min(sample_count, 2 * STEP));
+        const dsp_kernels* k = ws_.kernels;
+        kissfft<float> fft(*ws_.plan_fwd, k->fft_radix4);
+        LoRaDetector<float> detector(N, fft_in_, fft_out_, fft, k->mag2_argmax,
+                                     metrics_level::none);
+        const int t_off = static_cast<int>(std::round(ws_.metrics.time_offset));
+        const double rate = -2.0 * PI_D * ws_.metrics.cfo / static_cast<double>(N);
+        nco osc(k, rate);
+        uint16_t sw[2] = {};
+        for (std::size_t s = 0; s < total; ++s) {
+            const std::size_t base = detail::symbol_base(s, STEP, t_off, sample_count);
+            // Derotation, dechirp and window in one pass; a zero rate
+            // rotates by exactly one and needs only the dechirp multiply.
+            if (rate != 0.0) {
+                osc.seek(rate * (static_cast<double>(s * N) +
+                                 static_cast<double>(t_off) / static_cast<double>(OSR)));
+                osc.dechirp(fft_in_, iq + base, OSR, down_, N);
+            } else {
+                k->cmul(fft_in_, iq + base, OSR, down_, N);
+            }
+            float p, pav, fi;
+            const std::size_t idx = detector.detect(p, pav, fi);
+            if (s < 2)
+                sw[s] = static_cast<uint16_t>(idx);
+            else
+                symbols[s - 2] = static_cast<uint16_t>(idx);
+        }
+        detail::payload_metrics(ws_.metrics, metrics_level::none, 0.0f, 0.0f, 0);
+        ws_.sync_word = detail::pack_sync(N, sw[0], sw[1]);
+        return static_cast<ssize_t>(total - 2);
+    }
+
+    const lora_metrics* metrics() const { return &ws_.metrics; }
+
+    /** Workspace bound to the modem's buffers, for the generic API. */
+    lora_workspace* workspace() { return &ws_; }
+
+private:
+    lora_workspace ws_{};
+    std::complex<float> down_[N];  ///< windowed downchirp, ws_.dechirp
+    std::complex<float> fft_in_[N];
+    std::complex<float> fft_out_[N];
+    float window_[N];
+    std::complex<float> chirp_[STEP];
+};
+
+/**
+ * Type-erased entry points of one modem<SF, OSR>.  Every function takes the
+ * storage init() constructed the modem in.
+ */
+struct modem_ops {
+    unsigned sf;
+    unsigned osr;
+    std::size_t size;  ///< bytes of storage a modem needs
+    std::size_t align; ///< required alignment of that storage
+    int (*init)(void* storage, const lora_params* cfg);
+    ssize_t (*modulate)(void* storage, const uint16_t* symbols, std::size_t symbol_count,
+                        std::complex<float>* iq, std::size_t iq_cap);
+    ssize_t (*demodulate)(void* storage, const std::complex<float>* iq,
+                          std::size_t sample_count, uint16_t* symbols,
+                          std::size_t symbol_cap);
+    const lora_metrics* (*metrics)(const void* storage);
+    lora_workspace* (*workspace)(void* storage);
+};
+
+/** Entry points of modem<SF, OSR>. */
+template <unsigned SF, unsigned OSR>
+const modem_ops* modem_ops_for()
+{
+    using M = modem<SF, OSR>;
+    static const modem_ops ops = {
+        SF,
+        OSR,
+        sizeof(M),
+        alignof(M),
+        [](void* p, const lora_params* cfg) { return (new (p) M)->init(cfg); },
+        [](void* p, const uint16_t* symbols, std::size_t count, std::complex<float>* iq,
+           std::size_t cap) { return static_cast<M*>(p)->modulate(symbols, count, iq, cap); },
+        [](void* p, const std::complex<float>* iq, std::size_t count, uint16_t* symbols,
+           std::size_t cap) { return static_cast<M*>(p)->demodulate(iq, count, symbols, cap); },
+        [](const void* p) { return static_cast<const M*>(p)->metrics(); },
+        [](void* p) { return static_cast<M*>(p)->workspace(); },
+    };
+    return &ops;
+}
+
+/** Specialisation for @p cfg's sf and osr, or nullptr when none is compiled
+ * in (the generic API handles every configuration). */
+const modem_ops* find_modem(const lora_params* cfg);
+
+} // namespace lora_phy
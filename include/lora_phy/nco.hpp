@@ -0,0 +1,76 @@
+/**
+ * @file nco.hpp
+ * Numerically controlled oscillator producing exp(j*(phase + rate*n)) for
+ * consecutive samples n, used for CFO derotation in the demodulators and
+ * offset compensation.
+ *
+ * The oscillator never evaluates a sine or cosine per sample.  At
+ * construction it tabulates one block of BLOCK phasors exp(j*rate*i) in
+ * double precision; every block of output is that table scaled by the
+ * block's start phasor through the backend's broadcast complex multiply
+ * (dsp_kernels::cmul with stride 0).  The start phasor advances by
+ * exp(j*rate*BLOCK) per block in double precision and is renormalised to
+ * unit magnitude each time, so neither amplitude nor phase drifts with the
+ * length of the run.
+ *
+ * Accuracy: every output is within 3e-7 (absolute, unit amplitude) of the
+ * exact phasor, independent of n and of |phase|.  The old per-sample
+ * evaluation of rate * float(n) lost about ulp(rate * n) of phase, which
+ * grows with the capture length.  The phase itself is tracked in double
+ * and may be read back or moved with seek().
+ */
+#pragma once
+
+#include <complex>
+#include <cstddef>
+
+#include <lora_phy/dsp_kernels.hpp>
+
+namespace lora_phy {
+
+class nco {
+public:
+    /** Samples per table block; also the stack block size of mix(). */
+    static constexpr std::size_t BLOCK = 64;
+
+    /** Oscillator advancing @p rate radians per sample from @p phase,
+     * multiplying with @p k's kernels (scalar when null). */
+    nco(const dsp_kernels* k, double rate, double phase = 0.0);
+
+    /** Restart at @p phase; the rate is kept. */
+    void seek(double phase);
+
+    /** Phase of the next sample to be produced. */
+    double phase() const;
+
+    /** dst[i] = exp(j * phase_i) for the next @p n samples. */
+    void generate(std::complex<float>* dst, std::size_t n);
+
+    /** dst[i] = src[i * stride] * exp(j * phase_i) for the next @p n
+     * samples.  @p dst may alias @p src when @p stride is 1. */
+    void mix(std::complex<float>* dst, const std::complex<float>* src,
+             std::size_t stride, std::size_t n);
+
+    /** dst[i] = src[i * stride] * ref[i] * exp(j * phase_i) for the next
+     * @p n samples: CFO derotation, dechirp and window in one pass when
+     * @p ref is the windowed downchirp.  The phasors never reach memory;
+     * each block goes through dsp_kernels::derotate from the table and
+     * the start phasor, so the phase error bound above holds unchanged.
+     * On whole blocks the output is bit exact with mix() into a copy of
+     * @p ref followed by cmul.  @p dst may alias @p ref. */
+    void dechirp(std::complex<float>* dst, const std::complex<float>* src,
+                 std::size_t stride, const std::complex<float>* ref, std::size_t n);
+
+private:
+    void advance(std::size_t n);
+
+    const dsp_kernels* k_;
+    double rate_;
+    double start_;               ///< phase at the start of the current block
+    std::size_t pos_;            ///< samples already produced from this block
+    std::complex<double> z_;     ///< exp(j * start_)
+    std::complex<double> step_;  ///< exp(j * rate_ * BLOCK)
+    std::complex<float> ramp_[BLOCK]; ///< exp(j * rate_ * i)
+};
+
+} // namespace lora_phy
@@ -14,10 +14,18 @@
 
 #include <lora_phy/kissfft.hh>
 #include <lora_phy/LoRaDetector.hpp>
+#include <lora_phy/dsp_kernels.hpp>
+#include <lora_phy/fft_plans.hpp>
 
 namespace lora_phy {
 
 constexpr float PI = 3.14159265358979323846f;
+/// Double precision pi for phase rates that are integrated over long runs.
+constexpr double PI_D = 3.14159265358979323846;
+
+/// Default integer value of unit amplitude for quantised modulator output.
+constexpr float SC16_FULL_SCALE = 32767.0f;
+constexpr float CS8_FULL_SCALE = 127.0f;
 
 // ---------------------------------------------------------------------------
 // Helper structures
@@ -50,6 +58,16 @@ constexpr float bw_scale(bandwidth bw) {
     return bw_to_hz(bw) / 125000.0f;
 }
 
+/** Upper bound on the symbols demodulate()/lora_demodulate() hand to one
+ * batched FFT (kissfft::transform_batch). */
+constexpr size_t MAX_DEMOD_BATCH = 16;
+
+/** Detector metrics computed for each payload symbol.  ``none`` (the
+ * default) leaves payload symbols at the FFT argmax; ``peak`` adds the peak
+ * power, ``full`` also the noise floor, both averaged into lora_metrics.
+ * Offset estimation always runs with full metrics. */
+using metrics_level = ::DetectorMetrics;
+
 struct lora_params {
     unsigned sf{};                   ///< Spreading factor
     bandwidth bw{bandwidth::bw_125}; ///< Operating bandwidth
@@ -57,6 +75,11 @@ struct lora_params {
     unsigned osr{1};                 ///< Oversampling ratio
     window_type window{window_type::window_none}; ///< Optional analysis window
     uint8_t sync_word{0x12};         ///< Two-nibble network sync word
+    cpu_backend backend{cpu_backend::automatic}; ///< DSP kernel ISA
+    fft_planning planning{fft_planning::estimate}; ///< FFT plan selection
+    metrics_level symbol_metrics{metrics_level::none}; ///< per-symbol detector metrics
+    unsigned preamble_len{8};        ///< Frame preamble upchirps (modulate_frame)
+    unsigned sfd_quarters{9};        ///< Frame SFD in quarter downchirps (9 = 2.25)
 };
 
 /**
@@ -68,6 +91,110 @@ struct lora_metrics {
     bool  crc_ok{};      ///< true when last block passed CRC
     float cfo{};         ///< estimated carrier frequency offset
     float time_offset{}; ///< estimated timing offset
+    float peak_power{};  ///< mean payload peak power in dB (metrics_level::peak)
+    float noise_power{}; ///< mean payload noise floor in dB (metrics_level::full)
+    float snr{};         ///< peak_power - noise_power in dB (metrics_level::full)
+    float rssi{};        ///< received power from the two, in dBFS (metrics_level::full)
+};
+
+/**
+ * Quality of one demodulated symbol, from the spectrum the decision was made
+ * on.  Powers are in dB relative to a full-scale tone (amplitude 1), so
+ * peak_power - noise_power is the symbol's SNR per sample.
+ */
+struct lora_symbol_quality {
+    float peak_power{};     ///< power of the decided bin
+    float noise_power{};    ///< power of all other bins
+    float peak_to_second{}; ///< dB to the runner-up spectral peak, see LoRaDetector::peakToSecond
+};
+
+/**
+ * Base upchirp of one (sf, osr, bw), the samples of symbol 0 from zero phase,
+ * for table driven modulation (lora_chirp_table_init()).  Every symbol is
+ * the table cyclically shifted by symbol*osr samples, times one phasor per
+ * wrapped segment, so no sin/cos is evaluated per output sample.  The
+ * samples live in a caller buffer of sf-dependent N*osr entries.
+ */
+struct lora_chirp_table {
+    const std::complex<float>* samples{}; ///< N*osr unit phasors
+    size_t    len{};                      ///< N*osr
+    unsigned  sf{};
+    unsigned  osr{1};
+    bandwidth bw{bandwidth::bw_125};
+};
+
+/**
+ * Resumable modulator state (lora_mod_stream_init()).  It references the
+ * caller's symbol array and yields the packet produced by lora_modulate()
+ * a chunk at a time, carrying the chirp frequency and phase across calls,
+ * so a transmitter needs a ring buffer of its choosing instead of room for
+ * the whole packet.  The state is about 600 bytes and never allocates.
+ */
+struct lora_mod_stream {
+    const uint16_t* symbols{};     ///< payload symbols, owned by the caller
+    size_t    symbol_count{};
+    uint16_t  sync_symbols[2]{};   ///< network sync word symbols sent first
+    unsigned  sf{};
+    unsigned  osr{1};
+    float     bw_scale{1.0f};
+    float     amplitude{1.0f};
+    void (*polar)(std::complex<float>*, const float*, float, size_t){};
+
+    size_t    symbol{};            ///< symbol being generated, sync words first
+    size_t    offset{};            ///< samples of it already generated
+    float     freq{};              ///< chirp generator frequency
+    float     phase{};             ///< chirp generator phase
+    /// Block generated but not yet handed out, when a call ended inside it.
+    std::complex<float> pending[64]{};
+    size_t    pending_pos{};
+    size_t    pending_len{};
+};
+
+/** Most packets one lora_wideband_synth renders. */
+constexpr size_t MAX_SYNTH_PACKETS = 16;
+
+/**
+ * One LoRa channel of a wideband transmitter (lora_tx_channel_init()): the
+ * base upchirp of (sf, bw) at the wideband sample rate, already shifted to
+ * the channel's offset from the centre frequency.  A symbol is the table
+ * cyclically shifted by symbol*osr samples times one phasor per wrapped
+ * segment, as for lora_chirp_table, so upconversion costs no extra
+ * multiply.  The samples live in a caller buffer of N*osr entries, and one
+ * channel serves any number of packets.
+ */
+struct lora_tx_channel {
+    const std::complex<float>* samples{}; ///< N*osr unit phasors
+    size_t    len{};                      ///< N*osr
+    unsigned  sf{};
+    unsigned  osr{1};                     ///< sample rate / bandwidth
+    bandwidth bw{bandwidth::bw_125};
+    double    shift{};                    ///< offset in radians per sample
+};
+
+/** A packet placed in the wideband stream: the samples
+ * lora_modulate_table() produces for @p symbols, moved to @p channel, from
+ * sample @p start on. */
+struct lora_tx_packet {
+    const lora_tx_channel* channel{};
+    const uint16_t* symbols{};     ///< owned by the caller
+    size_t    symbol_count{};
+    size_t    start{};             ///< first wideband sample of the packet
+    float     amplitude{1.0f};
+    uint8_t   sync_word{0x12};
+};
+
+/**
+ * Resumable multi-channel synthesiser (lora_wideband_init()).  It references
+ * the caller's packet descriptors and yields the sum of all packets a chunk
+ * at a time, keeping each packet's position and carrier phasor across calls.
+ */
+struct lora_wideband_synth {
+    const lora_tx_packet* packets{}; ///< owned by the caller
+    size_t    packet_count{};
+    const dsp_kernels* kernels{};
+    size_t    position{};          ///< wideband samples produced so far
+    /// Phase of the symbol each packet is in, chirp and carrier together.
+    std::complex<double> rot[MAX_SYNTH_PACKETS]{};
 };
 
 /**
@@ -79,18 +206,147 @@ struct lora_metrics {
 struct lora_workspace {
     uint16_t*            symbol_buf{}; ///< N entries
     std::complex<float>* fft_in{};     ///< N complex samples
-    std::complex<float>* fft_out{};    ///< N*osr complex samples for modulation/demodulation
+    /// N*osr complex samples for modulation/demodulation.  Optional: when
+    /// null (or equal to fft_in) estimate_offsets() and demodulate() dechirp
+    /// and transform in place in fft_in, halving the per-workspace buffers.
+    std::complex<float>* fft_out{};
 
     float*               window{};     ///< N analysis window coefficients
     window_type          window_kind{window_type::window_none};
 
-    kissfft_plan<float>  plan_fwd{};   ///< forward FFT plan
-    kissfft_plan<float>  plan_inv{};   ///< inverse FFT plan
+    /// Optional N samples for the dechirp reference.  When set, init() fills
+    /// them with the downchirp times the analysis window, and demodulate()
+    /// dechirps each symbol with one complex multiply by this table instead
+    /// of regenerating the downchirp and windowing the result.
+    std::complex<float>* dechirp{};
+
+    /// Optional batch buffers of batch_len complex samples each.  When
+    /// batch_in is set and batch_len >= 2*N, demodulate() transforms up to
+    /// min(batch_len / N, MAX_DEMOD_BATCH) symbols per FFT call.  Without
+    /// batch_out the spectra overwrite batch_in.
+    std::complex<float>* batch_in{};
+    std::complex<float>* batch_out{};
+    size_t               batch_len{};
+
+    /// Optional per-symbol quality output of quality_len entries.  When set,
+    /// demodulate() fills one entry per payload symbol (up to quality_len)
+    /// and computes full metrics regardless of the metrics level.
+    lora_symbol_quality* quality{};
+    size_t               quality_len{};
+
+    /// Optional N*osr samples for the base upchirp.  When set, init() fills
+    /// them (see lora_chirp_table) and modulate() builds symbols as rotated
+    /// copies instead of evaluating every sample's phase.
+    std::complex<float>* chirp_buf{};
+    lora_chirp_table     chirp{};      ///< bound to chirp_buf by init()
+
+    /// Optional cache of frame_buf_len samples for the frame header
+    /// (preamble, sync word and SFD, lora_frame_header_len() samples).  When
+    /// set, init() synthesises the header once and modulate_frame() copies
+    /// it, so only payload symbols are generated per packet.
+    std::complex<float>* frame_buf{};
+    size_t               frame_buf_len{};
+    size_t               frame_header_len{}; ///< cached samples, set by init()
+    float                frame_phase{};      ///< chirp phase after the header
+
+
+#if LORA_PHY_EMBEDDED_PLANS
+    kissfft_embedded_plan<float> plan_fwd_storage{}; ///< backs plan_fwd
+    kissfft_embedded_plan<float> plan_inv_storage{}; ///< backs plan_inv
+#endif
+    const kissfft_plan<float>* plan_fwd{}; ///< forward FFT plan bound by init()
+    const kissfft_plan<float>* plan_inv{}; ///< inverse FFT plan bound by init()
+    const dsp_kernels*   kernels{};    ///< DSP kernels selected by init()
 
     lora_metrics         metrics{};    ///< updated by processing functions
     unsigned             osr{1};       ///< oversampling ratio stored during init
     bandwidth           bw{bandwidth::bw_125}; ///< bandwidth stored during init
     uint8_t             sync_word{0x12}; ///< configured network sync word
+    metrics_level       symbol_metrics{metrics_level::none}; ///< stored during init
+    unsigned            preamble_len{8};  ///< stored during init
+    unsigned            sfd_quarters{9};  ///< stored during init
+};
+
+/**
+ * Streaming receiver over an initialised workspace (lora_demod_stream_init()).
+ * IQ arrives in chunks of any size; each symbol is decided as soon as its
+ * window is complete.  Between calls the stream keeps the symbol alignment,
+ * the offset estimate and the samples of the next, incomplete window in a
+ * caller buffer of lora_demod_stream_buffer_len() samples (two symbols).
+ */
+struct lora_demod_stream {
+    lora_workspace*      ws{};
+    std::complex<float>* buf{};       ///< carry buffer, owned by the caller
+    size_t               buf_len{};
+    size_t               start{};     ///< stream index of buf[0]
+    size_t               len{};       ///< samples held in buf
+    size_t               received{};  ///< samples pushed so far
+    size_t               symbol{};    ///< next symbol to decide, sync words first
+    bool                 estimated{}; ///< offsets estimated from symbols 0 and 1
+    int                  t_off{};     ///< rounded timing offset, samples
+    double               rate{};      ///< CFO derotation, radians per sample
+    uint16_t             sync[2]{};   ///< sync word symbols
+    size_t               payload{};   ///< payload symbols decided
+    float                sum_power{}; ///< payload metric sums, see demodulate()
+    float                sum_noise{};
+};
+
+/** Counters of a lora_frame_sync since lora_frame_sync_init(). */
+struct lora_sync_stats {
+    size_t samples{};      ///< samples pushed
+    size_t windows{};      ///< symbol windows transformed while searching or aligning
+    size_t detections{};   ///< preamble runs found
+    size_t frames{};       ///< detections confirmed by their SFD
+    size_t false_alarms{}; ///< detections abandoned without an SFD
+    size_t latency_sum{};  ///< over frames, samples from sync word start to confirmation
+    size_t latency_max{};
+};
+
+/** A frame found and demodulated by lora_frame_sync_push(). */
+struct lora_rx_frame {
+    size_t    start{};       ///< stream index of the first sync word sample
+    size_t    confirmed{};   ///< stream index at which the SFD confirmed the frame
+    float     cfo{};         ///< carrier offset in bins, as lora_metrics::cfo
+    float     time_offset{}; ///< samples the estimated start lies after @c start
+    float     snr{};         ///< mean preamble peak-to-mean ratio, dB
+    uint8_t   sync_word{};   ///< received sync word
+    uint16_t* symbols{};     ///< payload symbols, in the caller's array
+};
+
+/** What a lora_frame_sync is doing with its next window. */
+enum class frame_sync_state : uint8_t {
+    search,   ///< sliding one symbol at a time for a run of preamble peaks
+    preamble, ///< on the preamble's symbol grid, waiting for the SFD
+    payload,  ///< handing payload windows to the demodulator
+};
+
+/**
+ * Frame synchroniser over a continuous capture (lora_frame_sync_init()).
+ * It finds modulate_frame() frames of a fixed payload length at any
+ * position, estimates their CFO and timing from the preamble and SFD, and
+ * demodulates the sync word and payload as lora_demod_stream does.  Samples
+ * still needed are kept in a caller buffer of lora_frame_sync_buffer_len().
+ */
+struct lora_frame_sync {
+    lora_workspace*      ws{};
+    std::complex<float>* buf{};        ///< sample history, owned by the caller
+    size_t               buf_len{};
+    size_t               start{};      ///< stream index of buf[0]
+    size_t               len{};        ///< samples held in buf
+    uint16_t*            payload{};    ///< payload_symbols entries, owned by the caller
+    size_t               payload_symbols{};
+    float                threshold{8.0f}; ///< preamble peak-to-mean ratio, dB
+    unsigned             min_preamble{4}; ///< agreeing windows that make a detection
+    frame_sync_state     state{frame_sync_state::search};
+    size_t               next{};       ///< stream index of the next window
+    unsigned             run{};        ///< agreeing windows so far
+    uint16_t             run_bin{};    ///< peak bin of the last of them
+    float                run_snr{};    ///< sum of their peak-to-mean ratios
+    unsigned             aligned{};    ///< windows examined on the preamble grid
+    float                up_bins[3]{}; ///< fractional bins of the last three
+    lora_rx_frame        frame{};      ///< frame being demodulated
+    lora_demod_stream    demod{};      ///< decision state of that frame
+    lora_sync_stats      stats{};
 };
 
 // ---------------------------------------------------------------------------
@@ -99,9 +355,13 @@ struct lora_workspace {
 
 /** Initialise the workspace for a given parameter set.  Returns 0 on success
  * or -EINVAL when parameters are invalid, -ENOMEM if a required buffer is
- * missing.  The workspace and the buffers it references are owned by the
- * caller and must remain valid for subsequent calls. */
+ * missing, -ENOTSUP if ``cfg->backend`` names an ISA the host cannot run.
+ * The workspace and the buffers it references are owned by the caller and
+ * must remain valid for subsequent calls. */
 int init(lora_workspace* ws, const lora_params* cfg);
+
+/** DSP backend selected for @p ws by init(). */
+cpu_backend get_backend(const lora_workspace* ws);
 
 /** Reset runtime counters and metric fields in @p ws without touching the
  * caller supplied buffers or FFT plans. */
@@ -131,6 +391,32 @@ ssize_t modulate(lora_workspace* ws,
                  const uint16_t* symbols, size_t symbol_count,
                  std::complex<float>* iq, size_t iq_cap);
 
+/** Modulate a complete frame: ws->preamble_len upchirps, the two sync word
+ * symbols, an SFD of ws->sfd_quarters quarter downchirps and the payload
+ * @p symbols, phase continuous throughout.  The header comes from the
+ * workspace cache when init() filled frame_buf.  Returns the number of
+ * samples produced (lora_frame_header_len() + symbol_count * N * osr),
+ * -ERANGE if @p iq_cap is insufficient or -EINVAL for invalid arguments. */
+ssize_t modulate_frame(lora_workspace* ws,
+                       const uint16_t* symbols, size_t symbol_count,
+                       std::complex<float>* iq, size_t iq_cap);
+
+/** modulate() straight to interleaved 16-bit (SC16) or 8-bit (CS8) IQ.
+ * Unit amplitude maps to @p full_scale; every sample is rounded to nearest
+ * (no dither) and saturated as it is synthesised, one 64-sample block at a
+ * time, so no float copy of the packet exists.  These always run the
+ * recursive chirp generator, chirp_buf or not.  Returns the number of
+ * samples produced, -ERANGE if @p iq_cap is insufficient or -EINVAL for
+ * invalid arguments (including @p full_scale <= 0). */
+ssize_t modulate_sc16(lora_workspace* ws,
+                      const uint16_t* symbols, size_t symbol_count,
+                      std::complex<int16_t>* iq, size_t iq_cap,
+                      float full_scale = SC16_FULL_SCALE);
+ssize_t modulate_cs8(lora_workspace* ws,
+                     const uint16_t* symbols, size_t symbol_count,
+                     std::complex<int8_t>* iq, size_t iq_cap,
+                     float full_scale = CS8_FULL_SCALE);
+
 /** Demodulate @p iq samples into @p symbols using the FFT plans inside @p ws.
  * The input length must be a multiple of the oversampled symbol size
  * ((1<<sf) * osr).  Returns number of symbols produced or -ERANGE if
@@ -140,9 +426,89 @@ ssize_t demodulate(lora_workspace* ws,
                    const std::complex<float>* iq, size_t sample_count,
                    uint16_t* symbols, size_t symbol_cap);
 
+/** demodulate() that also writes sf max-log bit LLRs per symbol to @p llrs
+ * (symbol_cap * sf entries): llrs[i*sf + k] belongs to bit k (LSB first) of
+ * symbols[i], is positive when the bit is more likely 0 and is scaled by the
+ * symbol's noise floor.  They come from the FFT bins already computed for
+ * the hard decision (LoRaDetector::softBits); nothing is allocated.  A null
+ * @p llrs makes this plain demodulate(). */
+ssize_t demodulate_soft(lora_workspace* ws,
+                        const std::complex<float>* iq, size_t sample_count,
+                        uint16_t* symbols, size_t symbol_cap, float* llrs);
+
+/** Carry buffer a lora_demod_stream over @p ws needs: 2 * N * osr samples. */
+size_t lora_demod_stream_buffer_len(const lora_workspace* ws);
+
+/** Bind @p st to the initialised workspace @p ws and @p buf (@p buf_len
+ * samples) and start a packet.  Returns 0, -EINVAL for a missing argument or
+ * an uninitialised workspace, or -ERANGE when @p buf_len is below
+ * lora_demod_stream_buffer_len(). */
+int lora_demod_stream_init(lora_demod_stream* st, lora_workspace* ws,
+                           std::complex<float>* buf, size_t buf_len);
+
+/** Feed the next @p sample_count samples of the packet.  The first two
+ * symbols are buffered for estimate_offsets(), after which every symbol is
+ * decided as soon as its window is complete.  Windows lying inside @p iq
+ * are read in place; only the samples of an unfinished window are copied.
+ * Payload symbols go to @p symbols, which needs
+ * sample_count / (N * osr) + 1 entries, and their number is returned;
+ * -ERANGE for a smaller @p symbol_cap (nothing is consumed), -EINVAL for
+ * invalid arguments.  The sync word lands in ``ws->sync_word`` once its two
+ * symbols are decided, and the payload metrics are kept up to date as for
+ * demodulate(). */
+ssize_t lora_demod_stream_push(lora_demod_stream* st,
+                               const std::complex<float>* iq, size_t sample_count,
+                               uint16_t* symbols, size_t symbol_cap);
+
+/** End the packet: decide the symbols whose timing-shifted window ran past
+ * the end of the input, as demodulate() does, and ignore any trailing
+ * partial symbol.  Returns the payload symbols written (at most 1), or
+ * -ERANGE when fewer than two symbols arrived.  Together, the
+ * lora_demod_stream_push() and lora_demod_stream_flush() outputs equal
+ * demodulate() on the concatenated input, whatever the chunk sizes.
+ * Afterwards the stream is ready for the next packet. */
+ssize_t lora_demod_stream_flush(lora_demod_stream* st, uint16_t* symbols, size_t symbol_cap);
+
+/** History a lora_frame_sync over @p ws needs: 6 * N * osr samples. */
+size_t lora_frame_sync_buffer_len(const lora_workspace* ws);
+
+/** Bind @p fs to the initialised workspace @p ws, @p buf (@p buf_len
+ * samples) and @p payload, and start searching.  Frames carry
+ * @p payload_symbols symbols after ws->preamble_len upchirps, the sync word
+ * and an SFD of ws->sfd_quarters quarter downchirps.  Returns 0, -EINVAL for
+ * a missing argument, no payload or an uninitialised workspace, or -ERANGE
+ * when @p buf_len is below lora_frame_sync_buffer_len(). */
+int lora_frame_sync_init(lora_frame_sync* fs, lora_workspace* ws,
+                         std::complex<float>* buf, size_t buf_len,
+                         uint16_t* payload, size_t payload_symbols);
+
+/** Feed the next @p sample_count samples of the capture.  Each window of
+ * one symbol is dechirped and transformed once while searching; a run of
+ * fs->min_preamble windows whose peaks agree within a bin, each at least
+ * fs->threshold dB above the mean, is a preamble.  The synchroniser then
+ * moves onto the preamble's symbol grid and waits for the first SFD
+ * downchirp.  Its bin and the preamble's give the CFO and timing offset,
+ * with which the sync word and payload windows are decided as
+ * lora_demod_stream would.  Samples pass through the history, which holds
+ * the windows not yet examined and three symbols before them.  Frames
+ * completed in this call go
+ * to @p frames, which needs
+ * sample_count / ((payload_symbols + 1) * N * osr) + 1 entries, and their
+ * number is returned; -ERANGE for a smaller @p frame_cap (nothing is
+ * consumed), -EINVAL for invalid arguments.  @p symbols has room for
+ * frame_cap * payload_symbols entries, frame i's starting at
+ * i * payload_symbols.  The metrics of the last frame are in
+ * ``ws->metrics`` and its sync word in ``ws->sync_word``. */
+ssize_t lora_frame_sync_push(lora_frame_sync* fs,
+                             const std::complex<float>* iq, size_t sample_count,
+                             lora_rx_frame* frames, size_t frame_cap, uint16_t* symbols);
+
 /** Analyse @p samples to estimate carrier frequency and timing offsets.
  * The input must contain a whole number of symbols and typically points to
- * preamble upchirps.  Estimated values are written to ``ws->metrics``.
+ * preamble upchirps.  The fractional part of each symbol's peak comes from a
+ * zoom DFT around the FFT argmax (LoRaDetector::refine), so a single symbol
+ * already resolves the CFO to well below a bin.  Estimated values are
+ * written to ``ws->metrics``.
  */
 void estimate_offsets(lora_workspace* ws,
                       const std::complex<float>* samples,
@@ -179,40 +545,222 @@ struct lora_demod_workspace {
     std::complex<float> fft_out[MAX_N];
     float window[MAX_N];
     window_type window_kind{window_type::window_none};
-    kissfft_plan<float> fft_plan{}; ///< preallocated plan for kissfft
+#if LORA_PHY_EMBEDDED_PLANS
+    kissfft_embedded_plan<float> fft_plan_storage{}; ///< backs fft_plan
+#endif
+    const kissfft_plan<float>* fft_plan{}; ///< plan used by fft
     alignas(kissfft<float>) unsigned char fft_buf[sizeof(kissfft<float>)];
     alignas(LoRaDetector<float>) unsigned char detector_buf[sizeof(LoRaDetector<float>)];
     kissfft<float>* fft{};          ///< fft instance using the plan
     LoRaDetector<float>* detector{};
+    std::complex<int16_t> q15_in[MAX_N]; ///< Q15 symbol, transformed in place
+#if LORA_PHY_EMBEDDED_PLANS
+    kissfft_embedded_plan<int16_t> q15_plan_storage{}; ///< backs q15_plan
+#endif
+    const kissfft_plan<int16_t>* q15_plan{}; ///< plan used by q15_fft
+    alignas(kissfft<int16_t>) unsigned char q15_fft_buf[sizeof(kissfft<int16_t>)];
+    alignas(LoRaDetector<int16_t>) unsigned char q15_detector_buf[sizeof(LoRaDetector<int16_t>)];
+    kissfft<int16_t>* q15_fft{};    ///< Q15 fft for lora_demodulate_sc16
+    LoRaDetector<int16_t>* q15_detector{};
+    const dsp_kernels* kernels{};   ///< DSP kernels selected at init
+    metrics_level symbol_metrics{metrics_level::none}; ///< payload detector metrics
     lora_metrics metrics{};         ///< estimated metrics for last demod
-    std::complex<float>* scratch{}; ///< caller-provided scratch buffer
-    size_t scratch_len{};           ///< number of elements in scratch
 };
 
-// Initialise and clean up the demodulator workspace.  Callers must provide a
-// scratch buffer of at least @p max_samples elements for temporary storage
-// during normalisation.  No memory is allocated by these routines.
+// Initialise and clean up the demodulator workspace.  @p scratch and
+// @p max_samples are unused; lora_demodulate() never copies its input, and
+// they remain so existing callers compile.  @p backend selects the DSP
+// kernels; a request the host cannot run falls back to the best supported
+// one, see lora_demod_backend().  @p planning chooses how the FFT plan is
+// picked, see fft_plans.hpp.  @p metrics selects the detector metrics
+// computed for payload symbols.  No memory is allocated by these routines.
 void lora_demod_init(lora_demod_workspace* ws, unsigned sf,
                      window_type win = window_type::window_none,
                      std::complex<float>* scratch = nullptr,
-                     size_t max_samples = 0);
+                     size_t max_samples = 0,
+                     cpu_backend backend = cpu_backend::automatic,
+                     fft_planning planning = fft_planning::estimate,
+                     metrics_level metrics = metrics_level::none);
 void lora_demod_free(lora_demod_workspace* ws);
 
+// DSP backend the demodulator workspace is running on.
+cpu_backend lora_demod_backend(const lora_demod_workspace* ws);
+
 // Modulate an array of symbols into complex baseband samples.
-// samples_per_symbol = 1 << sf
+// samples_per_symbol = 1 << sf.  Passing @p kernels evaluates the chirp
+// phasors with that backend's vector polar kernel instead of std::polar.
 size_t lora_modulate(const uint16_t* symbols, size_t symbol_count,
                      std::complex<float>* out_samples, unsigned sf, unsigned osr,
                      bandwidth bw, float amplitude = 1.0f,
-                     uint8_t sync = 0x12);
+                     uint8_t sync = 0x12,
+                     const dsp_kernels* kernels = nullptr);
+
+// Prepare @p st to stream lora_modulate(symbols, symbol_count, ...) with the
+// same parameters.  @p symbols must stay valid until the stream is drained.
+// Returns 0 or -EINVAL for invalid parameters.
+int lora_mod_stream_init(lora_mod_stream* st, const uint16_t* symbols,
+                         size_t symbol_count, unsigned sf, unsigned osr,
+                         bandwidth bw, float amplitude = 1.0f,
+                         uint8_t sync = 0x12,
+                         const dsp_kernels* kernels = nullptr);
+
+// Write the next samples of the packet, at most @p max_samples, to @p out
+// and return how many were written; 0 once the packet is complete.  The
+// concatenated output equals lora_modulate()'s bit for bit whatever the
+// chunk sizes.
+size_t lora_mod_stream_next(lora_mod_stream* st, std::complex<float>* out,
+                            size_t max_samples);
+
+// lora_mod_stream_next() quantised to SC16/CS8 as it is generated: each
+// component is scaled by @p full_scale, rounded to nearest without dither
+// and saturated to the integer range.
+size_t lora_mod_stream_next_sc16(lora_mod_stream* st, std::complex<int16_t>* out,
+                                 size_t max_samples,
+                                 float full_scale = SC16_FULL_SCALE);
+size_t lora_mod_stream_next_cs8(lora_mod_stream* st, std::complex<int8_t>* out,
+                                size_t max_samples,
+                                float full_scale = CS8_FULL_SCALE);
+
+// Samples the stream has yet to produce.
+size_t lora_mod_stream_remaining(const lora_mod_stream* st);
+
+// lora_modulate() written as SC16/CS8, see lora_mod_stream_next_sc16().
+// Returns the number of samples written, 0 for invalid parameters.
+size_t lora_modulate_sc16(const uint16_t* symbols, size_t symbol_count,
+                          std::complex<int16_t>* out_samples, unsigned sf, unsigned osr,
+                          bandwidth bw, float full_scale = SC16_FULL_SCALE,
+                          uint8_t sync = 0x12,
+                          const dsp_kernels* kernels = nullptr);
+size_t lora_modulate_cs8(const uint16_t* symbols, size_t symbol_count,
+                         std::complex<int8_t>* out_samples, unsigned sf, unsigned osr,
+                         bandwidth bw, float full_scale = CS8_FULL_SCALE,
+                         uint8_t sync = 0x12,
+                         const dsp_kernels* kernels = nullptr);
+
+// Samples in a frame header: @p preamble_len + 2 symbols and an SFD of
+// @p sfd_quarters quarter symbols.
+size_t lora_frame_header_len(unsigned sf, unsigned osr, unsigned preamble_len,
+                             unsigned sfd_quarters);
+
+// Write the frame header (preamble upchirps, sync word symbols, SFD
+// downchirps) to @p out, which must hold lora_frame_header_len() samples,
+// and return the samples written (0 for invalid parameters).  @p end_phase,
+// when given, receives the chirp phase the payload continues from.
+size_t lora_frame_header(std::complex<float>* out, unsigned sf, unsigned osr,
+                         bandwidth bw, unsigned preamble_len, unsigned sfd_quarters,
+                         float amplitude = 1.0f, uint8_t sync = 0x12,
+                         const dsp_kernels* kernels = nullptr,
+                         float* end_phase = nullptr);
+
+// Payload symbols alone, without sync word, starting at chirp phase
+// @p phase; a frame is lora_frame_header() followed by this.
+size_t lora_modulate_payload(const uint16_t* symbols, size_t symbol_count,
+                             std::complex<float>* out_samples, unsigned sf, unsigned osr,
+                             bandwidth bw, float phase, float amplitude = 1.0f,
+                             const dsp_kernels* kernels = nullptr);
+
+// lora_frame_header() and lora_modulate_payload() into one buffer of
+// lora_frame_header_len() + symbol_count * (1<<sf) * osr samples.
+size_t lora_modulate_frame(const uint16_t* symbols, size_t symbol_count,
+                           std::complex<float>* out_samples, unsigned sf, unsigned osr,
+                           bandwidth bw, unsigned preamble_len = 8,
+                           unsigned sfd_quarters = 9, float amplitude = 1.0f,
+                           uint8_t sync = 0x12, const dsp_kernels* kernels = nullptr);
+
+// Fill @p buf (at least (1<<sf)*osr entries, @p buf_len) with the base
+// upchirp of (sf, osr, bw) and bind it to @p table.  The phase is evaluated
+// in closed form in double precision.  Returns 0, -EINVAL for invalid
+// parameters or -ERANGE when @p buf_len is too small.
+int lora_chirp_table_init(lora_chirp_table* table, std::complex<float>* buf,
+                          size_t buf_len, unsigned sf, unsigned osr, bandwidth bw);
+
+// lora_modulate() from a chirp table: every symbol is a rotated copy of the
+// table, scaled by a phasor that keeps the phase continuous across symbols,
+// using @p kernels' vector complex multiply (scalar when null).  The output
+// matches lora_modulate() to within its float phase accumulation error.
+size_t lora_modulate_table(const lora_chirp_table* table,
+                           const uint16_t* symbols, size_t symbol_count,
+                           std::complex<float>* out_samples,
+                           float amplitude = 1.0f, uint8_t sync = 0x12,
+                           const dsp_kernels* kernels = nullptr);
+
+// Fill @p buf (@p buf_len entries, at least (1<<sf)*osr where osr =
+// @p sample_rate / bandwidth) with the base upchirp of (sf, bw) moved
+// @p offset_hz from the centre of a stream sampled at @p sample_rate, and
+// bind it to @p channel.  Phases are evaluated in double precision.  Returns
+// 0, -EINVAL when the rate is not a multiple of the bandwidth or the channel
+// does not fit inside the stream's band, or -ERANGE when @p buf_len is too
+// small.
+int lora_tx_channel_init(lora_tx_channel* channel, std::complex<float>* buf,
+                         size_t buf_len, unsigned sf, bandwidth bw,
+                         double sample_rate, double offset_hz);
+
+// Prepare @p synth to render @p packet_count (up to MAX_SYNTH_PACKETS)
+// packets into one stream, multiplying with @p kernels (scalar when null,
+// so the output does not depend on the host).  The packets, their channels and symbols must stay valid until the
+// stream is drained.  Returns 0 or -EINVAL.
+int lora_wideband_init(lora_wideband_synth* synth, const lora_tx_packet* packets,
+                       size_t packet_count, const dsp_kernels* kernels = nullptr);
+
+// Write the next samples of the wideband stream, at most @p max_samples, to
+// @p out and return how many were written; 0 once every packet is complete.
+// Samples before, between and after packets are zero; overlapping packets
+// add.  Chunk sizes change the output by rounding only.
+size_t lora_wideband_next(lora_wideband_synth* synth, std::complex<float>* out,
+                          size_t max_samples);
+
+// Samples the wideband stream has yet to produce.
+size_t lora_wideband_remaining(const lora_wideband_synth* synth);
+
+// Spectral peak of one demodulated symbol, see LoRaDetector::findPeaks.
+using lora_peak = LoRaDetector<float>::Peak;
+
+// Most peaks lora_demodulate() reports per symbol.
+constexpr size_t MAX_DEMOD_PEAKS = LoRaDetector<float>::MAX_PEAKS;
 
 // Demodulate complex samples into symbol indices using a prepared workspace.
-// Returns the number of symbols produced or -ERANGE when the scratch buffer
-// inside ``ws`` is missing or too small to normalise inputs that exceed the
-// canonical [-1.0, 1.0] range.
+// Returns the number of symbols produced.  Samples are used at their own
+// scale, whatever their amplitude: symbol decisions, LLRs, SNR and the
+// peak-to-second ratio are scale invariant.  Peak and noise powers, RSSI and
+// lora_peak powers are reported in the units of the input.
+//
+// With @p out_peaks, the @p peaks_per_symbol strongest spectral peaks of
+// every symbol written to @p out_symbols are stored as well, strongest first,
+// at out_peaks[i * peaks_per_symbol]; out_symbols[i] is always the bin of the
+// first one.  The runner-up peaks expose a colliding packet on the same SF
+// and give soft decisions a second candidate.  Slots beyond the local maxima
+// a spectrum has are zeroed.  peaks_per_symbol above MAX_DEMOD_PEAKS returns
+// -EINVAL.
+//
+// With @p out_llrs, every symbol written to @p out_symbols also gets sf
+// max-log bit LLRs (LoRaDetector::softBits) at out_llrs[i * sf], LSB first,
+// positive favouring 0 and normalised to the symbol's noise floor.
+//
+// With @p out_quality, out_quality[i] receives the peak power, noise floor
+// and peak-to-second ratio of out_symbols[i]; the payload then runs with full
+// metrics whatever the workspace's level, so ``ws->metrics`` also carries
+// the packet's SNR and RSSI.
 ssize_t lora_demodulate(lora_demod_workspace* ws,
                         const std::complex<float>* samples, size_t sample_count,
                         uint16_t* out_symbols, unsigned osr,
-                        uint8_t* out_sync = nullptr);
+                        uint8_t* out_sync = nullptr,
+                        lora_peak* out_peaks = nullptr,
+                        size_t peaks_per_symbol = 0,
+                        float* out_llrs = nullptr,
+                        lora_symbol_quality* out_quality = nullptr);
+
+// lora_demodulate() for interleaved 16-bit IQ (SC16, full scale 32768).
+// The timing and CFO estimate runs in float as usual; every payload symbol
+// is dechirped and transformed in Q15 block floating point, so no float
+// copy of the capture is made and no normalisation (or scratch buffer) is
+// needed.  @p out_llrs and @p out_quality are filled as in
+// lora_demodulate().  Returns the number of symbols produced.
+ssize_t lora_demodulate_sc16(lora_demod_workspace* ws,
+                             const std::complex<int16_t>* samples, size_t sample_count,
+                             uint16_t* out_symbols, unsigned osr,
+                             uint8_t* out_sync = nullptr,
+                             float* out_llrs = nullptr,
+                             lora_symbol_quality* out_quality = nullptr);
 
 // Simple Hamming(8,4) based encoder. Each input byte becomes two symbols.
 size_t lora_encode(const uint8_t* bytes, size_t byte_count,
@@ -71,31 +71,11 @@ int main(int argc, char** argv) {
         in_stream = &std::cin;
     }
 
-    std::vector<std::complex<float>> samples;
-    float re = 0.0f, im = 0.0f;
-    while (in_stream->read(reinterpret_cast<char*>(&re), sizeof(float))) {
-        if (!in_stream->read(reinterpret_cast<char*>(&im), sizeof(float))) break;
-        samples.emplace_back(re, im);
-    }
-
-    if (samples.empty()) {
-        std::cerr << "No samples provided\n";
-        return 1;
-    }
-
     const size_t N = size_t(1) << params.sf;
-    if (samples.size() % N != 0) {
-        std::cerr << "Sample count not multiple of symbol size\n";
-        return 1;
-    }
-    const size_t symbol_count = samples.size() / N;
-
-    std::vector<uint16_t> symbols(symbol_count);
     std::vector<std::complex<float>> fft_in(N);
     std::vector<std::complex<float>> fft_out(N);
 
     lora_workspace ws{};
-    ws.symbol_buf = symbols.data();
     ws.fft_in = fft_in.data();
     ws.fft_out = fft_out.data();
 
@@ -104,12 +84,50 @@ int main(int argc, char** argv) {
         return 1;
     }
 
-    ssize_t demod_syms = demodulate(&ws, samples.data(), samples.size(),
-                                    symbols.data(), symbols.size());
-    if (demod_syms < 0) {
-        std::cerr << "demodulate() failed\n";
+    // Symbols are decided as each one arrives; only the stream's carry of
+    // two symbols and the current read buffer are held in memory.
+    std::vector<std::complex<float>> carry(lora_demod_stream_buffer_len(&ws));
+    lora_demod_stream stream;
+    if (lora_demod_stream_init(&stream, &ws, carry.data(), carry.size()) != 0) {
+        std::cerr << "Failed to initialise demodulator stream\n";
+        return 1;
+    }
+    constexpr size_t chunk = 4096;
+    std::vector<float> raw(2 * chunk);
+    std::vector<std::complex<float>> samples(chunk);
+    std::vector<uint16_t> out(chunk / N + 1);
+    std::vector<uint16_t> symbols;
+    size_t sample_count = 0;
+    while (*in_stream) {
+        in_stream->read(reinterpret_cast<char*>(raw.data()),
+                        static_cast<std::streamsize>(raw.size() * sizeof(float)));
+        const size_t n = static_cast<size_t>(in_stream->gcount()) / (2 * sizeof(float));
+        for (size_t i = 0; i < n; ++i) samples[i] = std::complex<float>(raw[2 * i], raw[2 * i + 1]);
+        const ssize_t got = lora_demod_stream_push(&stream, samples.data(), n, out.data(),
+                                                   out.size());
+        if (got < 0) {
+            std::cerr << "demodulation failed\n";
+            return 1;
+        }
+        symbols.insert(symbols.end(), out.begin(), out.begin() + got);
+        sample_count += n;
+    }
+
+    if (sample_count == 0) {
+        std::cerr << "No samples provided\n";
+        return 1;
+    }
+    if (sample_count % N != 0) {
+        std::cerr << "Sample count not multiple of symbol size\n";
+        return 1;
+    }
+    const ssize_t tail = lora_demod_stream_flush(&stream, out.data(), out.size());
+    if (tail < 0) {
+        std::cerr << "demodulation failed\n";
         return 1;
     }
+    symbols.insert(symbols.end(), out.begin(), out.begin() + tail);
+    const ssize_t demod_syms = static_cast<ssize_t>(symbols.size());
 
     std::vector<uint8_t> decoded(demod_syms / 2);
     ssize_t decoded_bytes =
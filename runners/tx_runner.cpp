@@ -13,7 +13,8 @@ namespace {
 
 void usage(const char* prog) {
     std::cerr << "Usage: " << prog
-              << " --payload=HEX [--sf=N] [--cr=N] [--bw=HZ] [--out=FILE|--stdout]\n";
+              << " --payload=HEX [--sf=N] [--cr=N] [--bw=HZ] [--format=cf32|sc16|cs8]"
+                 " [--full-scale=X] [--out=FILE|--stdout]\n";
 }
 
 bool parse_hex_payload(const std::string& hex, std::vector<uint8_t>& out) {
@@ -27,12 +28,26 @@ bool parse_hex_payload(const std::string& hex, std::vector<uint8_t>& out) {
     return true;
 }
 
+enum class sample_format { cf32, sc16, cs8 };
+
+// Drain @p stream through a fixed buffer, writing interleaved samples of
+// type T in host byte order.
+template <typename T, typename Next>
+void write_stream(std::ostream& out, lora_mod_stream& stream, Next next) {
+    std::vector<std::complex<T>> chunk(4096);
+    while (size_t n = next(&stream, chunk.data(), chunk.size()))
+        out.write(reinterpret_cast<const char*>(chunk.data()),
+                  static_cast<std::streamsize>(n * sizeof(chunk[0])));
+}
+
 } // namespace
 
 int main(int argc, char** argv) {
     std::string payload_hex;
     std::string out_path;
     bool to_stdout = false;
+    sample_format format = sample_format::cf32;
+    float full_scale = 0.0f; // format default
     lora_params params{};
     params.sf = 7; // defaults
 
@@ -56,6 +71,24 @@ int main(int argc, char** argv) {
                 std::cerr << "Unsupported bandwidth\n";
                 return 1;
             }
+        } else if (arg.rfind("--format=", 0) == 0) {
+            const std::string val = arg.substr(9);
+            if (val == "cf32")
+                format = sample_format::cf32;
+            else if (val == "sc16")
+                format = sample_format::sc16;
+            else if (val == "cs8")
+                format = sample_format::cs8;
+            else {
+                std::cerr << "Unsupported format\n";
+                return 1;
+            }
+        } else if (arg.rfind("--full-scale=", 0) == 0) {
+            full_scale = std::stof(arg.substr(13));
+            if (!(full_scale > 0.0f)) {
+                std::cerr << "Full scale must be positive\n";
+                return 1;
+            }
         } else if (arg.rfind("--out=", 0) == 0) {
             out_path = arg.substr(6);
         } else if (arg == "--stdout") {
@@ -109,11 +142,12 @@ int main(int argc, char** argv) {
         return 1;
     }
 
-    std::vector<std::complex<float>> iq((symbol_count + 2) * N);
-    ssize_t sample_count =
-        modulate(&ws, symbols.data(), symbol_count, iq.data(), iq.size());
-    if (sample_count < 0) {
-        std::cerr << "modulate() failed\n";
+    // Stream the packet through a small buffer instead of synthesising it
+    // whole; the samples are identical to modulate()'s.
+    lora_mod_stream stream;
+    if (lora_mod_stream_init(&stream, symbols.data(), static_cast<size_t>(symbol_count),
+                             params.sf, ws.osr, ws.bw, 1.0f, ws.sync_word, ws.kernels) != 0) {
+        std::cerr << "lora_mod_stream_init() failed\n";
         return 1;
     }
 
@@ -130,11 +164,25 @@ int main(int argc, char** argv) {
         out_stream = &file_stream;
     }
 
-    for (ssize_t i = 0; i < sample_count; ++i) {
-        const float re = iq[i].real();
-        const float im = iq[i].imag();
-        out_stream->write(reinterpret_cast<const char*>(&re), sizeof(float));
-        out_stream->write(reinterpret_cast<const char*>(&im), sizeof(float));
+    // Integer formats are quantised inside the synthesis loop.
+    if (full_scale == 0.0f)
+        full_scale = format == sample_format::cs8 ? CS8_FULL_SCALE : SC16_FULL_SCALE;
+    switch (format) {
+    case sample_format::cf32:
+        write_stream<float>(*out_stream, stream, lora_mod_stream_next);
+        break;
+    case sample_format::sc16:
+        write_stream<int16_t>(*out_stream, stream,
+                              [&](lora_mod_stream* st, std::complex<int16_t>* out, size_t n) {
+                                  return lora_mod_stream_next_sc16(st, out, n, full_scale);
+                              });
+        break;
+    case sample_format::cs8:
+        write_stream<int8_t>(*out_stream, stream,
+                             [&](lora_mod_stream* st, std::complex<int8_t>* out, size_t n) {
+                                 return lora_mod_stream_next_cs8(st, out, n, full_scale);
+                             });
+        break;
     }
 
     if (file_stream.is_open()) file_stream.close();
@@ -1,5 +1,7 @@
 #include <lora_phy/LoRaDetector.hpp>
 #include <lora_phy/phy.hpp>
+#include <lora_phy/nco.hpp>
+#include <lora_phy/demod_common.hpp>
 
 #include <algorithm>
 #include <cmath>
@@ -10,8 +12,11 @@ namespace lora_phy {
 
 void lora_demod_init(lora_demod_workspace* ws, unsigned sf,
                      window_type win,
-                     std::complex<float>* scratch,
-                     size_t max_samples)
+                     std::complex<float>* /*scratch*/,
+                     size_t /*max_samples*/,
+                     cpu_backend backend,
+                     fft_planning planning,
+                     metrics_level metrics)
 {
     ws->N = size_t(1) << sf;
     ws->window_kind = win;
@@ -24,12 +29,32 @@ void lora_demod_init(lora_demod_workspace* ws, unsigned sf,
     } else {
         for (size_t i = 0; i < ws->N; ++i) ws->window[i] = 1.0f;
     }
-    kissfft<float>::init(ws->fft_plan, ws->N, false);
-    ws->fft = new (ws->fft_buf) kissfft<float>(ws->fft_plan);
+    ws->symbol_metrics = metrics;
+    ws->kernels = get_dsp_kernels(backend);
+    if (!ws->kernels) ws->kernels = get_dsp_kernels(cpu_backend::automatic);
+#if LORA_PHY_EMBEDDED_PLANS
+    plan_fft(ws->fft_plan_storage, static_cast<int>(ws->N), false,
+             ws->fft_plan_storage.twiddle_storage, ws->fft_plan_storage.bitrev_storage,
+             planning, ws->kernels);
+    ws->fft_plan = &ws->fft_plan_storage;
+#else
+    ws->fft_plan = shared_fft_plan(static_cast<int>(ws->N), false, planning, ws->kernels);
+#endif
+    ws->fft = new (ws->fft_buf) kissfft<float>(*ws->fft_plan, ws->kernels->fft_radix4,
+                                               ws->kernels->fft_radix4_batch);
     ws->detector =
-        new (ws->detector_buf) LoRaDetector<float>(ws->N, ws->fft_in, ws->fft_out, *ws->fft);
-    ws->scratch = scratch;
-    ws->scratch_len = max_samples;
+        new (ws->detector_buf) LoRaDetector<float>(ws->N, ws->fft_in, ws->fft_out, *ws->fft,
+                                                   ws->kernels->mag2_argmax);
+#if LORA_PHY_EMBEDDED_PLANS
+    kissfft<int16_t>::init(ws->q15_plan_storage, static_cast<int>(ws->N), false);
+    ws->q15_plan = &ws->q15_plan_storage;
+#else
+    ws->q15_plan = shared_fft_plan_q15(static_cast<int>(ws->N), false);
+#endif
+    ws->q15_fft = new (ws->q15_fft_buf) kissfft<int16_t>(*ws->q15_plan,
+                                                         ws->kernels->fft_radix4_q15);
+    ws->q15_detector = new (ws->q15_detector_buf)
+        LoRaDetector<int16_t>(ws->N, ws->q15_in, nullptr, *ws->q15_fft, nullptr, metrics);
 }
 
 void lora_demod_free(lora_demod_workspace* ws)
@@ -42,41 +67,46 @@ void lora_demod_free(lora_demod_workspace* ws)
         ws->fft->~kissfft<float>();
         ws->fft = nullptr;
     }
+    if (ws->q15_detector) {
+        ws->q15_detector->~LoRaDetector<int16_t>();
+        ws->q15_detector = nullptr;
+    }
+    if (ws->q15_fft) {
+        ws->q15_fft->~kissfft<int16_t>();
+        ws->q15_fft = nullptr;
+    }
+    ws->fft_plan = nullptr;
+    ws->q15_plan = nullptr;
     ws->N = 0;
-    ws->scratch = nullptr;
-    ws->scratch_len = 0;
 }
 
-ssize_t lora_demodulate(lora_demod_workspace* ws,
-                       const std::complex<float>* samples, size_t sample_count,
-                       uint16_t* out_symbols, unsigned osr,
-                       uint8_t* out_sync)
+cpu_backend lora_demod_backend(const lora_demod_workspace* ws)
 {
-    const size_t N = ws->N;                    // base samples per symbol
-    const size_t step = N * osr;                // oversampled samples per symbol
-    const size_t total_symbols = sample_count / step;
-    const bool have_sync = total_symbols >= 2;
+    return ws->kernels ? ws->kernels->backend : cpu_backend::scalar;
+}
 
-    // Ensure incoming samples fit within the canonical [-1.0, 1.0] range.
-    const std::complex<float>* norm_samples = samples;
-    float max_amp = 0.0f;
-    for (size_t i = 0; i < sample_count; ++i) {
-        float r = std::abs(samples[i].real());
-        float im = std::abs(samples[i].imag());
-        float m = std::max(r, im);
-        if (m > max_amp) max_amp = m;
-    }
-    if (max_amp > 1.0f) {
-        if (!ws->scratch || ws->scratch_len < sample_count) {
-            return -ERANGE;
-        }
-        float scale = 1.0f / max_amp;
-        for (size_t i = 0; i < sample_count; ++i) {
-            ws->scratch[i] = samples[i] * scale;
-        }
-        norm_samples = ws->scratch;
-    }
+namespace {
+
+inline std::complex<float> to_float(const std::complex<float>& x)
+{
+    return x;
+}
 
+inline std::complex<float> to_float(const std::complex<int16_t>& x)
+{
+    return std::complex<float>(x.real(), x.imag()) * (1.0f / 32768.0f);
+}
+
+// Timing offset and CFO from the first (up to) two symbols, which are
+// examined at every polyphase offset, into ws->metrics.  The detector runs
+// with full metrics here; callers pick the payload level afterwards.
+template <typename Sample>
+void estimate_timing(lora_demod_workspace* ws, const Sample* samples,
+                     size_t total_symbols, unsigned osr)
+{
+    ws->detector->setMetrics(metrics_level::full);
+    const size_t N = ws->N;
+    const size_t step = N * osr;
     const size_t est_syms = std::min(total_symbols, size_t(2));
     float sum_index = 0.0f;
     float phase_diff = 0.0f;
@@ -84,7 +114,7 @@ ssize_t lora_demodulate(lora_demod_workspace* ws,
     bool have_prev = false;
     unsigned sum_t = 0;
     for (size_t s = 0; s < est_syms; ++s) {
-        const std::complex<float>* sym_base = norm_samples + s * step;
+        const Sample* sym_base = samples + s * step;
         float best_p = -1e30f;
         size_t best_idx = 0;
         float best_fi = 0.0f;
@@ -92,7 +122,7 @@ ssize_t lora_demodulate(lora_demod_workspace* ws,
         std::complex<float> best_bin;
         for (unsigned t = 0; t < osr; ++t) {
             for (size_t i = 0; i < N; ++i) {
-                std::complex<float> samp = sym_base[t + i * osr];
+                std::complex<float> samp = to_float(sym_base[t + i * osr]);
                 if (ws->window_kind != window_type::window_none)
                     samp *= ws->window[i];
                 ws->detector->feed(i, samp);
@@ -110,6 +140,17 @@ ssize_t lora_demodulate(lora_demod_workspace* ws,
                 best_bin = ws->fft_out[idx];
             }
         }
+        // Sub-bin refinement by zoom DFT on the winning phase, which is
+        // still in fft_in when it was the last one examined.
+        if (best_t != osr - 1) {
+            for (size_t i = 0; i < N; ++i) {
+                std::complex<float> samp = to_float(sym_base[best_t + i * osr]);
+                if (ws->window_kind != window_type::window_none)
+                    samp *= ws->window[i];
+                ws->detector->feed(i, samp);
+            }
+        }
+        best_fi = ws->detector->refine(best_idx);
         sum_t += best_t;
         sum_index += static_cast<float>(best_idx) + best_fi;
         float phase = std::arg(best_bin);
@@ -134,63 +175,218 @@ ssize_t lora_demodulate(lora_demod_workspace* ws,
     float avg_t = static_cast<float>(sum_t) / static_cast<float>(est_syms);
     ws->metrics.time_offset = avg_t -
                               frac * static_cast<float>(N) * static_cast<float>(osr);
+    ws->metrics.peak_power = 0.0f;
+    ws->metrics.noise_power = 0.0f;
+    ws->metrics.snr = 0.0f;
+    ws->metrics.rssi = 0.0f;
+}
+
+// Payload symbol power and noise floor sums for detail::payload_metrics().
+struct power_sums {
+    float peak{};
+    float noise{};
+    size_t count{};
+
+    void add(float p, float pav)
+    {
+        peak += p;
+        noise += pav;
+        ++count;
+    }
+
+    void store(lora_demod_workspace* ws, metrics_level level) const
+    {
+        detail::payload_metrics(ws->metrics, level, peak, noise, count);
+    }
+};
+
+// Per-symbol quality from the detector metrics and the spectrum.
+template <typename Type>
+void fill_quality(lora_symbol_quality& q, const LoRaDetector<Type>& det,
+                  const std::complex<Type>* spectrum, size_t stride, float power, float noise)
+{
+    q.peak_power = power;
+    q.noise_power = noise;
+    q.peak_to_second = det.peakToSecond(spectrum, stride);
+}
+
+} // namespace
+
+ssize_t lora_demodulate(lora_demod_workspace* ws,
+                       const std::complex<float>* samples, size_t sample_count,
+                       uint16_t* out_symbols, unsigned osr,
+                       uint8_t* out_sync,
+                       lora_peak* out_peaks,
+                       size_t peaks_per_symbol,
+                       float* out_llrs,
+                       lora_symbol_quality* out_quality)
+{
+    if (out_peaks && peaks_per_symbol > MAX_DEMOD_PEAKS) return -EINVAL;
+
+    const size_t N = ws->N;                    // base samples per symbol
+    const size_t step = N * osr;                // oversampled samples per symbol
+    const size_t total_symbols = sample_count / step;
+    const bool have_sync = total_symbols >= 2;
+
+    // Samples are used at their own scale: decisions, LLRs and SNR are
+    // ratios, so only the reported powers follow the input level.
+    estimate_timing(ws, samples, total_symbols, osr);
+    const metrics_level level = out_quality ? metrics_level::full : ws->symbol_metrics;
+    ws->detector->setMetrics(level);
 
     int t_off = static_cast<int>(std::round(ws->metrics.time_offset));
-    float rate = -2.0f * PI * ws->metrics.cfo / static_cast<float>(N);
+    const double rate = -2.0 * PI_D * ws->metrics.cfo /
+                        static_cast<double>(N);
+    nco osc(ws->kernels, rate);
+    const bool windowed = ws->window_kind != window_type::window_none;
+    // Payload symbols are batched through the workspace's own MAX_N buffers:
+    // fft_in carries `count` interleaved symbols and fft_out receives their
+    // spectra, so a batch of K symbols needs K*N <= MAX_N.  Before the FFT
+    // runs, fft_out holds each dechirped symbol before it is interleaved.
+    const size_t batch = std::max<size_t>(1, std::min(ws->MAX_N / N, MAX_DEMOD_BATCH));
+    size_t idx[MAX_DEMOD_BATCH];
+    float power[MAX_DEMOD_BATCH], power_avg[MAX_DEMOD_BATCH], findex[MAX_DEMOD_BATCH];
+    const bool want_power = level != metrics_level::none;
+    power_sums sums;
+    uint16_t sw0 = 0, sw1 = 0;
+    size_t out_idx = 0;
+    for (size_t s0 = 0; s0 < total_symbols; s0 += batch) {
+        const size_t count = std::min(batch, total_symbols - s0);
+        for (size_t b = 0; b < count; ++b) {
+            const size_t s = s0 + b;
+            const size_t base = detail::symbol_base(s, step, t_off, sample_count);
+            const std::complex<float>* sym_samps = samples + base;
+            // Input arrives dechirped, so only the CFO derotation and the
+            // real window remain.  Batched symbols land in fft_out first,
+            // which detectBatch() overwrites with the spectra afterwards.
+            osc.seek(rate * (static_cast<double>(s * N) +
+                             static_cast<double>(t_off) / static_cast<double>(osr)));
+            if (count == 1) {
+                osc.mix(ws->fft_in, sym_samps, osr, N);
+                if (windowed) {
+                    for (size_t i = 0; i < N; ++i)
+                        ws->fft_in[i] *= ws->window[i];
+                }
+                continue;
+            }
+            osc.mix(ws->fft_out, sym_samps, osr, N);
+            if (windowed) {
+                for (size_t i = 0; i < N; ++i)
+                    ws->fft_in[i * count + b] = ws->fft_out[i] * ws->window[i];
+            } else {
+                for (size_t i = 0; i < N; ++i)
+                    ws->fft_in[i * count + b] = ws->fft_out[i];
+            }
+        }
+        if (count == 1) {
+            idx[0] = ws->detector->detect(power[0], power_avg[0], findex[0]);
+        } else if (want_power) {
+            ws->detector->detectBatch(ws->fft_in, ws->fft_out, count, idx, power, power_avg,
+                                      findex);
+        } else {
+            ws->detector->detectBatch(ws->fft_in, ws->fft_out, count, idx);
+        }
+        for (size_t b = 0; b < count; ++b) {
+            const size_t s = s0 + b;
+            if (have_sync && s == 0)
+                sw0 = static_cast<uint16_t>(idx[b]);
+            else if (have_sync && s == 1)
+                sw1 = static_cast<uint16_t>(idx[b]);
+            else {
+                if (out_peaks) {
+                    // Spectra sit in fft_out with stride count (1 unbatched).
+                    lora_peak* peaks = out_peaks + out_idx * peaks_per_symbol;
+                    const size_t found = ws->detector->findPeaks(ws->fft_out + b, count,
+                                                                 peaks_per_symbol, peaks);
+                    for (size_t j = found; j < peaks_per_symbol; ++j) peaks[j] = lora_peak{};
+                }
+                if (out_llrs) {
+                    const unsigned bits = ws->detector->bitsPerSymbol();
+                    ws->detector->softBits(ws->fft_out + b, count, out_llrs + out_idx * bits);
+                }
+                if (out_quality)
+                    fill_quality(out_quality[out_idx], *ws->detector, ws->fft_out + b, count,
+                                 power[b], power_avg[b]);
+                if (want_power) sums.add(power[b], power_avg[b]);
+                out_symbols[out_idx++] = static_cast<uint16_t>(idx[b]);
+            }
+        }
+    }
+    sums.store(ws, level);
+
+    if (out_sync) *out_sync = have_sync ? detail::pack_sync(N, sw0, sw1) : 0;
+
+    return have_sync ? static_cast<ssize_t>(out_idx)
+                     : static_cast<ssize_t>(total_symbols);
+}
+
+ssize_t lora_demodulate_sc16(lora_demod_workspace* ws,
+                             const std::complex<int16_t>* samples, size_t sample_count,
+                             uint16_t* out_symbols, unsigned osr,
+                             uint8_t* out_sync,
+                             float* out_llrs,
+                             lora_symbol_quality* out_quality)
+{
+    const size_t N = ws->N;
+    const size_t step = N * osr;
+    const size_t total_symbols = sample_count / step;
+    const bool have_sync = total_symbols >= 2;
+
+    estimate_timing(ws, samples, total_symbols, osr);
+    const metrics_level level = out_quality ? metrics_level::full : ws->symbol_metrics;
+    ws->q15_detector->setMetrics(level);
+
+    int t_off = static_cast<int>(std::round(ws->metrics.time_offset));
+    const double rate = -2.0 * PI_D * ws->metrics.cfo /
+                        static_cast<double>(N);
+    nco osc(ws->kernels, rate);
+    const bool windowed = ws->window_kind != window_type::window_none;
+    power_sums sums;
     uint16_t sw0 = 0, sw1 = 0;
     size_t out_idx = 0;
     for (size_t s = 0; s < total_symbols; ++s) {
-        size_t base = s * step;
-        if (t_off > 0) {
-            if (base + size_t(t_off) + step <= sample_count)
-                base += size_t(t_off);
-        } else if (t_off < 0) {
-            size_t off = size_t(-t_off);
-            if (off <= base) base -= off;
+        const size_t base = detail::symbol_base(s, step, t_off, sample_count);
+        const std::complex<int16_t>* sym_samps = samples + base;
+        // The float phasors (window folded in) are quantised to Q15 a block
+        // at a time and dechirp the int16 samples straight into q15_in.
+        osc.seek(rate * (static_cast<double>(s * N) +
+                         static_cast<double>(t_off) / static_cast<double>(osr)));
+        osc.generate(ws->fft_out, N);
+        if (windowed) {
+            for (size_t i = 0; i < N; ++i)
+                ws->fft_out[i] *= ws->window[i];
         }
-        const std::complex<float>* sym_samps = norm_samples + base;
-        float start = rate * (static_cast<float>(s * N) +
-                              static_cast<float>(t_off) / static_cast<float>(osr));
-        for (size_t i = 0; i < N; ++i) {
-            float ph = start + rate * static_cast<float>(i);
-            float cs = std::cos(ph);
-            float sn = std::sin(ph);
-            std::complex<float> samp = sym_samps[i * osr] *
-                                       std::complex<float>(cs, sn);
-            if (ws->window_kind != window_type::window_none)
-                samp *= ws->window[i];
-            ws->detector->feed(i, samp);
+        std::complex<int16_t> ph[64];
+        for (size_t i = 0; i < N; i += 64) {
+            const size_t block = std::min<size_t>(64, N - i);
+            for (size_t j = 0; j < block; ++j) {
+                const std::complex<float> p = ws->fft_out[i + j];
+                ph[j] = std::complex<int16_t>(kissfft_utils::q15_unit(p.real()),
+                                              kissfft_utils::q15_unit(p.imag()));
+            }
+            ws->kernels->cmul_q15(ws->q15_in + i, sym_samps + i * osr, osr, ph, block);
         }
         float p, pav, findex;
-        size_t idx = ws->detector->detect(p, pav, findex);
-        if (have_sync) {
-            if (s == 0)
-                sw0 = static_cast<uint16_t>(idx);
-            else if (s == 1)
-                sw1 = static_cast<uint16_t>(idx);
-            else
-                out_symbols[out_idx++] = static_cast<uint16_t>(idx);
-        } else {
-            out_symbols[out_idx++] = static_cast<uint16_t>(idx);
-        }
-    }
-
-    if (out_sync) {
-        if (have_sync) {
-            unsigned sf_bits = 0;
-            size_t tmp = N;
-            while (tmp > 1) {
-                tmp >>= 1;
-                ++sf_bits;
+        const uint16_t idx = static_cast<uint16_t>(ws->q15_detector->detect(p, pav, findex));
+        if (have_sync && s == 0)
+            sw0 = idx;
+        else if (have_sync && s == 1)
+            sw1 = idx;
+        else {
+            if (out_llrs) {
+                // the spectrum replaced the symbol in q15_in
+                const unsigned bits = ws->q15_detector->bitsPerSymbol();
+                ws->q15_detector->softBits(ws->q15_in, 1, out_llrs + out_idx * bits);
             }
-            unsigned shift = sf_bits > 4 ? (sf_bits - 4) : 0;
-            uint8_t hi = static_cast<uint8_t>(sw0 >> shift) & 0x0f;
-            uint8_t lo = static_cast<uint8_t>(sw1 >> shift) & 0x0f;
-            *out_sync = static_cast<uint8_t>((hi << 4) | lo);
-        } else {
-            *out_sync = 0;
+            if (out_quality)
+                fill_quality(out_quality[out_idx], *ws->q15_detector, ws->q15_in, 1, p, pav);
+            sums.add(p, pav);
+            out_symbols[out_idx++] = idx;
         }
     }
+    sums.store(ws, level);
+
+    if (out_sync) *out_sync = have_sync ? detail::pack_sync(N, sw0, sw1) : 0;
 
     return have_sync ? static_cast<ssize_t>(out_idx)
                      : static_cast<ssize_t>(total_symbols);
@@ -1,46 +1,324 @@
 #include <algorithm>
+#include <cerrno>
 #include <cmath>
+#include <limits>
 #include <lora_phy/ChirpGenerator.hpp>
 #include <lora_phy/phy.hpp>
 
 namespace lora_phy {
 
+namespace {
+
+// Length of the stream's next block: up to 64 samples, never crossing a
+// symbol, so the chirp is staged exactly as genChirp() stages it.
+size_t next_block_len(const lora_mod_stream* st)
+{
+    if (st->symbol >= st->symbol_count + 2) return 0;
+    const size_t step = (size_t(1) << st->sf) * st->osr;
+    return std::min<size_t>(64, step - st->offset);
+}
+
+void render_block(lora_mod_stream* st, std::complex<float>* dst, size_t len)
+{
+    const size_t N = size_t(1) << st->sf;
+    const size_t step = N * st->osr;
+    const uint16_t value =
+        st->symbol < 2 ? st->sync_symbols[st->symbol] : st->symbols[st->symbol - 2];
+    const float f0 = (2.0f * PI * value * st->bw_scale) /
+                     (float(N) * static_cast<float>(st->osr));
+    genChirpSegment(dst, static_cast<int>(N), static_cast<int>(st->osr),
+                    static_cast<int>(len), f0, false, st->amplitude, st->phase, st->freq,
+                    st->offset == 0, st->bw_scale, st->polar);
+    st->offset += len;
+    if (st->offset == step) {
+        // genChirp()'s wrap at the end of every symbol.
+        st->phase -= floor(st->phase / (2 * PI)) * 2 * PI;
+        st->offset = 0;
+        ++st->symbol;
+    }
+}
+
+// Round to nearest (half away from zero) and saturate; written without
+// library calls so the block loop vectorises.
+template <typename T>
+inline T quantize(float x, float full_scale)
+{
+    const float hi = static_cast<float>(std::numeric_limits<T>::max());
+    const float lo = static_cast<float>(std::numeric_limits<T>::min());
+    const float v = std::min(hi, std::max(lo, x * full_scale));
+    return static_cast<T>(v + (v < 0.0f ? -0.5f : 0.5f));
+}
+
+// Synthesise a 64-sample block on the stack and quantise it while it is
+// still in cache.
+template <typename T>
+size_t stream_next_quantized(lora_mod_stream* st, std::complex<T>* out,
+                             size_t max_samples, float full_scale)
+{
+    if (!st || !out || !(full_scale > 0.0f)) return 0;
+    std::complex<float> block[64];
+    size_t done = 0;
+    while (done < max_samples) {
+        const size_t n = lora_mod_stream_next(st, block, std::min<size_t>(64, max_samples - done));
+        if (n == 0) break;
+        for (size_t i = 0; i < n; ++i)
+            out[done + i] = std::complex<T>(quantize<T>(block[i].real(), full_scale),
+                                            quantize<T>(block[i].imag(), full_scale));
+        done += n;
+    }
+    return done;
+}
+
+template <typename T>
+size_t modulate_quantized(const uint16_t* symbols, size_t symbol_count,
+                          std::complex<T>* out_samples, unsigned sf, unsigned osr,
+                          bandwidth bw, float full_scale, uint8_t sync,
+                          const dsp_kernels* kernels)
+{
+    lora_mod_stream st;
+    if (lora_mod_stream_init(&st, symbols, symbol_count, sf, osr, bw, 1.0f, sync,
+                             kernels) != 0)
+        return 0;
+    return stream_next_quantized(&st, out_samples, lora_mod_stream_remaining(&st), full_scale);
+}
+
+} // namespace
+
+int lora_mod_stream_init(lora_mod_stream* st, const uint16_t* symbols,
+                         size_t symbol_count, unsigned sf, unsigned osr,
+                         bandwidth bw, float amplitude, uint8_t sync,
+                         const dsp_kernels* kernels)
+{
+    if (!st || (!symbols && symbol_count) || sf > 12 || osr == 0) return -EINVAL;
+    *st = lora_mod_stream{};
+    st->symbols = symbols;
+    st->symbol_count = symbol_count;
+    unsigned shift = sf > 4 ? (sf - 4) : 0;
+    st->sync_symbols[0] = static_cast<uint16_t>((sync >> 4) << shift);
+    st->sync_symbols[1] = static_cast<uint16_t>((sync & 0x0f) << shift);
+    st->sf = sf;
+    st->osr = osr;
+    st->bw_scale = lora_phy::bw_scale(bw);
+    // Clamp user requested amplitude to the canonical IQ range of [-1.0, 1.0].
+    st->amplitude = std::max(-1.0f, std::min(1.0f, amplitude));
+    st->polar = kernels ? kernels->polar : nullptr;
+    return 0;
+}
+
+size_t lora_mod_stream_next(lora_mod_stream* st, std::complex<float>* out,
+                            size_t max_samples)
+{
+    if (!st || !out) return 0;
+    size_t done = 0;
+    while (done < max_samples) {
+        if (st->pending_pos < st->pending_len) {
+            const size_t n = std::min(st->pending_len - st->pending_pos, max_samples - done);
+            std::copy_n(st->pending + st->pending_pos, n, out + done);
+            st->pending_pos += n;
+            done += n;
+            continue;
+        }
+        const size_t len = next_block_len(st);
+        if (len == 0) break;
+        // Whole blocks go straight to the caller; a block the call ends
+        // inside is parked in the state and handed out next time.
+        if (max_samples - done >= len) {
+            render_block(st, out + done, len);
+            done += len;
+        } else {
+            render_block(st, st->pending, len);
+            st->pending_pos = 0;
+            st->pending_len = len;
+        }
+    }
+    return done;
+}
+
+size_t lora_mod_stream_next_sc16(lora_mod_stream* st, std::complex<int16_t>* out,
+                                 size_t max_samples, float full_scale)
+{
+    return stream_next_quantized(st, out, max_samples, full_scale);
+}
+
+size_t lora_mod_stream_next_cs8(lora_mod_stream* st, std::complex<int8_t>* out,
+                                size_t max_samples, float full_scale)
+{
+    return stream_next_quantized(st, out, max_samples, full_scale);
+}
+
+size_t lora_mod_stream_remaining(const lora_mod_stream* st)
+{
+    if (!st) return 0;
+    const size_t step = (size_t(1) << st->sf) * st->osr;
+    return (st->symbol_count + 2 - std::min(st->symbol, st->symbol_count + 2)) * step -
+           st->offset + (st->pending_len - st->pending_pos);
+}
+
 size_t lora_modulate(const uint16_t* symbols, size_t symbol_count,
                      std::complex<float>* out_samples, unsigned sf, unsigned osr,
-                     bandwidth bw, float amplitude, uint8_t sync)
+                     bandwidth bw, float amplitude, uint8_t sync,
+                     const dsp_kernels* kernels)
 {
-    const size_t N = size_t(1) << sf; // base samples per symbol
+    lora_mod_stream st;
+    if (lora_mod_stream_init(&st, symbols, symbol_count, sf, osr, bw, amplitude, sync,
+                             kernels) != 0)
+        return 0;
+    return lora_mod_stream_next(&st, out_samples, lora_mod_stream_remaining(&st));
+}
+
+size_t lora_frame_header_len(unsigned sf, unsigned osr, unsigned preamble_len,
+                             unsigned sfd_quarters)
+{
+    const size_t step = (size_t(1) << sf) * osr;
+    return (size_t(preamble_len) + 2) * step + size_t(sfd_quarters) * step / 4;
+}
+
+size_t lora_frame_header(std::complex<float>* out, unsigned sf, unsigned osr,
+                         bandwidth bw, unsigned preamble_len, unsigned sfd_quarters,
+                         float amplitude, uint8_t sync, const dsp_kernels* kernels,
+                         float* end_phase)
+{
+    if (!out || sf > 12 || osr == 0) return 0;
+    const size_t N = size_t(1) << sf;
     const size_t step = N * osr;
+    const float scale = bw_scale(bw);
+    const auto polar = kernels ? kernels->polar : nullptr;
+    amplitude = std::max(-1.0f, std::min(1.0f, amplitude));
+    unsigned shift = sf > 4 ? (sf - 4) : 0;
+    const uint16_t sync_symbols[2] = {static_cast<uint16_t>((sync >> 4) << shift),
+                                      static_cast<uint16_t>((sync & 0x0f) << shift)};
+
     float phase = 0.0f;
-    const float bw_scale = lora_phy::bw_scale(bw);
+    std::complex<float>* dst = out;
+    for (unsigned p = 0; p < preamble_len; ++p, dst += step)
+        genChirp(dst, static_cast<int>(N), static_cast<int>(osr), static_cast<int>(step), 0.0f,
+                 false, amplitude, phase, scale, polar);
+    for (uint16_t value : sync_symbols) {
+        const float f0 = (2.0f * PI * value * scale) / (float(N) * static_cast<float>(osr));
+        genChirp(dst, static_cast<int>(N), static_cast<int>(osr), static_cast<int>(step), f0,
+                 false, amplitude, phase, scale, polar);
+        dst += step;
+    }
+    // The SFD is one continuous downchirp sweep; the fractional quarter
+    // ends mid symbol.
+    const size_t sfd = size_t(sfd_quarters) * step / 4;
+    genChirp(dst, static_cast<int>(N), static_cast<int>(osr), static_cast<int>(sfd), 0.0f, true,
+             amplitude, phase, scale, polar);
+    if (end_phase) *end_phase = phase;
+    return static_cast<size_t>(dst + sfd - out);
+}
 
-    // Clamp user requested amplitude to the canonical IQ range of [-1.0, 1.0].
+size_t lora_modulate_payload(const uint16_t* symbols, size_t symbol_count,
+                             std::complex<float>* out_samples, unsigned sf, unsigned osr,
+                             bandwidth bw, float phase, float amplitude,
+                             const dsp_kernels* kernels)
+{
+    lora_mod_stream st;
+    if (lora_mod_stream_init(&st, symbols, symbol_count, sf, osr, bw, amplitude, 0,
+                             kernels) != 0)
+        return 0;
+    // Skip the sync word and pick the chirp up where the caller left it.
+    st.symbol = 2;
+    st.phase = phase;
+    return lora_mod_stream_next(&st, out_samples, lora_mod_stream_remaining(&st));
+}
+
+size_t lora_modulate_frame(const uint16_t* symbols, size_t symbol_count,
+                           std::complex<float>* out_samples, unsigned sf, unsigned osr,
+                           bandwidth bw, unsigned preamble_len, unsigned sfd_quarters,
+                           float amplitude, uint8_t sync, const dsp_kernels* kernels)
+{
+    float phase = 0.0f;
+    const size_t hdr = lora_frame_header(out_samples, sf, osr, bw, preamble_len, sfd_quarters,
+                                         amplitude, sync, kernels, &phase);
+    if (hdr == 0) return 0;
+    return hdr + lora_modulate_payload(symbols, symbol_count, out_samples + hdr, sf, osr, bw,
+                                       phase, amplitude, kernels);
+}
+
+size_t lora_modulate_sc16(const uint16_t* symbols, size_t symbol_count,
+                          std::complex<int16_t>* out_samples, unsigned sf, unsigned osr,
+                          bandwidth bw, float full_scale, uint8_t sync,
+                          const dsp_kernels* kernels)
+{
+    return modulate_quantized(symbols, symbol_count, out_samples, sf, osr, bw, full_scale,
+                              sync, kernels);
+}
+
+size_t lora_modulate_cs8(const uint16_t* symbols, size_t symbol_count,
+                         std::complex<int8_t>* out_samples, unsigned sf, unsigned osr,
+                         bandwidth bw, float full_scale, uint8_t sync,
+                         const dsp_kernels* kernels)
+{
+    return modulate_quantized(symbols, symbol_count, out_samples, sf, osr, bw, full_scale,
+                              sync, kernels);
+}
+
+int lora_chirp_table_init(lora_chirp_table* table, std::complex<float>* buf,
+                          size_t buf_len, unsigned sf, unsigned osr, bandwidth bw)
+{
+    if (!table || !buf || sf > 12 || osr == 0) return -EINVAL;
+    const size_t N = size_t(1) << sf;
+    const size_t len = N * osr;
+    if (buf_len < len) return -ERANGE;
+
+    // genChirp steps the frequency from fMin by fStep before adding it to
+    // the phase, so after sample k (n = k + 1 steps) the phase is
+    // n*fMin + fStep*n*(n+1)/2.  A symbol of value v starts v*osr steps
+    // further along the same sweep and wraps back to the start.
+    const double pi = std::acos(-1.0);
+    const double scale = static_cast<double>(bw_scale(bw));
+    const double f_min = -pi * scale / osr;
+    const double f_step = 2.0 * pi * scale / (double(N) * osr * osr);
+    for (size_t k = 0; k < len; ++k) {
+        const double n = static_cast<double>(k + 1);
+        const double phase = std::fmod(n * f_min + f_step * n * (n + 1.0) / 2.0, 2.0 * pi);
+        buf[k] = std::complex<float>(static_cast<float>(std::cos(phase)),
+                                     static_cast<float>(std::sin(phase)));
+    }
+    table->samples = buf;
+    table->len = len;
+    table->sf = sf;
+    table->osr = osr;
+    table->bw = bw;
+    return 0;
+}
+
+size_t lora_modulate_table(const lora_chirp_table* table,
+                           const uint16_t* symbols, size_t symbol_count,
+                           std::complex<float>* out_samples,
+                           float amplitude, uint8_t sync,
+                           const dsp_kernels* kernels)
+{
+    const dsp_kernels* k = kernels ? kernels : get_dsp_kernels(cpu_backend::scalar);
+    const std::complex<float>* base = table->samples;
+    const size_t len = table->len;
     amplitude = std::max(-1.0f, std::min(1.0f, amplitude));
 
-    unsigned shift = sf > 4 ? (sf - 4) : 0;
+    unsigned shift = table->sf > 4 ? (table->sf - 4) : 0;
     const uint16_t sw0 = static_cast<uint16_t>((sync >> 4) << shift);
     const uint16_t sw1 = static_cast<uint16_t>((sync & 0x0f) << shift);
 
-    const float f0 = (2.0f * PI * sw0 * bw_scale) /
-                     (float(N) * static_cast<float>(osr));
-    genChirp(out_samples, static_cast<int>(N), static_cast<int>(osr),
-             static_cast<int>(step), f0, false, amplitude, phase, bw_scale);
-
-    const float f1 = (2.0f * PI * sw1 * bw_scale) /
-                     (float(N) * static_cast<float>(osr));
-    genChirp(out_samples + step, static_cast<int>(N), static_cast<int>(osr),
-             static_cast<int>(step), f1, false, amplitude, phase, bw_scale);
-
+    // Symbol v at phase p is base[(i + d) % len] (d = v*osr) times
+    // exp(j*(p - phase(d-1))) up to the wrap and that times the full sweep
+    // base[len-1] after it; the sweep also carries p into the next symbol.
+    const std::complex<float> sweep = base[len - 1];
+    std::complex<float> rot(1.0f, 0.0f);
+    auto emit = [&](uint16_t value, std::complex<float>* dst) {
+        const size_t d = (static_cast<size_t>(value) * table->osr) % len;
+        std::complex<float> c = amplitude * rot;
+        if (d > 0) c *= std::conj(base[d - 1]);
+        k->cmul(dst, &c, 0, base + d, len - d);
+        c *= sweep;
+        k->cmul(dst + len - d, &c, 0, base, d);
+        rot *= sweep;
+        rot /= std::abs(rot);
+    };
+    emit(sw0, out_samples);
+    emit(sw1, out_samples + len);
     for (size_t s = 0; s < symbol_count; ++s)
-    {
-        const float freq = (2.0f * PI * symbols[s] * bw_scale) /
-                           (float(N) * static_cast<float>(osr));
-        genChirp(out_samples + (s + 2) * step, static_cast<int>(N),
-                 static_cast<int>(osr), static_cast<int>(step), freq, false,
-                 amplitude, phase, bw_scale);
-    }
-    return (symbol_count + 2) * step;
+        emit(symbols[s], out_samples + (s + 2) * len);
+    return (symbol_count + 2) * len;
 }
 
 } // namespace lora_phy
-
@@ -0,0 +1,175 @@
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <lora_phy/phy.hpp>
+
+namespace lora_phy {
+
+namespace {
+
+// Phase of channel table sample k: the chirp after k + 1 generator steps
+// (see lora_chirp_table_init()) plus k samples of the channel offset.
+double table_phase(const lora_tx_channel* ch, size_t k)
+{
+    const double scale = static_cast<double>(bw_scale(ch->bw));
+    const double N = static_cast<double>(size_t(1) << ch->sf);
+    const double f_min = -PI_D * scale / ch->osr;
+    const double f_step = 2.0 * PI_D * scale / (N * ch->osr * ch->osr);
+    const double n = static_cast<double>(k + 1);
+    return n * f_min + f_step * n * (n + 1.0) / 2.0 + ch->shift * static_cast<double>(k);
+}
+
+// Phasor of d samples of the shifted chirp from symbol start; d == len is
+// the whole symbol.
+std::complex<double> advance(const lora_tx_channel* ch, size_t d)
+{
+    if (d == 0) return 1.0;
+    return std::polar(1.0, std::fmod(table_phase(ch, d - 1) + ch->shift, 2.0 * PI_D));
+}
+
+// dst[i] += c * src[i], through a stack block for the kernel's multiply.
+void accumulate(const dsp_kernels* k, std::complex<float>* dst, std::complex<float> c,
+                const std::complex<float>* src, size_t n)
+{
+    std::complex<float> block[64];
+    while (n > 0) {
+        const size_t m = std::min<size_t>(64, n);
+        k->cmul(block, &c, 0, src, m);
+        float* d = reinterpret_cast<float*>(dst);
+        const float* b = reinterpret_cast<const float*>(block);
+        for (size_t i = 0; i < 2 * m; ++i) d[i] += b[i];
+        dst += m;
+        src += m;
+        n -= m;
+    }
+}
+
+size_t packet_len(const lora_tx_packet& pkt)
+{
+    return (pkt.symbol_count + 2) * pkt.channel->len;
+}
+
+// Add the samples of packet @p p inside [begin, end) of the stream to
+// @p out, which holds that range.
+void render_packet(lora_wideband_synth* synth, size_t p, std::complex<float>* out,
+                   size_t begin, size_t end)
+{
+    const lora_tx_packet& pkt = synth->packets[p];
+    const lora_tx_channel* ch = pkt.channel;
+    const size_t len = ch->len;
+    if (end <= pkt.start) return;
+    const size_t from = std::max(begin, pkt.start) - pkt.start;
+    const size_t to = std::min(end, pkt.start + packet_len(pkt)) - pkt.start;
+    if (from >= to) return;
+
+    const float amplitude = std::max(-1.0f, std::min(1.0f, pkt.amplitude));
+    unsigned shift = ch->sf > 4 ? (ch->sf - 4) : 0;
+    const uint16_t sync_symbols[2] = {static_cast<uint16_t>((pkt.sync_word >> 4) << shift),
+                                      static_cast<uint16_t>((pkt.sync_word & 0x0f) << shift)};
+    const std::complex<double> sweep = advance(ch, len);
+    std::complex<double>& rot = synth->rot[p];
+
+    // Symbol value v starts d = v*osr samples into the table.  Up to the
+    // wrap the output is table[i + d] times rot/advance(d); after it the
+    // table restarts and the factor gains a whole sweep, which also carries
+    // rot into the next symbol.
+    std::complex<float>* dst = out + (pkt.start + from - begin);
+    for (size_t rel = from; rel < to;) {
+        const size_t s = rel / len;
+        size_t i = rel % len;
+        const size_t stop = std::min(to - s * len, len);
+        const uint16_t value = s < 2 ? sync_symbols[s] : pkt.symbols[s - 2];
+        const size_t d = (static_cast<size_t>(value) * ch->osr) % len;
+        const std::complex<double> c1 = double(amplitude) * rot * std::conj(advance(ch, d));
+        const std::complex<double> c2 = c1 * sweep;
+        if (i < len - d) {
+            const size_t m = std::min(stop, len - d) - i;
+            accumulate(synth->kernels, dst, std::complex<float>(c1), ch->samples + i + d, m);
+            dst += m;
+            i += m;
+        }
+        if (i < stop) {
+            accumulate(synth->kernels, dst, std::complex<float>(c2),
+                       ch->samples + i + d - len, stop - i);
+            dst += stop - i;
+        }
+        rel = s * len + stop;
+        if (stop == len) {
+            rot *= sweep;
+            rot *= 0.5 * (3.0 - std::norm(rot));
+        }
+    }
+}
+
+} // namespace
+
+int lora_tx_channel_init(lora_tx_channel* channel, std::complex<float>* buf,
+                         size_t buf_len, unsigned sf, bandwidth bw,
+                         double sample_rate, double offset_hz)
+{
+    if (!channel || !buf || sf > 12 || !(sample_rate > 0.0)) return -EINVAL;
+    const double bw_hz = static_cast<double>(bw_to_hz(bw));
+    const double osr = std::round(sample_rate / bw_hz);
+    if (osr < 1.0 || std::abs(osr * bw_hz - sample_rate) > 1e-9 * sample_rate)
+        return -EINVAL;
+    if (!(std::abs(offset_hz) + bw_hz / 2.0 <= sample_rate / 2.0)) return -EINVAL;
+    const size_t len = (size_t(1) << sf) * static_cast<size_t>(osr);
+    if (buf_len < len) return -ERANGE;
+
+    lora_tx_channel ch;
+    ch.samples = buf;
+    ch.len = len;
+    ch.sf = sf;
+    ch.osr = static_cast<unsigned>(osr);
+    ch.bw = bw;
+    ch.shift = 2.0 * PI_D * offset_hz / sample_rate;
+    for (size_t k = 0; k < len; ++k) {
+        const double phase = std::fmod(table_phase(&ch, k), 2.0 * PI_D);
+        buf[k] = std::complex<float>(static_cast<float>(std::cos(phase)),
+                                     static_cast<float>(std::sin(phase)));
+    }
+    *channel = ch;
+    return 0;
+}
+
+int lora_wideband_init(lora_wideband_synth* synth, const lora_tx_packet* packets,
+                       size_t packet_count, const dsp_kernels* kernels)
+{
+    if (!synth || (!packets && packet_count) || packet_count > MAX_SYNTH_PACKETS)
+        return -EINVAL;
+    for (size_t p = 0; p < packet_count; ++p) {
+        const lora_tx_packet& pkt = packets[p];
+        if (!pkt.channel || !pkt.channel->samples || pkt.channel->len == 0 ||
+            (!pkt.symbols && pkt.symbol_count))
+            return -EINVAL;
+    }
+    *synth = lora_wideband_synth{};
+    synth->packets = packets;
+    synth->packet_count = packet_count;
+    synth->kernels = kernels ? kernels : get_dsp_kernels(cpu_backend::scalar);
+    std::fill_n(synth->rot, MAX_SYNTH_PACKETS, std::complex<double>(1.0));
+    return 0;
+}
+
+size_t lora_wideband_next(lora_wideband_synth* synth, std::complex<float>* out,
+                          size_t max_samples)
+{
+    if (!synth || !out) return 0;
+    const size_t n = std::min(max_samples, lora_wideband_remaining(synth));
+    std::fill_n(out, n, std::complex<float>());
+    for (size_t p = 0; p < synth->packet_count; ++p)
+        render_packet(synth, p, out, synth->position, synth->position + n);
+    synth->position += n;
+    return n;
+}
+
+size_t lora_wideband_remaining(const lora_wideband_synth* synth)
+{
+    if (!synth) return 0;
+    size_t end = 0;
+    for (size_t p = 0; p < synth->packet_count; ++p)
+        end = std::max(end, synth->packets[p].start + packet_len(synth->packets[p]));
+    return end > synth->position ? end - synth->position : 0;
+}
+
+} // namespace lora_phy
@@ -0,0 +1,1248 @@
+#include <lora_phy/dsp_kernels.hpp>
+#include <lora_phy/kissfft.hh>
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define LORA_PHY_X86_DISPATCH 1
+#include <immintrin.h>
+#endif
+
+// Every vector kernel below is compiled for its own ISA through a function
+// level target attribute rather than per-file -m flags.  That keeps the rest
+// of the library (and any inline std:: code instantiated here) on the
+// baseline ISA, so a wide instruction can only execute once the dispatcher
+// has confirmed host support.  AVX kernels that hand a remainder to
+// an SSE kernel clear the upper register state first: GCC does not emit
+// vzeroupper ahead of such tail calls, and legacy SSE code running with
+// dirty upper halves is penalised on every instruction until the next
+// vzeroupper, including in the caller.
+
+namespace lora_phy {
+
+namespace {
+
+// ---------------------------------------------------------------------------
+// Scalar reference kernels
+// ---------------------------------------------------------------------------
+
+void radix4_scalar(std::complex<float>* x, const std::complex<float>* tw,
+                   std::size_t m, std::size_t n, bool inverse)
+{
+    kissfft_utils::pow2_radix4_pass<float>(x, tw, m, n, inverse);
+}
+
+void radix4_batch_scalar(std::complex<float>* x, const std::complex<float>* tw,
+                         std::size_t m, std::size_t n, std::size_t count, bool inverse)
+{
+    kissfft_utils::pow2_radix4_pass_batch<float>(x, tw, m, n, count, inverse);
+}
+
+void cmul_scalar(std::complex<float>* dst, const std::complex<float>* a,
+                 std::size_t stride, const std::complex<float>* b, std::size_t n)
+{
+    for (std::size_t i = 0; i < n; ++i)
+        dst[i] = kissfft_utils::cmul(a[i * stride], b[i]);
+}
+
+void derotate_scalar(std::complex<float>* dst, const std::complex<float>* a,
+                     std::size_t stride, const std::complex<float>* b,
+                     const std::complex<float>* c, const std::complex<float>* z,
+                     std::size_t n)
+{
+    using kissfft_utils::cmul;
+    for (std::size_t i = 0; i < n; ++i)
+        dst[i] = cmul(a[i * stride], cmul(b[i], cmul(*z, c[i])));
+}
+
+std::size_t argmax_scalar(const std::complex<float>* x, std::size_t n,
+                          float* max_mag2, double* total)
+{
+    std::size_t best = 0;
+    float best_v = 0.0f;
+    double sum = 0.0;
+    for (std::size_t i = 0; i < n; ++i) {
+        const float re = x[i].real();
+        const float im = x[i].imag();
+        const float m2 = re * re + im * im;
+        sum += m2;
+        if (m2 > best_v) {
+            best_v = m2;
+            best = i;
+        }
+    }
+    *max_mag2 = best_v;
+    *total = sum;
+    return best;
+}
+
+void polar_scalar(std::complex<float>* dst, const float* phase, float ampl,
+                  std::size_t n)
+{
+    for (std::size_t i = 0; i < n; ++i)
+        dst[i] = std::polar(ampl, phase[i]);
+}
+
+int radix4_q15_scalar(std::complex<int16_t>* x, const std::complex<int16_t>* tw,
+                      std::size_t m, std::size_t n, bool inverse, int shift)
+{
+    return kissfft_utils::pow2_radix4_pass_q15(x, tw, m, n, inverse, shift);
+}
+
+void cmul_q15_scalar(std::complex<int16_t>* dst, const std::complex<int16_t>* a,
+                     std::size_t stride, const std::complex<int16_t>* b, std::size_t n)
+{
+    for (std::size_t i = 0; i < n; ++i)
+        dst[i] = kissfft_utils::q15_cmul(a[i * stride], b[i]);
+}
+
+#if defined(LORA_PHY_X86_DISPATCH)
+
+// Remaining columns [b, count) of one batched butterfly row set.
+void radix4_batch_tail(std::complex<float>* b0, std::complex<float>* b1,
+                       std::complex<float>* b2, std::complex<float>* b3,
+                       std::complex<float> w1, std::complex<float> w2,
+                       std::size_t b, std::size_t count, bool inverse)
+{
+    using kissfft_utils::cmul;
+    for (; b < count; ++b) {
+        const std::complex<float> t1 = cmul(b1[b], w2);
+        const std::complex<float> t3 = cmul(b3[b], w2);
+        const std::complex<float> e0 = b0[b] + t1;
+        const std::complex<float> e0m = b0[b] - t1;
+        const std::complex<float> u = cmul(b2[b] + t3, w1);
+        const std::complex<float> v = kissfft_utils::rot90(cmul(b2[b] - t3, w1), inverse);
+        b0[b] = e0 + u;
+        b2[b] = e0 - u;
+        b1[b] = e0m + v;
+        b3[b] = e0m - v;
+    }
+}
+
+// One complex value as a 64-bit lane, for broadcasting a twiddle.
+inline double cpx_bits(std::complex<float> w)
+{
+    double d;
+    std::memcpy(&d, &w, sizeof(d));
+    return d;
+}
+
+// Cody-Waite split of pi/2; the first part has 8 significant bits so that
+// j * PIO2_1 is exact for every quadrant count j < 2^16.
+constexpr float PIO2_1 = 1.5703125f;
+constexpr float PIO2_2 = 4.837512969970703125e-4f;
+constexpr float PIO2_3 = 7.549789948768648e-8f;
+constexpr float TWO_OVER_PI = 0.636619772367581343f;
+// Minimax coefficients on [-pi/4, pi/4] (Cephes sinf/cosf).
+constexpr float S1 = -1.6666654611e-1f;
+constexpr float S2 = 8.3321608736e-3f;
+constexpr float S3 = -1.9515295891e-4f;
+constexpr float C1 = 4.166664568298827e-2f;
+constexpr float C2 = -1.388731625493765e-3f;
+constexpr float C3 = 2.443315711809948e-5f;
+
+// Reduce per-lane (max, index) pairs to the overall maximum.  Each lane
+// holds the first index at which it saw its maximum, so resolving equal
+// values to the lowest index reproduces the scalar first-match rule.
+std::size_t reduce_lanes(const float* v, const int32_t* idx, std::size_t lanes,
+                         float* best_v)
+{
+    float bv = v[0];
+    int32_t bi = idx[0];
+    for (std::size_t l = 1; l < lanes; ++l) {
+        if (v[l] > bv || (v[l] == bv && idx[l] < bi)) {
+            bv = v[l];
+            bi = idx[l];
+        }
+    }
+    *best_v = bv;
+    return static_cast<std::size_t>(bi);
+}
+
+// The argmax kernels keep the energy sum in float lanes and fold them into
+// a double only every SUM_BLOCK vectors (blocked pairwise summation): the
+// float error stays within SUM_BLOCK ulp of the block total while the inner
+// loop needs no float to double conversions.
+constexpr std::size_t SUM_BLOCK = 16;
+
+// ---------------------------------------------------------------------------
+// SSE4.2 kernels (128-bit, two complex values per register)
+// ---------------------------------------------------------------------------
+
+__attribute__((target("sse4.2")))
+inline __m128 cmul_sse(__m128 a, __m128 b)
+{
+    const __m128 br = _mm_moveldup_ps(b);
+    const __m128 bi = _mm_movehdup_ps(b);
+    const __m128 as = _mm_shuffle_ps(a, a, _MM_SHUFFLE(2, 3, 0, 1));
+    return _mm_addsub_ps(_mm_mul_ps(a, br), _mm_mul_ps(as, bi));
+}
+
+__attribute__((target("sse4.2")))
+inline __m128 rot90_sse(__m128 a, bool inverse)
+{
+    const __m128 sw = _mm_shuffle_ps(a, a, _MM_SHUFFLE(2, 3, 0, 1));
+    const __m128 neg_re = _mm_castsi128_ps(
+        _mm_set_epi32(0, int(0x80000000u), 0, int(0x80000000u)));
+    const __m128 neg_im = _mm_castsi128_ps(
+        _mm_set_epi32(int(0x80000000u), 0, int(0x80000000u), 0));
+    return _mm_xor_ps(sw, inverse ? neg_re : neg_im);
+}
+
+__attribute__((target("sse4.2")))
+inline void radix4_block_sse(float* b0, float* b1, float* b2, float* b3,
+                             __m128 vw1, __m128 vw2, bool inverse)
+{
+    const __m128 a0 = _mm_loadu_ps(b0);
+    const __m128 t1 = cmul_sse(_mm_loadu_ps(b1), vw2);
+    const __m128 a2 = _mm_loadu_ps(b2);
+    const __m128 t3 = cmul_sse(_mm_loadu_ps(b3), vw2);
+    const __m128 e0 = _mm_add_ps(a0, t1);
+    const __m128 e0m = _mm_sub_ps(a0, t1);
+    const __m128 u = cmul_sse(_mm_add_ps(a2, t3), vw1);
+    const __m128 v = rot90_sse(cmul_sse(_mm_sub_ps(a2, t3), vw1), inverse);
+    _mm_storeu_ps(b0, _mm_add_ps(e0, u));
+    _mm_storeu_ps(b2, _mm_sub_ps(e0, u));
+    _mm_storeu_ps(b1, _mm_add_ps(e0m, v));
+    _mm_storeu_ps(b3, _mm_sub_ps(e0m, v));
+}
+
+__attribute__((target("sse4.2")))
+void radix4_sse42(std::complex<float>* x, const std::complex<float>* tw,
+                  std::size_t m, std::size_t n, bool inverse)
+{
+    if (m < 2) {
+        radix4_scalar(x, tw, m, n, inverse);
+        return;
+    }
+    float* xf = reinterpret_cast<float*>(x);
+    const float* w1 = reinterpret_cast<const float*>(tw);
+    const float* w2 = reinterpret_cast<const float*>(tw + m);
+    for (std::size_t j = 0; j < n; j += 4 * m) {
+        float* b0 = xf + 2 * j;
+        for (std::size_t k = 0; k < m; k += 2)
+            radix4_block_sse(b0 + 2 * k, b0 + 2 * (m + k), b0 + 2 * (2 * m + k),
+                             b0 + 2 * (3 * m + k), _mm_loadu_ps(w1 + 2 * k),
+                             _mm_loadu_ps(w2 + 2 * k), inverse);
+    }
+}
+
+__attribute__((target("sse4.2")))
+void radix4_batch_sse42(std::complex<float>* x, const std::complex<float>* tw,
+                        std::size_t m, std::size_t n, std::size_t count, bool inverse)
+{
+    for (std::size_t j = 0; j < n; j += 4 * m) {
+        for (std::size_t k = 0; k < m; ++k) {
+            const __m128 vw1 = _mm_castpd_ps(_mm_set1_pd(cpx_bits(tw[k])));
+            const __m128 vw2 = _mm_castpd_ps(_mm_set1_pd(cpx_bits(tw[m + k])));
+            std::complex<float>* b0 = x + (j + k) * count;
+            std::complex<float>* b1 = b0 + m * count;
+            std::complex<float>* b2 = b1 + m * count;
+            std::complex<float>* b3 = b2 + m * count;
+            std::size_t b = 0;
+            for (; b + 2 <= count; b += 2)
+                radix4_block_sse(reinterpret_cast<float*>(b0 + b), reinterpret_cast<float*>(b1 + b),
+                                 reinterpret_cast<float*>(b2 + b), reinterpret_cast<float*>(b3 + b),
+                                 vw1, vw2, inverse);
+            radix4_batch_tail(b0, b1, b2, b3, tw[k], tw[m + k], b, count, inverse);
+        }
+    }
+}
+
+// Q15 kernels: four complex int16 values per register.  mulhrs rounds
+// exactly like kissfft_utils::q15_mul, adds saturates like q15_sat.
+__attribute__((target("sse4.2")))
+inline __m128i cmul_q15_sse(__m128i a, __m128i b)
+{
+    const __m128i dup_re = _mm_set_epi8(13, 12, 13, 12, 9, 8, 9, 8, 5, 4, 5, 4, 1, 0, 1, 0);
+    const __m128i dup_im = _mm_set_epi8(15, 14, 15, 14, 11, 10, 11, 10, 7, 6, 7, 6, 3, 2, 3, 2);
+    const __m128i swap = _mm_set_epi8(13, 12, 15, 14, 9, 8, 11, 10, 5, 4, 7, 6, 1, 0, 3, 2);
+    const __m128i neg_re = _mm_set_epi16(1, -1, 1, -1, 1, -1, 1, -1);
+    const __m128i p = _mm_mulhrs_epi16(a, _mm_shuffle_epi8(b, dup_re));
+    const __m128i q = _mm_mulhrs_epi16(_mm_shuffle_epi8(a, swap), _mm_shuffle_epi8(b, dup_im));
+    return _mm_adds_epi16(p, _mm_sign_epi16(q, neg_re));
+}
+
+__attribute__((target("sse4.2")))
+inline __m128i rot90_q15_sse(__m128i a, bool inverse)
+{
+    const __m128i swap = _mm_set_epi8(13, 12, 15, 14, 9, 8, 11, 10, 5, 4, 7, 6, 1, 0, 3, 2);
+    const __m128i neg_re = _mm_set_epi16(1, -1, 1, -1, 1, -1, 1, -1);
+    const __m128i neg_im = _mm_set_epi16(-1, 1, -1, 1, -1, 1, -1, 1);
+    return _mm_sign_epi16(_mm_shuffle_epi8(a, swap), inverse ? neg_re : neg_im);
+}
+
+// Rounding right shift by `shift` bits (0 leaves the value alone).
+__attribute__((target("sse4.2")))
+inline __m128i shift_q15_sse(__m128i a, __m128i scale, int shift)
+{
+    return shift ? _mm_mulhrs_epi16(a, scale) : a;
+}
+
+__attribute__((target("sse4.2")))
+inline int hmax_epu16_sse(__m128i v)
+{
+    v = _mm_max_epu16(v, _mm_srli_si128(v, 8));
+    v = _mm_max_epu16(v, _mm_srli_si128(v, 4));
+    v = _mm_max_epu16(v, _mm_srli_si128(v, 2));
+    return _mm_extract_epi16(v, 0);
+}
+
+__attribute__((target("sse4.2")))
+int radix4_q15_sse42(std::complex<int16_t>* x, const std::complex<int16_t>* tw,
+                     std::size_t m, std::size_t n, bool inverse, int shift)
+{
+    if (m < 4) return radix4_q15_scalar(x, tw, m, n, inverse, shift);
+    const __m128i scale = _mm_set1_epi16(int16_t(shift ? 1 << (15 - shift) : 0));
+    __m128i peak = _mm_setzero_si128();
+    for (std::size_t j = 0; j < n; j += 4 * m) {
+        std::complex<int16_t>* b0 = x + j;
+        std::complex<int16_t>* b1 = b0 + m;
+        std::complex<int16_t>* b2 = b1 + m;
+        std::complex<int16_t>* b3 = b2 + m;
+        for (std::size_t k = 0; k < m; k += 4) {
+            const __m128i vw1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(tw + k));
+            const __m128i vw2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(tw + m + k));
+            __m128i* p0 = reinterpret_cast<__m128i*>(b0 + k);
+            __m128i* p1 = reinterpret_cast<__m128i*>(b1 + k);
+            __m128i* p2 = reinterpret_cast<__m128i*>(b2 + k);
+            __m128i* p3 = reinterpret_cast<__m128i*>(b3 + k);
+            const __m128i a0 = shift_q15_sse(_mm_loadu_si128(p0), scale, shift);
+            const __m128i t1 = cmul_q15_sse(shift_q15_sse(_mm_loadu_si128(p1), scale, shift), vw2);
+            const __m128i a2 = shift_q15_sse(_mm_loadu_si128(p2), scale, shift);
+            const __m128i t3 = cmul_q15_sse(shift_q15_sse(_mm_loadu_si128(p3), scale, shift), vw2);
+            const __m128i e0 = _mm_add_epi16(a0, t1);
+            const __m128i e0m = _mm_sub_epi16(a0, t1);
+            const __m128i u = cmul_q15_sse(_mm_add_epi16(a2, t3), vw1);
+            const __m128i v = rot90_q15_sse(cmul_q15_sse(_mm_sub_epi16(a2, t3), vw1), inverse);
+            const __m128i r0 = _mm_add_epi16(e0, u);
+            const __m128i r2 = _mm_sub_epi16(e0, u);
+            const __m128i r1 = _mm_add_epi16(e0m, v);
+            const __m128i r3 = _mm_sub_epi16(e0m, v);
+            _mm_storeu_si128(p0, r0);
+            _mm_storeu_si128(p2, r2);
+            _mm_storeu_si128(p1, r1);
+            _mm_storeu_si128(p3, r3);
+            peak = _mm_max_epu16(peak, _mm_max_epu16(_mm_abs_epi16(r0), _mm_abs_epi16(r1)));
+            peak = _mm_max_epu16(peak, _mm_max_epu16(_mm_abs_epi16(r2), _mm_abs_epi16(r3)));
+        }
+    }
+    return hmax_epu16_sse(peak);
+}
+
+__attribute__((target("sse4.2")))
+inline __m128i load4_q15_sse(const std::complex<int16_t>* a, std::size_t stride)
+{
+    if (stride == 1) return _mm_loadu_si128(reinterpret_cast<const __m128i*>(a));
+    int32_t v[4];
+    for (int l = 0; l < 4; ++l) std::memcpy(&v[l], a + l * stride, sizeof(v[l]));
+    return _mm_loadu_si128(reinterpret_cast<const __m128i*>(v));
+}
+
+__attribute__((target("sse4.2")))
+void cmul_q15_sse42(std::complex<int16_t>* dst, const std::complex<int16_t>* a,
+                    std::size_t stride, const std::complex<int16_t>* b, std::size_t n)
+{
+    std::size_t i = 0;
+    for (; i + 4 <= n; i += 4)
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i),
+                         cmul_q15_sse(load4_q15_sse(a + i * stride, stride),
+                                      _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i))));
+    cmul_q15_scalar(dst + i, a + i * stride, stride, b + i, n - i);
+}
+
+__attribute__((target("sse4.2")))
+inline __m128 load2_sse(const std::complex<float>* a, std::size_t stride)
+{
+    if (stride == 1) return _mm_loadu_ps(reinterpret_cast<const float*>(a));
+    const __m128d lo = _mm_load_sd(reinterpret_cast<const double*>(a));
+    return _mm_castpd_ps(_mm_loadh_pd(lo, reinterpret_cast<const double*>(a + stride)));
+}
+
+__attribute__((target("sse4.2")))
+void cmul_sse42(std::complex<float>* dst, const std::complex<float>* a,
+                std::size_t stride, const std::complex<float>* b, std::size_t n)
+{
+    std::size_t i = 0;
+    float* d = reinterpret_cast<float*>(dst);
+    const float* bf = reinterpret_cast<const float*>(b);
+    for (; i + 2 <= n; i += 2)
+        _mm_storeu_ps(d + 2 * i, cmul_sse(load2_sse(a + i * stride, stride),
+                                          _mm_loadu_ps(bf + 2 * i)));
+    cmul_scalar(dst + i, a + i * stride, stride, b + i, n - i);
+}
+
+__attribute__((target("sse4.2")))
+void derotate_sse42(std::complex<float>* dst, const std::complex<float>* a,
+                    std::size_t stride, const std::complex<float>* b,
+                    const std::complex<float>* c, const std::complex<float>* z,
+                    std::size_t n)
+{
+    std::size_t i = 0;
+    float* d = reinterpret_cast<float*>(dst);
+    const float* bf = reinterpret_cast<const float*>(b);
+    const float* cf = reinterpret_cast<const float*>(c);
+    const __m128 vz = _mm_castpd_ps(_mm_load1_pd(reinterpret_cast<const double*>(z)));
+    for (; i + 2 <= n; i += 2) {
+        const __m128 ph = cmul_sse(_mm_loadu_ps(bf + 2 * i),
+                                   cmul_sse(vz, _mm_loadu_ps(cf + 2 * i)));
+        _mm_storeu_ps(d + 2 * i, cmul_sse(load2_sse(a + i * stride, stride), ph));
+    }
+    derotate_scalar(dst + i, a + i * stride, stride, b + i, c + i, z, n - i);
+}
+
+// One argmax step over four bins: |x|^2 into the energy partial, and a
+// strictly greater value (so the first occurrence wins) into best/best_i.
+__attribute__((target("sse4.2")))
+inline void argmax_step_sse(const float* xf, __m128i idx, __m128& best, __m128i& best_i,
+                            __m128& part)
+{
+    const __m128 v0 = _mm_loadu_ps(xf);
+    const __m128 v1 = _mm_loadu_ps(xf + 4);
+    const __m128 re = _mm_shuffle_ps(v0, v1, _MM_SHUFFLE(2, 0, 2, 0));
+    const __m128 im = _mm_shuffle_ps(v0, v1, _MM_SHUFFLE(3, 1, 3, 1));
+    const __m128 m2 = _mm_add_ps(_mm_mul_ps(re, re), _mm_mul_ps(im, im));
+    part = _mm_add_ps(part, m2);
+    const __m128 gt = _mm_cmpgt_ps(m2, best);
+    best = _mm_blendv_ps(best, m2, gt);
+    best_i = _mm_castps_si128(_mm_blendv_ps(_mm_castsi128_ps(best_i),
+                                            _mm_castsi128_ps(idx), gt));
+}
+
+// Lane-wise merge of a second (best, index) set into the first, keeping the
+// lower index on equal values.
+__attribute__((target("sse4.2")))
+inline void argmax_merge_sse(__m128& best, __m128i& best_i, __m128 other, __m128i other_i)
+{
+    const __m128 take = _mm_or_ps(
+        _mm_cmpgt_ps(other, best),
+        _mm_and_ps(_mm_cmpeq_ps(other, best),
+                   _mm_castsi128_ps(_mm_cmplt_epi32(other_i, best_i))));
+    best = _mm_blendv_ps(best, other, take);
+    best_i = _mm_castps_si128(_mm_blendv_ps(_mm_castsi128_ps(best_i),
+                                            _mm_castsi128_ps(other_i), take));
+}
+
+__attribute__((target("sse4.2")))
+std::size_t argmax_sse42(const std::complex<float>* x, std::size_t n,
+                         float* max_mag2, double* total)
+{
+    // Two independent accumulator sets hide the compare/blend latency.
+    const float* xf = reinterpret_cast<const float*>(x);
+    __m128 best0 = _mm_setzero_ps(), best1 = _mm_setzero_ps();
+    __m128i best_i0 = _mm_setzero_si128(), best_i1 = _mm_setzero_si128();
+    __m128i idx = _mm_set_epi32(3, 2, 1, 0);
+    const __m128i four = _mm_set1_epi32(4);
+    const __m128i eight = _mm_set1_epi32(8);
+    __m128d acc = _mm_setzero_pd();
+    std::size_t i = 0;
+    while (i + 8 <= n) {
+        __m128 part0 = _mm_setzero_ps(), part1 = _mm_setzero_ps();
+        for (std::size_t v = 0; v < SUM_BLOCK && i + 8 <= n; v += 2, i += 8) {
+            argmax_step_sse(xf + 2 * i, idx, best0, best_i0, part0);
+            argmax_step_sse(xf + 2 * i + 8, _mm_add_epi32(idx, four), best1, best_i1, part1);
+            idx = _mm_add_epi32(idx, eight);
+        }
+        const __m128 part = _mm_add_ps(part0, part1);
+        acc = _mm_add_pd(acc, _mm_add_pd(_mm_cvtps_pd(part),
+                                         _mm_cvtps_pd(_mm_movehl_ps(part, part))));
+    }
+    argmax_merge_sse(best0, best_i0, best1, best_i1);
+    alignas(16) float bv[4];
+    alignas(16) int32_t bi[4];
+    alignas(16) double sums[2];
+    _mm_store_ps(bv, best0);
+    _mm_store_si128(reinterpret_cast<__m128i*>(bi), best_i0);
+    _mm_store_pd(sums, acc);
+    float best_v;
+    std::size_t best_idx = reduce_lanes(bv, bi, 4, &best_v);
+    double sum = sums[0] + sums[1];
+    for (; i < n; ++i) {
+        const float m2 = x[i].real() * x[i].real() + x[i].imag() * x[i].imag();
+        sum += m2;
+        if (m2 > best_v) {
+            best_v = m2;
+            best_idx = i;
+        }
+    }
+    *max_mag2 = best_v;
+    *total = sum;
+    return best_idx;
+}
+
+__attribute__((target("sse4.2")))
+inline void sincos_sse(__m128 x, __m128* s, __m128* c)
+{
+    const __m128 jf = _mm_round_ps(_mm_mul_ps(x, _mm_set1_ps(TWO_OVER_PI)),
+                                   _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+    const __m128i q = _mm_cvtps_epi32(jf);
+    __m128 y = _mm_sub_ps(x, _mm_mul_ps(jf, _mm_set1_ps(PIO2_1)));
+    y = _mm_sub_ps(y, _mm_mul_ps(jf, _mm_set1_ps(PIO2_2)));
+    y = _mm_sub_ps(y, _mm_mul_ps(jf, _mm_set1_ps(PIO2_3)));
+    const __m128 z = _mm_mul_ps(y, y);
+    __m128 ps = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(S3), z), _mm_set1_ps(S2));
+    ps = _mm_add_ps(_mm_mul_ps(ps, z), _mm_set1_ps(S1));
+    ps = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(ps, z), y), y);
+    __m128 pc = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(C3), z), _mm_set1_ps(C2));
+    pc = _mm_add_ps(_mm_mul_ps(pc, z), _mm_set1_ps(C1));
+    pc = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(pc, z), z),
+                    _mm_sub_ps(_mm_set1_ps(1.0f), _mm_mul_ps(z, _mm_set1_ps(0.5f))));
+    // Quadrant fix-up: odd quadrants swap sin/cos, bit 1 negates sin and
+    // bits (0 xor 1) negate cos.
+    const __m128 swap = _mm_castsi128_ps(
+        _mm_cmpeq_epi32(_mm_and_si128(q, _mm_set1_epi32(1)), _mm_set1_epi32(1)));
+    const __m128 sv = _mm_blendv_ps(ps, pc, swap);
+    const __m128 cv = _mm_blendv_ps(pc, ps, swap);
+    const __m128i sbit = _mm_slli_epi32(_mm_and_si128(q, _mm_set1_epi32(2)), 30);
+    const __m128i cbit = _mm_slli_epi32(
+        _mm_and_si128(_mm_add_epi32(q, _mm_set1_epi32(1)), _mm_set1_epi32(2)), 30);
+    *s = _mm_xor_ps(sv, _mm_castsi128_ps(sbit));
+    *c = _mm_xor_ps(cv, _mm_castsi128_ps(cbit));
+}
+
+__attribute__((target("sse4.2")))
+void polar_sse42(std::complex<float>* dst, const float* phase, float ampl,
+                 std::size_t n)
+{
+    float* d = reinterpret_cast<float*>(dst);
+    const __m128 a = _mm_set1_ps(ampl);
+    std::size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128 s, c;
+        sincos_sse(_mm_loadu_ps(phase + i), &s, &c);
+        s = _mm_mul_ps(s, a);
+        c = _mm_mul_ps(c, a);
+        _mm_storeu_ps(d + 2 * i, _mm_unpacklo_ps(c, s));
+        _mm_storeu_ps(d + 2 * i + 4, _mm_unpackhi_ps(c, s));
+    }
+    polar_scalar(dst + i, phase + i, ampl, n - i);
+}
+
+// ---------------------------------------------------------------------------
+// AVX2 kernels (256-bit, four complex values per register)
+// ---------------------------------------------------------------------------
+
+__attribute__((target("avx2,fma")))
+inline __m256 cmul_avx2(__m256 a, __m256 b)
+{
+    const __m256 br = _mm256_moveldup_ps(b);
+    const __m256 bi = _mm256_movehdup_ps(b);
+    const __m256 as = _mm256_permute_ps(a, _MM_SHUFFLE(2, 3, 0, 1));
+    return _mm256_fmaddsub_ps(a, br, _mm256_mul_ps(as, bi));
+}
+
+__attribute__((target("avx2,fma")))
+inline __m256 rot90_avx2(__m256 a, bool inverse)
+{
+    const __m256 sw = _mm256_permute_ps(a, _MM_SHUFFLE(2, 3, 0, 1));
+    const __m256 neg_re = _mm256_castsi256_ps(_mm256_set1_epi64x(int64_t(0x80000000u)));
+    const __m256 neg_im = _mm256_castsi256_ps(
+        _mm256_set1_epi64x(int64_t(uint64_t(0x80000000u) << 32)));
+    return _mm256_xor_ps(sw, inverse ? neg_re : neg_im);
+}
+
+__attribute__((target("avx2,fma")))
+inline void radix4_block_avx2(float* b0, float* b1, float* b2, float* b3,
+                              __m256 vw1, __m256 vw2, bool inverse)
+{
+    const __m256 a0 = _mm256_loadu_ps(b0);
+    const __m256 t1 = cmul_avx2(_mm256_loadu_ps(b1), vw2);
+    const __m256 a2 = _mm256_loadu_ps(b2);
+    const __m256 t3 = cmul_avx2(_mm256_loadu_ps(b3), vw2);
+    const __m256 e0 = _mm256_add_ps(a0, t1);
+    const __m256 e0m = _mm256_sub_ps(a0, t1);
+    const __m256 u = cmul_avx2(_mm256_add_ps(a2, t3), vw1);
+    const __m256 v = rot90_avx2(cmul_avx2(_mm256_sub_ps(a2, t3), vw1), inverse);
+    _mm256_storeu_ps(b0, _mm256_add_ps(e0, u));
+    _mm256_storeu_ps(b2, _mm256_sub_ps(e0, u));
+    _mm256_storeu_ps(b1, _mm256_add_ps(e0m, v));
+    _mm256_storeu_ps(b3, _mm256_sub_ps(e0m, v));
+}
+
+__attribute__((target("avx2,fma")))
+void radix4_avx2(std::complex<float>* x, const std::complex<float>* tw,
+                 std::size_t m, std::size_t n, bool inverse)
+{
+    if (m < 4) {
+        _mm256_zeroupper();
+        radix4_sse42(x, tw, m, n, inverse);
+        return;
+    }
+    float* xf = reinterpret_cast<float*>(x);
+    const float* w1 = reinterpret_cast<const float*>(tw);
+    const float* w2 = reinterpret_cast<const float*>(tw + m);
+    for (std::size_t j = 0; j < n; j += 4 * m) {
+        float* b0 = xf + 2 * j;
+        for (std::size_t k = 0; k < m; k += 4)
+            radix4_block_avx2(b0 + 2 * k, b0 + 2 * (m + k), b0 + 2 * (2 * m + k),
+                              b0 + 2 * (3 * m + k), _mm256_loadu_ps(w1 + 2 * k),
+                              _mm256_loadu_ps(w2 + 2 * k), inverse);
+    }
+}
+
+__attribute__((target("avx2,fma")))
+void radix4_batch_avx2(std::complex<float>* x, const std::complex<float>* tw,
+                       std::size_t m, std::size_t n, std::size_t count, bool inverse)
+{
+    if (count < 4) {
+        _mm256_zeroupper();
+        radix4_batch_sse42(x, tw, m, n, count, inverse);
+        return;
+    }
+    for (std::size_t j = 0; j < n; j += 4 * m) {
+        for (std::size_t k = 0; k < m; ++k) {
+            const __m256 vw1 = _mm256_castpd_ps(_mm256_set1_pd(cpx_bits(tw[k])));
+            const __m256 vw2 = _mm256_castpd_ps(_mm256_set1_pd(cpx_bits(tw[m + k])));
+            std::complex<float>* b0 = x + (j + k) * count;
+            std::complex<float>* b1 = b0 + m * count;
+            std::complex<float>* b2 = b1 + m * count;
+            std::complex<float>* b3 = b2 + m * count;
+            std::size_t b = 0;
+            for (; b + 4 <= count; b += 4)
+                radix4_block_avx2(reinterpret_cast<float*>(b0 + b), reinterpret_cast<float*>(b1 + b),
+                                  reinterpret_cast<float*>(b2 + b), reinterpret_cast<float*>(b3 + b),
+                                  vw1, vw2, inverse);
+            radix4_batch_tail(b0, b1, b2, b3, tw[k], tw[m + k], b, count, inverse);
+        }
+    }
+}
+
+__attribute__((target("avx2,fma")))
+void cmul_avx2_kernel(std::complex<float>* dst, const std::complex<float>* a,
+                      std::size_t stride, const std::complex<float>* b, std::size_t n)
+{
+    std::size_t i = 0;
+    float* d = reinterpret_cast<float*>(dst);
+    const float* bf = reinterpret_cast<const float*>(b);
+    const double* ad = reinterpret_cast<const double*>(a);
+    const long long s = static_cast<long long>(stride);
+    const __m256i offs = _mm256_set_epi64x(3 * s, 2 * s, s, 0);
+    for (; i + 4 <= n; i += 4) {
+        __m256 av;
+        if (stride == 1)
+            av = _mm256_loadu_ps(reinterpret_cast<const float*>(a + i));
+        else if (stride == 0)
+            av = _mm256_castpd_ps(_mm256_broadcast_sd(ad));
+        else
+            av = _mm256_castpd_ps(_mm256_i64gather_pd(ad + i * stride, offs, 8));
+        _mm256_storeu_ps(d + 2 * i, cmul_avx2(av, _mm256_loadu_ps(bf + 2 * i)));
+    }
+    _mm256_zeroupper();
+    cmul_sse42(dst + i, a + i * stride, stride, b + i, n - i);
+}
+
+__attribute__((target("avx2,fma")))
+void derotate_avx2(std::complex<float>* dst, const std::complex<float>* a,
+                   std::size_t stride, const std::complex<float>* b,
+                   const std::complex<float>* c, const std::complex<float>* z,
+                   std::size_t n)
+{
+    std::size_t i = 0;
+    float* d = reinterpret_cast<float*>(dst);
+    const float* bf = reinterpret_cast<const float*>(b);
+    const float* cf = reinterpret_cast<const float*>(c);
+    const double* ad = reinterpret_cast<const double*>(a);
+    const long long s = static_cast<long long>(stride);
+    const __m256i offs = _mm256_set_epi64x(3 * s, 2 * s, s, 0);
+    const __m256 vz = _mm256_castpd_ps(_mm256_broadcast_sd(reinterpret_cast<const double*>(z)));
+    for (; i + 4 <= n; i += 4) {
+        __m256 av;
+        if (stride == 1)
+            av = _mm256_loadu_ps(reinterpret_cast<const float*>(a + i));
+        else
+            av = _mm256_castpd_ps(_mm256_i64gather_pd(ad + i * stride, offs, 8));
+        const __m256 ph = cmul_avx2(_mm256_loadu_ps(bf + 2 * i),
+                                    cmul_avx2(vz, _mm256_loadu_ps(cf + 2 * i)));
+        _mm256_storeu_ps(d + 2 * i, cmul_avx2(av, ph));
+    }
+    _mm256_zeroupper();
+    derotate_sse42(dst + i, a + i * stride, stride, b + i, c + i, z, n - i);
+}
+
+__attribute__((target("avx2,fma")))
+inline __m256i cmul_q15_avx2(__m256i a, __m256i b)
+{
+    const __m256i dup_re = _mm256_setr_epi8(0, 1, 0, 1, 4, 5, 4, 5, 8, 9, 8, 9, 12, 13, 12, 13,
+                                            0, 1, 0, 1, 4, 5, 4, 5, 8, 9, 8, 9, 12, 13, 12, 13);
+    const __m256i dup_im = _mm256_setr_epi8(2, 3, 2, 3, 6, 7, 6, 7, 10, 11, 10, 11, 14, 15, 14, 15,
+                                            2, 3, 2, 3, 6, 7, 6, 7, 10, 11, 10, 11, 14, 15, 14, 15);
+    const __m256i swap = _mm256_setr_epi8(2, 3, 0, 1, 6, 7, 4, 5, 10, 11, 8, 9, 14, 15, 12, 13,
+                                          2, 3, 0, 1, 6, 7, 4, 5, 10, 11, 8, 9, 14, 15, 12, 13);
+    const __m256i neg_re = _mm256_set1_epi32(0x0001ffff);
+    const __m256i p = _mm256_mulhrs_epi16(a, _mm256_shuffle_epi8(b, dup_re));
+    const __m256i q = _mm256_mulhrs_epi16(_mm256_shuffle_epi8(a, swap),
+                                          _mm256_shuffle_epi8(b, dup_im));
+    return _mm256_adds_epi16(p, _mm256_sign_epi16(q, neg_re));
+}
+
+__attribute__((target("avx2,fma")))
+inline __m256i rot90_q15_avx2(__m256i a, bool inverse)
+{
+    const __m256i swap = _mm256_setr_epi8(2, 3, 0, 1, 6, 7, 4, 5, 10, 11, 8, 9, 14, 15, 12, 13,
+                                          2, 3, 0, 1, 6, 7, 4, 5, 10, 11, 8, 9, 14, 15, 12, 13);
+    const __m256i neg_re = _mm256_set1_epi32(0x0001ffff);
+    const __m256i neg_im = _mm256_set1_epi32(int(0xffff0001u));
+    return _mm256_sign_epi16(_mm256_shuffle_epi8(a, swap), inverse ? neg_re : neg_im);
+}
+
+__attribute__((target("avx2,fma")))
+int radix4_q15_avx2(std::complex<int16_t>* x, const std::complex<int16_t>* tw,
+                    std::size_t m, std::size_t n, bool inverse, int shift)
+{
+    if (m < 8) {
+        _mm256_zeroupper();
+        return radix4_q15_sse42(x, tw, m, n, inverse, shift);
+    }
+    const __m256i scale = _mm256_set1_epi16(int16_t(shift ? 1 << (15 - shift) : 0));
+    __m256i peak = _mm256_setzero_si256();
+    for (std::size_t j = 0; j < n; j += 4 * m) {
+        std::complex<int16_t>* b0 = x + j;
+        for (std::size_t k = 0; k < m; k += 8) {
+            __m256i* p0 = reinterpret_cast<__m256i*>(b0 + k);
+            __m256i* p1 = reinterpret_cast<__m256i*>(b0 + m + k);
+            __m256i* p2 = reinterpret_cast<__m256i*>(b0 + 2 * m + k);
+            __m256i* p3 = reinterpret_cast<__m256i*>(b0 + 3 * m + k);
+            const __m256i vw1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(tw + k));
+            const __m256i vw2 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(tw + m + k));
+            __m256i a0 = _mm256_loadu_si256(p0), a1 = _mm256_loadu_si256(p1);
+            __m256i a2 = _mm256_loadu_si256(p2), a3 = _mm256_loadu_si256(p3);
+            if (shift) {
+                a0 = _mm256_mulhrs_epi16(a0, scale);
+                a1 = _mm256_mulhrs_epi16(a1, scale);
+                a2 = _mm256_mulhrs_epi16(a2, scale);
+                a3 = _mm256_mulhrs_epi16(a3, scale);
+            }
+            const __m256i t1 = cmul_q15_avx2(a1, vw2);
+            const __m256i t3 = cmul_q15_avx2(a3, vw2);
+            const __m256i e0 = _mm256_add_epi16(a0, t1);
+            const __m256i e0m = _mm256_sub_epi16(a0, t1);
+            const __m256i u = cmul_q15_avx2(_mm256_add_epi16(a2, t3), vw1);
+            const __m256i v = rot90_q15_avx2(cmul_q15_avx2(_mm256_sub_epi16(a2, t3), vw1), inverse);
+            const __m256i r0 = _mm256_add_epi16(e0, u);
+            const __m256i r2 = _mm256_sub_epi16(e0, u);
+            const __m256i r1 = _mm256_add_epi16(e0m, v);
+            const __m256i r3 = _mm256_sub_epi16(e0m, v);
+            _mm256_storeu_si256(p0, r0);
+            _mm256_storeu_si256(p2, r2);
+            _mm256_storeu_si256(p1, r1);
+            _mm256_storeu_si256(p3, r3);
+            peak = _mm256_max_epu16(peak, _mm256_max_epu16(_mm256_abs_epi16(r0), _mm256_abs_epi16(r1)));
+            peak = _mm256_max_epu16(peak, _mm256_max_epu16(_mm256_abs_epi16(r2), _mm256_abs_epi16(r3)));
+        }
+    }
+    const __m128i half = _mm_max_epu16(_mm256_castsi256_si128(peak),
+                                       _mm256_extracti128_si256(peak, 1));
+    _mm256_zeroupper();
+    return hmax_epu16_sse(half);
+}
+
+__attribute__((target("avx2,fma")))
+void cmul_q15_avx2_kernel(std::complex<int16_t>* dst, const std::complex<int16_t>* a,
+                          std::size_t stride, const std::complex<int16_t>* b, std::size_t n)
+{
+    std::size_t i = 0;
+    const int* ai = reinterpret_cast<const int*>(a);
+    const int s = static_cast<int>(stride);
+    const __m256i offs = _mm256_setr_epi32(0, s, 2 * s, 3 * s, 4 * s, 5 * s, 6 * s, 7 * s);
+    for (; i + 8 <= n; i += 8) {
+        __m256i av;
+        if (stride == 1)
+            av = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+        else
+            av = _mm256_i32gather_epi32(ai + i * stride, offs, 4);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i),
+                            cmul_q15_avx2(av, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i))));
+    }
+    _mm256_zeroupper();
+    cmul_q15_sse42(dst + i, a + i * stride, stride, b + i, n - i);
+}
+
+__attribute__((target("avx2,fma")))
+inline void argmax_step_avx2(const float* xf, __m256i idx, __m256& best, __m256i& best_i,
+                             __m256& part)
+{
+    const __m256 v0 = _mm256_loadu_ps(xf);
+    const __m256 v1 = _mm256_loadu_ps(xf + 8);
+    const __m256 re = _mm256_shuffle_ps(v0, v1, _MM_SHUFFLE(2, 0, 2, 0));
+    const __m256 im = _mm256_shuffle_ps(v0, v1, _MM_SHUFFLE(3, 1, 3, 1));
+    const __m256 m2 = _mm256_fmadd_ps(re, re, _mm256_mul_ps(im, im));
+    part = _mm256_add_ps(part, m2);
+    const __m256 gt = _mm256_cmp_ps(m2, best, _CMP_GT_OQ);
+    best = _mm256_blendv_ps(best, m2, gt);
+    best_i = _mm256_castps_si256(_mm256_blendv_ps(_mm256_castsi256_ps(best_i),
+                                                  _mm256_castsi256_ps(idx), gt));
+}
+
+__attribute__((target("avx2,fma")))
+inline void argmax_merge_avx2(__m256& best, __m256i& best_i, __m256 other, __m256i other_i)
+{
+    const __m256 take = _mm256_or_ps(
+        _mm256_cmp_ps(other, best, _CMP_GT_OQ),
+        _mm256_and_ps(_mm256_cmp_ps(other, best, _CMP_EQ_OQ),
+                      _mm256_castsi256_ps(_mm256_cmpgt_epi32(best_i, other_i))));
+    best = _mm256_blendv_ps(best, other, take);
+    best_i = _mm256_castps_si256(_mm256_blendv_ps(_mm256_castsi256_ps(best_i),
+                                                  _mm256_castsi256_ps(other_i), take));
+}
+
+__attribute__((target("avx2,fma")))
+std::size_t argmax_avx2(const std::complex<float>* x, std::size_t n,
+                        float* max_mag2, double* total)
+{
+    const float* xf = reinterpret_cast<const float*>(x);
+    __m256 best0 = _mm256_setzero_ps(), best1 = _mm256_setzero_ps();
+    __m256i best_i0 = _mm256_setzero_si256(), best_i1 = _mm256_setzero_si256();
+    // _mm256_shuffle_ps works per 128-bit lane, so the bins come out in
+    // the order 0 1 4 5 2 3 6 7; track indices in the same order.
+    __m256i idx = _mm256_set_epi32(7, 6, 3, 2, 5, 4, 1, 0);
+    const __m256i eight = _mm256_set1_epi32(8);
+    const __m256i sixteen = _mm256_set1_epi32(16);
+    __m256d acc = _mm256_setzero_pd();
+    std::size_t i = 0;
+    while (i + 16 <= n) {
+        __m256 part0 = _mm256_setzero_ps(), part1 = _mm256_setzero_ps();
+        for (std::size_t v = 0; v < SUM_BLOCK && i + 16 <= n; v += 2, i += 16) {
+            argmax_step_avx2(xf + 2 * i, idx, best0, best_i0, part0);
+            argmax_step_avx2(xf + 2 * i + 16, _mm256_add_epi32(idx, eight), best1, best_i1,
+                             part1);
+            idx = _mm256_add_epi32(idx, sixteen);
+        }
+        const __m256 part = _mm256_add_ps(part0, part1);
+        acc = _mm256_add_pd(acc, _mm256_add_pd(_mm256_cvtps_pd(_mm256_castps256_ps128(part)),
+                                               _mm256_cvtps_pd(_mm256_extractf128_ps(part, 1))));
+    }
+    argmax_merge_avx2(best0, best_i0, best1, best_i1);
+    alignas(32) float bv[8];
+    alignas(32) int32_t bi[8];
+    alignas(32) double sums[4];
+    _mm256_store_ps(bv, best0);
+    _mm256_store_si256(reinterpret_cast<__m256i*>(bi), best_i0);
+    _mm256_store_pd(sums, acc);
+    float best_v;
+    std::size_t best_idx = reduce_lanes(bv, bi, 8, &best_v);
+    double sum = (sums[0] + sums[1]) + (sums[2] + sums[3]);
+    for (; i < n; ++i) {
+        const float m2 = x[i].real() * x[i].real() + x[i].imag() * x[i].imag();
+        sum += m2;
+        if (m2 > best_v) {
+            best_v = m2;
+            best_idx = i;
+        }
+    }
+    *max_mag2 = best_v;
+    *total = sum;
+    return best_idx;
+}
+
+__attribute__((target("avx2,fma")))
+inline void sincos_avx2(__m256 x, __m256* s, __m256* c)
+{
+    const __m256 jf = _mm256_round_ps(_mm256_mul_ps(x, _mm256_set1_ps(TWO_OVER_PI)),
+                                      _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+    const __m256i q = _mm256_cvtps_epi32(jf);
+    __m256 y = _mm256_fnmadd_ps(jf, _mm256_set1_ps(PIO2_1), x);
+    y = _mm256_fnmadd_ps(jf, _mm256_set1_ps(PIO2_2), y);
+    y = _mm256_fnmadd_ps(jf, _mm256_set1_ps(PIO2_3), y);
+    const __m256 z = _mm256_mul_ps(y, y);
+    __m256 ps = _mm256_fmadd_ps(_mm256_set1_ps(S3), z, _mm256_set1_ps(S2));
+    ps = _mm256_fmadd_ps(ps, z, _mm256_set1_ps(S1));
+    ps = _mm256_fmadd_ps(_mm256_mul_ps(ps, z), y, y);
+    __m256 pc = _mm256_fmadd_ps(_mm256_set1_ps(C3), z, _mm256_set1_ps(C2));
+    pc = _mm256_fmadd_ps(pc, z, _mm256_set1_ps(C1));
+    pc = _mm256_fmadd_ps(_mm256_mul_ps(pc, z), z,
+                         _mm256_fnmadd_ps(z, _mm256_set1_ps(0.5f), _mm256_set1_ps(1.0f)));
+    const __m256 swap = _mm256_castsi256_ps(_mm256_cmpeq_epi32(
+        _mm256_and_si256(q, _mm256_set1_epi32(1)), _mm256_set1_epi32(1)));
+    const __m256 sv = _mm256_blendv_ps(ps, pc, swap);
+    const __m256 cv = _mm256_blendv_ps(pc, ps, swap);
+    const __m256i sbit = _mm256_slli_epi32(_mm256_and_si256(q, _mm256_set1_epi32(2)), 30);
+    const __m256i cbit = _mm256_slli_epi32(
+        _mm256_and_si256(_mm256_add_epi32(q, _mm256_set1_epi32(1)), _mm256_set1_epi32(2)), 30);
+    *s = _mm256_xor_ps(sv, _mm256_castsi256_ps(sbit));
+    *c = _mm256_xor_ps(cv, _mm256_castsi256_ps(cbit));
+}
+
+__attribute__((target("avx2,fma")))
+void polar_avx2(std::complex<float>* dst, const float* phase, float ampl,
+                std::size_t n)
+{
+    float* d = reinterpret_cast<float*>(dst);
+    const __m256 a = _mm256_set1_ps(ampl);
+    std::size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256 s, c;
+        sincos_avx2(_mm256_loadu_ps(phase + i), &s, &c);
+        s = _mm256_mul_ps(s, a);
+        c = _mm256_mul_ps(c, a);
+        const __m256 lo = _mm256_unpacklo_ps(c, s);
+        const __m256 hi = _mm256_unpackhi_ps(c, s);
+        _mm256_storeu_ps(d + 2 * i, _mm256_permute2f128_ps(lo, hi, 0x20));
+        _mm256_storeu_ps(d + 2 * i + 8, _mm256_permute2f128_ps(lo, hi, 0x31));
+    }
+    _mm256_zeroupper();
+    polar_sse42(dst + i, phase + i, ampl, n - i);
+}
+
+// ---------------------------------------------------------------------------
+// AVX-512 kernels (512-bit, eight complex values per register)
+// ---------------------------------------------------------------------------
+
+// GCC 12's AVX-512 intrinsics seed their pass-through operands with
+// self-initialised "undefined" vectors, which -Wuninitialized reports at
+// every inlined use (GCC PR105593).  Silence that for these kernels only.
+#if !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+
+__attribute__((target("avx512f,avx2,fma")))
+inline __m512 cmul_avx512(__m512 a, __m512 b)
+{
+    const __m512 br = _mm512_moveldup_ps(b);
+    const __m512 bi = _mm512_movehdup_ps(b);
+    const __m512 as = _mm512_permute_ps(a, _MM_SHUFFLE(2, 3, 0, 1));
+    return _mm512_fmaddsub_ps(a, br, _mm512_mul_ps(as, bi));
+}
+
+__attribute__((target("avx512f,avx2,fma")))
+inline __m512 rot90_avx512(__m512 a, bool inverse)
+{
+    const __m512 sw = _mm512_permute_ps(a, _MM_SHUFFLE(2, 3, 0, 1));
+    const __m512i neg_re = _mm512_set1_epi64(int64_t(0x80000000u));
+    const __m512i neg_im = _mm512_set1_epi64(int64_t(uint64_t(0x80000000u) << 32));
+    return _mm512_castsi512_ps(_mm512_xor_si512(_mm512_castps_si512(sw),
+                                                inverse ? neg_re : neg_im));
+}
+
+__attribute__((target("avx512f,avx2,fma")))
+inline void radix4_block_avx512(float* b0, float* b1, float* b2, float* b3,
+                                __m512 vw1, __m512 vw2, bool inverse)
+{
+    const __m512 a0 = _mm512_loadu_ps(b0);
+    const __m512 t1 = cmul_avx512(_mm512_loadu_ps(b1), vw2);
+    const __m512 a2 = _mm512_loadu_ps(b2);
+    const __m512 t3 = cmul_avx512(_mm512_loadu_ps(b3), vw2);
+    const __m512 e0 = _mm512_add_ps(a0, t1);
+    const __m512 e0m = _mm512_sub_ps(a0, t1);
+    const __m512 u = cmul_avx512(_mm512_add_ps(a2, t3), vw1);
+    const __m512 v = rot90_avx512(cmul_avx512(_mm512_sub_ps(a2, t3), vw1), inverse);
+    _mm512_storeu_ps(b0, _mm512_add_ps(e0, u));
+    _mm512_storeu_ps(b2, _mm512_sub_ps(e0, u));
+    _mm512_storeu_ps(b1, _mm512_add_ps(e0m, v));
+    _mm512_storeu_ps(b3, _mm512_sub_ps(e0m, v));
+}
+
+__attribute__((target("avx512f,avx2,fma")))
+void radix4_avx512(std::complex<float>* x, const std::complex<float>* tw,
+                   std::size_t m, std::size_t n, bool inverse)
+{
+    if (m < 8) {
+        radix4_avx2(x, tw, m, n, inverse);
+        return;
+    }
+    float* xf = reinterpret_cast<float*>(x);
+    const float* w1 = reinterpret_cast<const float*>(tw);
+    const float* w2 = reinterpret_cast<const float*>(tw + m);
+    for (std::size_t j = 0; j < n; j += 4 * m) {
+        float* b0 = xf + 2 * j;
+        for (std::size_t k = 0; k < m; k += 8)
+            radix4_block_avx512(b0 + 2 * k, b0 + 2 * (m + k), b0 + 2 * (2 * m + k),
+                                b0 + 2 * (3 * m + k), _mm512_loadu_ps(w1 + 2 * k),
+                                _mm512_loadu_ps(w2 + 2 * k), inverse);
+    }
+}
+
+__attribute__((target("avx512f,avx2,fma")))
+void radix4_batch_avx512(std::complex<float>* x, const std::complex<float>* tw,
+                         std::size_t m, std::size_t n, std::size_t count, bool inverse)
+{
+    if (count < 8) {
+        radix4_batch_avx2(x, tw, m, n, count, inverse);
+        return;
+    }
+    for (std::size_t j = 0; j < n; j += 4 * m) {
+        for (std::size_t k = 0; k < m; ++k) {
+            const __m512 vw1 = _mm512_castpd_ps(_mm512_set1_pd(cpx_bits(tw[k])));
+            const __m512 vw2 = _mm512_castpd_ps(_mm512_set1_pd(cpx_bits(tw[m + k])));
+            std::complex<float>* b0 = x + (j + k) * count;
+            std::complex<float>* b1 = b0 + m * count;
+            std::complex<float>* b2 = b1 + m * count;
+            std::complex<float>* b3 = b2 + m * count;
+            std::size_t b = 0;
+            for (; b + 8 <= count; b += 8)
+                radix4_block_avx512(reinterpret_cast<float*>(b0 + b), reinterpret_cast<float*>(b1 + b),
+                                    reinterpret_cast<float*>(b2 + b), reinterpret_cast<float*>(b3 + b),
+                                    vw1, vw2, inverse);
+            radix4_batch_tail(b0, b1, b2, b3, tw[k], tw[m + k], b, count, inverse);
+        }
+    }
+}
+
+__attribute__((target("avx512f,avx2,fma")))
+void cmul_avx512_kernel(std::complex<float>* dst, const std::complex<float>* a,
+                        std::size_t stride, const std::complex<float>* b, std::size_t n)
+{
+    std::size_t i = 0;
+    float* d = reinterpret_cast<float*>(dst);
+    const float* bf = reinterpret_cast<const float*>(b);
+    const double* ad = reinterpret_cast<const double*>(a);
+    const long long s = static_cast<long long>(stride);
+    const __m512i offs = _mm512_set_epi64(7 * s, 6 * s, 5 * s, 4 * s,
+                                          3 * s, 2 * s, s, 0);
+    for (; i + 8 <= n; i += 8) {
+        __m512 av;
+        if (stride == 1)
+            av = _mm512_loadu_ps(reinterpret_cast<const float*>(a + i));
+        else if (stride == 0)
+            av = _mm512_castpd_ps(_mm512_set1_pd(*ad));
+        else
+            av = _mm512_castpd_ps(_mm512_i64gather_pd(offs, ad + i * stride, 8));
+        _mm512_storeu_ps(d + 2 * i, cmul_avx512(av, _mm512_loadu_ps(bf + 2 * i)));
+    }
+    cmul_avx2_kernel(dst + i, a + i * stride, stride, b + i, n - i);
+}
+
+__attribute__((target("avx512f,avx2,fma")))
+void derotate_avx512(std::complex<float>* dst, const std::complex<float>* a,
+                     std::size_t stride, const std::complex<float>* b,
+                     const std::complex<float>* c, const std::complex<float>* z,
+                     std::size_t n)
+{
+    std::size_t i = 0;
+    float* d = reinterpret_cast<float*>(dst);
+    const float* bf = reinterpret_cast<const float*>(b);
+    const float* cf = reinterpret_cast<const float*>(c);
+    const double* ad = reinterpret_cast<const double*>(a);
+    const long long s = static_cast<long long>(stride);
+    const __m512i offs = _mm512_set_epi64(7 * s, 6 * s, 5 * s, 4 * s,
+                                          3 * s, 2 * s, s, 0);
+    const __m512 vz = _mm512_castpd_ps(
+        _mm512_broadcastsd_pd(_mm_load_sd(reinterpret_cast<const double*>(z))));
+    for (; i + 8 <= n; i += 8) {
+        __m512 av;
+        if (stride == 1)
+            av = _mm512_loadu_ps(reinterpret_cast<const float*>(a + i));
+        else
+            av = _mm512_castpd_ps(_mm512_i64gather_pd(offs, ad + i * stride, 8));
+        const __m512 ph = cmul_avx512(_mm512_loadu_ps(bf + 2 * i),
+                                      cmul_avx512(vz, _mm512_loadu_ps(cf + 2 * i)));
+        _mm512_storeu_ps(d + 2 * i, cmul_avx512(av, ph));
+    }
+    derotate_avx2(dst + i, a + i * stride, stride, b + i, c + i, z, n - i);
+}
+
+__attribute__((target("avx512f,avx2,fma")))
+inline void argmax_step_avx512(const float* xf, __m512i idx, __m512i even, __m512i odd,
+                               __m512& best, __m512i& best_i, __m512& part)
+{
+    const __m512 v0 = _mm512_loadu_ps(xf);
+    const __m512 v1 = _mm512_loadu_ps(xf + 16);
+    const __m512 re = _mm512_permutex2var_ps(v0, even, v1);
+    const __m512 im = _mm512_permutex2var_ps(v0, odd, v1);
+    const __m512 m2 = _mm512_fmadd_ps(re, re, _mm512_mul_ps(im, im));
+    part = _mm512_add_ps(part, m2);
+    const __mmask16 gt = _mm512_cmp_ps_mask(m2, best, _CMP_GT_OQ);
+    best = _mm512_mask_mov_ps(best, gt, m2);
+    best_i = _mm512_mask_mov_epi32(best_i, gt, idx);
+}
+
+__attribute__((target("avx512f,avx2,fma")))
+std::size_t argmax_avx512(const std::complex<float>* x, std::size_t n,
+                          float* max_mag2, double* total)
+{
+    const float* xf = reinterpret_cast<const float*>(x);
+    const __m512i even = _mm512_set_epi32(30, 28, 26, 24, 22, 20, 18, 16,
+                                          14, 12, 10, 8, 6, 4, 2, 0);
+    const __m512i odd = _mm512_add_epi32(even, _mm512_set1_epi32(1));
+    __m512 best0 = _mm512_setzero_ps(), best1 = _mm512_setzero_ps();
+    __m512i best_i0 = _mm512_setzero_si512(), best_i1 = _mm512_setzero_si512();
+    __m512i idx = _mm512_set_epi32(15, 14, 13, 12, 11, 10, 9, 8,
+                                   7, 6, 5, 4, 3, 2, 1, 0);
+    const __m512i sixteen = _mm512_set1_epi32(16);
+    const __m512i thirty_two = _mm512_set1_epi32(32);
+    __m512d acc = _mm512_setzero_pd();
+    std::size_t i = 0;
+    while (i + 32 <= n) {
+        __m512 part0 = _mm512_setzero_ps(), part1 = _mm512_setzero_ps();
+        for (std::size_t v = 0; v < SUM_BLOCK && i + 32 <= n; v += 2, i += 32) {
+            argmax_step_avx512(xf + 2 * i, idx, even, odd, best0, best_i0, part0);
+            argmax_step_avx512(xf + 2 * i + 32, _mm512_add_epi32(idx, sixteen), even, odd,
+                               best1, best_i1, part1);
+            idx = _mm512_add_epi32(idx, thirty_two);
+        }
+        const __m512 part = _mm512_add_ps(part0, part1);
+        acc = _mm512_add_pd(acc, _mm512_add_pd(
+                                     _mm512_cvtps_pd(_mm512_castps512_ps256(part)),
+                                     _mm512_cvtps_pd(_mm256_castpd_ps(
+                                         _mm512_extractf64x4_pd(_mm512_castps_pd(part), 1)))));
+    }
+    // Merge the two sets, then reduce in registers: the overall maximum,
+    // and the lowest index among the lanes holding it.
+    const __mmask16 take = _mm512_cmp_ps_mask(best1, best0, _CMP_GT_OQ) |
+                           (_mm512_cmp_ps_mask(best1, best0, _CMP_EQ_OQ) &
+                            _mm512_cmplt_epi32_mask(best_i1, best_i0));
+    best0 = _mm512_mask_mov_ps(best0, take, best1);
+    best_i0 = _mm512_mask_mov_epi32(best_i0, take, best_i1);
+    float best_v = _mm512_reduce_max_ps(best0);
+    const __mmask16 at = _mm512_cmp_ps_mask(best0, _mm512_set1_ps(best_v), _CMP_EQ_OQ);
+    std::size_t best_idx = static_cast<std::size_t>(
+        _mm512_mask_reduce_min_epi32(at, best_i0));
+    double sum = _mm512_reduce_add_pd(acc);
+    for (; i < n; ++i) {
+        const float m2 = x[i].real() * x[i].real() + x[i].imag() * x[i].imag();
+        sum += m2;
+        if (m2 > best_v) {
+            best_v = m2;
+            best_idx = i;
+        }
+    }
+    *max_mag2 = best_v;
+    *total = sum;
+    return best_idx;
+}
+
+__attribute__((target("avx512f,avx2,fma")))
+inline void sincos_avx512(__m512 x, __m512* s, __m512* c)
+{
+    const __m512 jf = _mm512_roundscale_ps(_mm512_mul_ps(x, _mm512_set1_ps(TWO_OVER_PI)),
+                                           _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+    const __m512i q = _mm512_cvtps_epi32(jf);
+    __m512 y = _mm512_fnmadd_ps(jf, _mm512_set1_ps(PIO2_1), x);
+    y = _mm512_fnmadd_ps(jf, _mm512_set1_ps(PIO2_2), y);
+    y = _mm512_fnmadd_ps(jf, _mm512_set1_ps(PIO2_3), y);
+    const __m512 z = _mm512_mul_ps(y, y);
+    __m512 ps = _mm512_fmadd_ps(_mm512_set1_ps(S3), z, _mm512_set1_ps(S2));
+    ps = _mm512_fmadd_ps(ps, z, _mm512_set1_ps(S1));
+    ps = _mm512_fmadd_ps(_mm512_mul_ps(ps, z), y, y);
+    __m512 pc = _mm512_fmadd_ps(_mm512_set1_ps(C3), z, _mm512_set1_ps(C2));
+    pc = _mm512_fmadd_ps(pc, z, _mm512_set1_ps(C1));
+    pc = _mm512_fmadd_ps(_mm512_mul_ps(pc, z), z,
+                         _mm512_fnmadd_ps(z, _mm512_set1_ps(0.5f), _mm512_set1_ps(1.0f)));
+    const __mmask16 swap = _mm512_test_epi32_mask(q, _mm512_set1_epi32(1));
+    const __m512 sv = _mm512_mask_blend_ps(swap, ps, pc);
+    const __m512 cv = _mm512_mask_blend_ps(swap, pc, ps);
+    const __m512i sbit = _mm512_slli_epi32(_mm512_and_si512(q, _mm512_set1_epi32(2)), 30);
+    const __m512i cbit = _mm512_slli_epi32(
+        _mm512_and_si512(_mm512_add_epi32(q, _mm512_set1_epi32(1)), _mm512_set1_epi32(2)), 30);
+    *s = _mm512_castsi512_ps(_mm512_xor_si512(_mm512_castps_si512(sv), sbit));
+    *c = _mm512_castsi512_ps(_mm512_xor_si512(_mm512_castps_si512(cv), cbit));
+}
+
+__attribute__((target("avx512f,avx2,fma")))
+void polar_avx512(std::complex<float>* dst, const float* phase, float ampl,
+                  std::size_t n)
+{
+    float* d = reinterpret_cast<float*>(dst);
+    const __m512 a = _mm512_set1_ps(ampl);
+    // unpacklo/hi interleave within 128-bit lanes; these indices put the
+    // sixteen (cos, sin) pairs back in sample order.
+    const __m512i lo_idx = _mm512_set_epi32(23, 22, 21, 20, 7, 6, 5, 4,
+                                            19, 18, 17, 16, 3, 2, 1, 0);
+    const __m512i hi_idx = _mm512_set_epi32(31, 30, 29, 28, 15, 14, 13, 12,
+                                            27, 26, 25, 24, 11, 10, 9, 8);
+    std::size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m512 s, c;
+        sincos_avx512(_mm512_loadu_ps(phase + i), &s, &c);
+        s = _mm512_mul_ps(s, a);
+        c = _mm512_mul_ps(c, a);
+        const __m512 lo = _mm512_unpacklo_ps(c, s);
+        const __m512 hi = _mm512_unpackhi_ps(c, s);
+        _mm512_storeu_ps(d + 2 * i, _mm512_permutex2var_ps(lo, lo_idx, hi));
+        _mm512_storeu_ps(d + 2 * i + 16, _mm512_permutex2var_ps(lo, hi_idx, hi));
+    }
+    polar_avx2(dst + i, phase + i, ampl, n - i);
+}
+
+#if !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+#endif // LORA_PHY_X86_DISPATCH
+
+const dsp_kernels k_scalar = {
+    cpu_backend::scalar, radix4_scalar, radix4_batch_scalar,
+    cmul_scalar, derotate_scalar, argmax_scalar, polar_scalar,
+    radix4_q15_scalar, cmul_q15_scalar,
+};
+
+#if defined(LORA_PHY_X86_DISPATCH)
+const dsp_kernels k_sse42 = {
+    cpu_backend::sse42, radix4_sse42, radix4_batch_sse42,
+    cmul_sse42, derotate_sse42, argmax_sse42, polar_sse42,
+    radix4_q15_sse42, cmul_q15_sse42,
+};
+const dsp_kernels k_avx2 = {
+    cpu_backend::avx2, radix4_avx2, radix4_batch_avx2,
+    cmul_avx2_kernel, derotate_avx2, argmax_avx2, polar_avx2,
+    radix4_q15_avx2, cmul_q15_avx2_kernel,
+};
+const dsp_kernels k_avx512 = {
+    cpu_backend::avx512, radix4_avx512, radix4_batch_avx512,
+    cmul_avx512_kernel, derotate_avx512, argmax_avx512, polar_avx512,
+    radix4_q15_avx2, cmul_q15_avx2_kernel,
+};
+#endif
+
+bool host_supports(cpu_backend backend)
+{
+    switch (backend) {
+    case cpu_backend::scalar:
+        return true;
+#if defined(LORA_PHY_X86_DISPATCH)
+    case cpu_backend::sse42:
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("sse4.2");
+    case cpu_backend::avx2:
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+    case cpu_backend::avx512:
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx2") &&
+               __builtin_cpu_supports("fma");
+#endif
+    default:
+        return false;
+    }
+}
+
+} // namespace
+
+cpu_backend detect_cpu_backend()
+{
+    if (host_supports(cpu_backend::avx512)) return cpu_backend::avx512;
+    if (host_supports(cpu_backend::avx2)) return cpu_backend::avx2;
+    if (host_supports(cpu_backend::sse42)) return cpu_backend::sse42;
+    return cpu_backend::scalar;
+}
+
+const dsp_kernels* get_dsp_kernels(cpu_backend backend)
+{
+    if (backend == cpu_backend::automatic) backend = detect_cpu_backend();
+    if (!host_supports(backend)) return nullptr;
+    switch (backend) {
+#if defined(LORA_PHY_X86_DISPATCH)
+    case cpu_backend::sse42: return &k_sse42;
+    case cpu_backend::avx2: return &k_avx2;
+    case cpu_backend::avx512: return &k_avx512;
+#endif
+    default: return &k_scalar;
+    }
+}
+
+const char* cpu_backend_name(cpu_backend backend)
+{
+    switch (backend) {
+    case cpu_backend::automatic: return "automatic";
+    case cpu_backend::scalar: return "scalar";
+    case cpu_backend::sse42: return "sse4.2";
+    case cpu_backend::avx2: return "avx2";
+    case cpu_backend::avx512: return "avx512";
+    }
+    return "unknown";
+}
+
+} // namespace lora_phy
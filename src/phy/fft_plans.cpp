@@ -0,0 +1,412 @@
+#include <lora_phy/fft_plans.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+
+namespace lora_phy {
+
+namespace {
+
+using kissfft_utils::fft_engine;
+using kissfft_utils::KISSFFT_MAX_N;
+using kissfft_utils::KISSFFT_MAX_FACTORS;
+
+// One way of running an FFT length: the iterative power-of-two engine, or
+// the mixed-radix engine with an explicit factor order.
+struct fft_choice {
+    fft_engine engine{fft_engine::pow2};
+    int stages{};
+    int radix[KISSFFT_MAX_FACTORS]{};
+};
+
+bool same_choice(const fft_choice& a, const fft_choice& b)
+{
+    if (a.engine != b.engine) return false;
+    if (a.engine == fft_engine::pow2) return true;
+    return a.stages == b.stages &&
+           std::equal(a.radix, a.radix + a.stages, b.radix);
+}
+
+bool build(kissfft_plan<float>& plan, int nfft, bool inverse,
+           std::complex<float>* twiddles, unsigned short* bitrev,
+           const fft_choice& c)
+{
+    if (c.engine == fft_engine::pow2) {
+        if (!kissfft_utils::is_pow2(nfft)) return false;
+        kissfft<float>::init(plan, nfft, inverse, twiddles, bitrev, fft_engine::pow2);
+        return true;
+    }
+    return kissfft<float>::init_factors(plan, nfft, inverse, twiddles,
+                                        c.radix, c.stages);
+}
+
+// Candidate plans for nfft, deduplicated, estimate choice first.
+int candidates(int nfft, fft_choice* out)
+{
+    int count = 0;
+    auto add = [&](const fft_choice& c) {
+        for (int i = 0; i < count; ++i)
+            if (same_choice(out[i], c)) return;
+        out[count++] = c;
+    };
+
+    fft_choice greedy;
+    greedy.engine = fft_engine::mixed_radix;
+    greedy.stages = kissfft<float>::factorize(nfft, greedy.radix);
+
+    if (kissfft_utils::is_pow2(nfft)) {
+        add(fft_choice{});
+        add(greedy);
+        // Odd radix-2 stage first instead of last, then all radix 2.
+        fft_choice r2first;
+        r2first.engine = fft_engine::mixed_radix;
+        int n = nfft;
+        if (kissfft_utils::ilog2(nfft) & 1) {
+            r2first.radix[r2first.stages++] = 2;
+            n /= 2;
+        }
+        for (; n > 1; n /= 4) r2first.radix[r2first.stages++] = 4;
+        if (r2first.stages == 0) r2first.radix[r2first.stages++] = 1;
+        add(r2first);
+        fft_choice all2;
+        all2.engine = fft_engine::mixed_radix;
+        for (n = nfft; n > 1; n /= 2) all2.radix[all2.stages++] = 2;
+        if (all2.stages > 0) add(all2);
+    } else {
+        add(greedy);
+        fft_choice reversed = greedy;
+        std::reverse(reversed.radix, reversed.radix + reversed.stages);
+        add(reversed);
+    }
+    return count;
+}
+
+// Measured choices keyed by (nfft, inverse, backend); bounded so the table
+// stays static.  Every field is constant-initialised.
+constexpr int MAX_WISDOM = 64;
+
+struct wisdom_entry {
+    int nfft{};
+    bool inverse{};
+    cpu_backend backend{cpu_backend::scalar};
+    fft_choice choice;
+};
+
+std::mutex wisdom_lock;
+wisdom_entry wisdom[MAX_WISDOM];
+int wisdom_count = 0;
+
+// Timing buffers, guarded by wisdom_lock.
+std::complex<float> bench_in[KISSFFT_MAX_N];
+std::complex<float> bench_out[KISSFFT_MAX_N];
+std::complex<float> bench_twiddles[KISSFFT_MAX_N];
+unsigned short bench_bitrev[KISSFFT_MAX_N];
+
+wisdom_entry* find_wisdom(int nfft, bool inverse, cpu_backend backend)
+{
+    for (int i = 0; i < wisdom_count; ++i) {
+        wisdom_entry& e = wisdom[i];
+        if (e.nfft == nfft && e.inverse == inverse && e.backend == backend)
+            return &e;
+    }
+    return nullptr;
+}
+
+// Insert or replace; the oldest entry is dropped when the table is full.
+void remember(int nfft, bool inverse, cpu_backend backend, const fft_choice& c)
+{
+    wisdom_entry* e = find_wisdom(nfft, inverse, backend);
+    if (!e) {
+        if (wisdom_count == MAX_WISDOM) {
+            std::copy(wisdom + 1, wisdom + MAX_WISDOM, wisdom);
+            --wisdom_count;
+        }
+        e = &wisdom[wisdom_count++];
+    }
+    e->nfft = nfft;
+    e->inverse = inverse;
+    e->backend = backend;
+    e->choice = c;
+}
+
+double time_choice(int nfft, bool inverse, const fft_choice& c, const dsp_kernels* k)
+{
+    kissfft_plan<float> plan;
+    if (!build(plan, nfft, inverse, bench_twiddles, bench_bitrev, c)) return -1.0;
+    const kissfft<float> fft(plan, k->fft_radix4);
+    const int reps = std::max(4, 32768 / nfft);
+    double best = 0.0;
+    for (int trial = 0; trial < 3; ++trial) {
+        const auto t0 = std::chrono::steady_clock::now();
+        for (int r = 0; r < reps; ++r) fft.transform(bench_in, bench_out);
+        const std::chrono::duration<double> dt = std::chrono::steady_clock::now() - t0;
+        if (trial == 0 || dt.count() < best) best = dt.count();
+    }
+    return best;
+}
+
+fft_choice measure(int nfft, bool inverse, const dsp_kernels* k)
+{
+    for (int i = 0; i < nfft; ++i)
+        bench_in[i] = std::complex<float>(float((i * 37) % 101) / 101.0f - 0.5f,
+                                          float((i * 53) % 97) / 97.0f - 0.5f);
+    fft_choice list[8];
+    const int count = candidates(nfft, list);
+    int best = 0;
+    double best_time = -1.0;
+    for (int i = 0; i < count; ++i) {
+        const double t = time_choice(nfft, inverse, list[i], k);
+        if (t >= 0.0 && (best_time < 0.0 || t < best_time)) {
+            best = i;
+            best_time = t;
+        }
+    }
+    return list[best];
+}
+
+bool parse_backend(const char* name, cpu_backend* out)
+{
+    for (cpu_backend b : {cpu_backend::scalar, cpu_backend::sse42,
+                          cpu_backend::avx2, cpu_backend::avx512}) {
+        if (std::strcmp(name, cpu_backend_name(b)) == 0) {
+            *out = b;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Parses "<nfft> <fwd|inv> <backend> pow2" or "... mixed r0 r1 ...".
+bool parse_line(char* line, int* nfft, bool* inverse, cpu_backend* backend,
+                fft_choice* c)
+{
+    const char* sep = " \t\r\n";
+    char* save = nullptr;
+    char* tok = strtok_r(line, sep, &save);
+    if (!tok) return false;
+    char* end = nullptr;
+    const long n = std::strtol(tok, &end, 10);
+    if (*end || n < 1 || n > long(KISSFFT_MAX_N)) return false;
+    *nfft = int(n);
+
+    tok = strtok_r(nullptr, sep, &save);
+    if (!tok) return false;
+    if (std::strcmp(tok, "fwd") == 0) *inverse = false;
+    else if (std::strcmp(tok, "inv") == 0) *inverse = true;
+    else return false;
+
+    tok = strtok_r(nullptr, sep, &save);
+    if (!tok || !parse_backend(tok, backend)) return false;
+
+    tok = strtok_r(nullptr, sep, &save);
+    if (!tok) return false;
+    *c = fft_choice{};
+    if (std::strcmp(tok, "pow2") == 0) {
+        c->engine = fft_engine::pow2;
+        return kissfft_utils::is_pow2(*nfft) && !strtok_r(nullptr, sep, &save);
+    }
+    if (std::strcmp(tok, "mixed") != 0) return false;
+    c->engine = fft_engine::mixed_radix;
+    while ((tok = strtok_r(nullptr, sep, &save))) {
+        if (std::size_t(c->stages) == KISSFFT_MAX_FACTORS) return false;
+        const long r = std::strtol(tok, &end, 10);
+        if (*end || r < 1 || r > long(kissfft_utils::KISSFFT_MAX_FFT_RADIX)) return false;
+        c->radix[c->stages++] = int(r);
+    }
+    // Reject factor lists the planner could not build.
+    kissfft_plan<float> probe;
+    return kissfft<float>::init_factors(probe, *nfft, *inverse, bench_twiddles,
+                                        c->radix, c->stages);
+}
+
+} // namespace
+
+int plan_fft(kissfft_plan<float>& plan, int nfft, bool inverse,
+             std::complex<float>* twiddles, unsigned short* bitrev,
+             fft_planning planning, const dsp_kernels* kernels)
+{
+    if (nfft < 1 || static_cast<std::size_t>(nfft) > KISSFFT_MAX_N) return -EINVAL;
+    if (planning == fft_planning::estimate) {
+        kissfft<float>::init(plan, nfft, inverse, twiddles, bitrev);
+        return 0;
+    }
+    if (!kernels) kernels = get_dsp_kernels();
+
+    fft_choice c;
+    {
+        std::lock_guard<std::mutex> lock(wisdom_lock);
+        const wisdom_entry* e = find_wisdom(nfft, inverse, kernels->backend);
+        if (e) {
+            c = e->choice;
+        } else {
+            c = measure(nfft, inverse, kernels);
+            remember(nfft, inverse, kernels->backend, c);
+        }
+    }
+    if (!build(plan, nfft, inverse, twiddles, bitrev, c))
+        kissfft<float>::init(plan, nfft, inverse, twiddles, bitrev);
+    return 0;
+}
+
+int load_fft_wisdom(const char* path)
+{
+    FILE* f = std::fopen(path, "r");
+    if (!f) return -errno;
+    std::lock_guard<std::mutex> lock(wisdom_lock);
+    int ret = 0;
+    char line[256];
+    while (std::fgets(line, sizeof(line), f)) {
+        const char* p = line;
+        while (*p == ' ' || *p == '\t') ++p;
+        if (*p == '#' || *p == '\n' || *p == '\r' || *p == '\0') continue;
+        int nfft;
+        bool inverse;
+        cpu_backend backend;
+        fft_choice c;
+        if (!std::strchr(line, '\n') && !std::feof(f)) {
+            ret = -EINVAL; // line longer than any valid entry
+            break;
+        }
+        if (!parse_line(line, &nfft, &inverse, &backend, &c)) {
+            ret = -EINVAL;
+            break;
+        }
+        remember(nfft, inverse, backend, c);
+    }
+    std::fclose(f);
+    return ret;
+}
+
+int save_fft_wisdom(const char* path)
+{
+    FILE* f = std::fopen(path, "w");
+    if (!f) return -errno;
+    std::lock_guard<std::mutex> lock(wisdom_lock);
+    std::fprintf(f, "# lora_phy fft wisdom v1\n");
+    for (int i = 0; i < wisdom_count; ++i) {
+        const wisdom_entry& e = wisdom[i];
+        std::fprintf(f, "%d %s %s", e.nfft, e.inverse ? "inv" : "fwd",
+                     cpu_backend_name(e.backend));
+        if (e.choice.engine == fft_engine::pow2) {
+            std::fprintf(f, " pow2\n");
+            continue;
+        }
+        std::fprintf(f, " mixed");
+        for (int s = 0; s < e.choice.stages; ++s)
+            std::fprintf(f, " %d", e.choice.radix[s]);
+        std::fprintf(f, "\n");
+    }
+    const bool failed = std::ferror(f) != 0;
+    if (std::fclose(f) != 0 || failed) return errno ? -errno : -EIO;
+    return 0;
+}
+
+void forget_fft_wisdom()
+{
+    std::lock_guard<std::mutex> lock(wisdom_lock);
+    wisdom_count = 0;
+}
+
+#if !LORA_PHY_EMBEDDED_PLANS
+
+namespace {
+
+constexpr int MAX_LOG2N = 12;
+static_assert((std::size_t(1) << MAX_LOG2N) == KISSFFT_MAX_N,
+              "registry slots must cover KISSFFT_MAX_N");
+
+// Slot for N = 2^k starts at offset N - 1, so lengths 1..4096 pack into
+// 2*4096 - 1 entries per direction with each plan sized exactly to N.  Pages
+// backing lengths that are never requested are never touched, so the
+// measured set costs nothing unless it is used.
+constexpr std::size_t ARENA_LEN = 2 * KISSFFT_MAX_N - 1;
+
+// Estimate plans do not depend on the backend, so they share one slot.
+// Measured plans are timed with a particular backend's kernels and get one
+// slot per backend, so a workspace pinned to a narrower ISA never runs a plan
+// chosen for a wider one.
+constexpr int NUM_BACKENDS = 4; // scalar, sse42, avx2, avx512
+constexpr int NUM_SLOTS = 1 + NUM_BACKENDS;
+
+int plan_slot(fft_planning planning, cpu_backend backend)
+{
+    if (planning == fft_planning::estimate) return 0;
+    return 1 + (static_cast<int>(backend) - static_cast<int>(cpu_backend::scalar));
+}
+
+// All registry state is constant-initialised, so shared_fft_plan() is safe to
+// call from other translation units' static constructors.  The first index
+// is the plan_slot(), the second the direction.
+std::mutex build_lock;
+std::atomic<const kissfft_plan<float>*> ready[NUM_SLOTS][2][MAX_LOG2N + 1];
+kissfft_plan<float> plans[NUM_SLOTS][2][MAX_LOG2N + 1];
+std::complex<float> twiddle_arena[NUM_SLOTS][2][ARENA_LEN];
+unsigned short bitrev_arena[NUM_SLOTS][2][ARENA_LEN];
+
+// Q15 plans for the fixed point demodulator, indexed by direction.
+std::atomic<const kissfft_plan<std::int16_t>*> ready_q15[2][MAX_LOG2N + 1];
+kissfft_plan<std::int16_t> plans_q15[2][MAX_LOG2N + 1];
+std::complex<std::int16_t> twiddle_arena_q15[2][ARENA_LEN];
+unsigned short bitrev_arena_q15[2][ARENA_LEN];
+
+} // namespace
+
+const kissfft_plan<float>* shared_fft_plan(int nfft, bool inverse,
+                                           fft_planning planning,
+                                           const dsp_kernels* kernels)
+{
+    if (!kissfft_utils::is_pow2(nfft) ||
+        static_cast<std::size_t>(nfft) > KISSFFT_MAX_N)
+        return nullptr;
+    if (planning == fft_planning::measure && !kernels) kernels = get_dsp_kernels();
+    const int k = kissfft_utils::ilog2(nfft);
+    const int m = plan_slot(planning, kernels ? kernels->backend : cpu_backend::scalar);
+    const int d = inverse ? 1 : 0;
+
+    const kissfft_plan<float>* plan = ready[m][d][k].load(std::memory_order_acquire);
+    if (plan) return plan;
+
+    std::lock_guard<std::mutex> lock(build_lock);
+    plan = ready[m][d][k].load(std::memory_order_relaxed);
+    if (!plan) {
+        const std::size_t off = static_cast<std::size_t>(nfft) - 1;
+        plan_fft(plans[m][d][k], nfft, inverse, twiddle_arena[m][d] + off,
+                 bitrev_arena[m][d] + off, planning, kernels);
+        plan = &plans[m][d][k];
+        ready[m][d][k].store(plan, std::memory_order_release);
+    }
+    return plan;
+}
+
+const kissfft_plan<std::int16_t>* shared_fft_plan_q15(int nfft, bool inverse)
+{
+    if (!kissfft_utils::is_pow2(nfft) ||
+        static_cast<std::size_t>(nfft) > KISSFFT_MAX_N)
+        return nullptr;
+    const int k = kissfft_utils::ilog2(nfft);
+    const int d = inverse ? 1 : 0;
+
+    const kissfft_plan<std::int16_t>* plan = ready_q15[d][k].load(std::memory_order_acquire);
+    if (plan) return plan;
+
+    std::lock_guard<std::mutex> lock(build_lock);
+    plan = ready_q15[d][k].load(std::memory_order_relaxed);
+    if (!plan) {
+        const std::size_t off = static_cast<std::size_t>(nfft) - 1;
+        kissfft<std::int16_t>::init(plans_q15[d][k], nfft, inverse,
+                                    twiddle_arena_q15[d] + off, bitrev_arena_q15[d] + off);
+        plan = &plans_q15[d][k];
+        ready_q15[d][k].store(plan, std::memory_order_release);
+    }
+    return plan;
+}
+
+#endif
+
+} // namespace lora_phy
@@ -0,0 +1,38 @@
+#include <lora_phy/modem.hpp>
+
+namespace lora_phy {
+
+namespace {
+
+template <unsigned SF>
+const modem_ops* find_osr(unsigned osr)
+{
+    switch (osr) {
+    case 1: return modem_ops_for<SF, 1>();
+    case 2: return modem_ops_for<SF, 2>();
+    case 4: return modem_ops_for<SF, 4>();
+    case 8: return modem_ops_for<SF, 8>();
+    default: return nullptr;
+    }
+}
+
+} // namespace
+
+const modem_ops* find_modem(const lora_params* cfg)
+{
+    if (!cfg) return nullptr;
+    const unsigned osr = cfg->osr ? cfg->osr : 1u;
+    switch (cfg->sf) {
+    case 5: return find_osr<5>(osr);
+    case 6: return find_osr<6>(osr);
+    case 7: return find_osr<7>(osr);
+    case 8: return find_osr<8>(osr);
+    case 9: return find_osr<9>(osr);
+    case 10: return find_osr<10>(osr);
+    case 11: return find_osr<11>(osr);
+    case 12: return find_osr<12>(osr);
+    default: return nullptr;
+    }
+}
+
+} // namespace lora_phy
@@ -0,0 +1,91 @@
+#include <lora_phy/nco.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+namespace lora_phy {
+
+namespace {
+const double TWO_PI = 2.0 * std::acos(-1.0);
+}
+
+nco::nco(const dsp_kernels* k, double rate, double phase)
+    : k_(k ? k : get_dsp_kernels(cpu_backend::scalar)), rate_(rate)
+{
+    for (std::size_t i = 0; i < BLOCK; ++i) {
+        const std::complex<double> p = std::polar(1.0, rate * static_cast<double>(i));
+        ramp_[i] = std::complex<float>(static_cast<float>(p.real()),
+                                       static_cast<float>(p.imag()));
+    }
+    step_ = std::polar(1.0, std::fmod(rate * static_cast<double>(BLOCK), TWO_PI));
+    seek(phase);
+}
+
+void nco::seek(double phase)
+{
+    start_ = phase;
+    pos_ = 0;
+    z_ = std::polar(1.0, std::fmod(phase, TWO_PI));
+}
+
+double nco::phase() const
+{
+    return start_ + rate_ * static_cast<double>(pos_);
+}
+
+void nco::advance(std::size_t n)
+{
+    pos_ += n;
+    if (pos_ < BLOCK) return;
+    // Rotate to the next block and pull the magnitude back to one with a
+    // first order Newton step; the error it leaves is O(eps^2).
+    pos_ = 0;
+    start_ += rate_ * static_cast<double>(BLOCK);
+    z_ *= step_;
+    z_ *= 0.5 * (3.0 - std::norm(z_));
+}
+
+void nco::generate(std::complex<float>* dst, std::size_t n)
+{
+    while (n > 0) {
+        const std::size_t chunk = std::min(BLOCK - pos_, n);
+        const std::complex<float> z(static_cast<float>(z_.real()),
+                                    static_cast<float>(z_.imag()));
+        k_->cmul(dst, &z, 0, ramp_ + pos_, chunk);
+        advance(chunk);
+        dst += chunk;
+        n -= chunk;
+    }
+}
+
+void nco::mix(std::complex<float>* dst, const std::complex<float>* src,
+              std::size_t stride, std::size_t n)
+{
+    std::complex<float> ph[BLOCK];
+    while (n > 0) {
+        const std::size_t chunk = std::min(BLOCK - pos_, n);
+        generate(ph, chunk);
+        k_->cmul(dst, src, stride, ph, chunk);
+        dst += chunk;
+        src += chunk * stride;
+        n -= chunk;
+    }
+}
+
+void nco::dechirp(std::complex<float>* dst, const std::complex<float>* src,
+                  std::size_t stride, const std::complex<float>* ref, std::size_t n)
+{
+    while (n > 0) {
+        const std::size_t chunk = std::min(BLOCK - pos_, n);
+        const std::complex<float> z(static_cast<float>(z_.real()),
+                                    static_cast<float>(z_.imag()));
+        k_->derotate(dst, src, stride, ref, ramp_ + pos_, &z, chunk);
+        advance(chunk);
+        dst += chunk;
+        src += chunk * stride;
+        ref += chunk;
+        n -= chunk;
+    }
+}
+
+} // namespace lora_phy
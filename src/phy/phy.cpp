@@ -2,6 +2,8 @@
 #include <lora_phy/LoRaCodes.hpp>
 #include <lora_phy/LoRaDetector.hpp>
 #include <lora_phy/ChirpGenerator.hpp>
+#include <lora_phy/nco.hpp>
+#include <lora_phy/demod_common.hpp>
 
 #include <cmath>
 #include <algorithm>
@@ -13,7 +15,7 @@ namespace {
 
 static unsigned deduce_sf(const lora_workspace* ws) {
     unsigned sf = 0;
-    size_t n = static_cast<size_t>(ws->plan_fwd.nfft);
+    size_t n = ws->plan_fwd ? static_cast<size_t>(ws->plan_fwd->nfft) : 0;
     while ((size_t(1) << sf) < n) ++sf;
     return sf;
 }
@@ -22,17 +24,102 @@ static unsigned get_osr(const lora_workspace* ws) {
     return ws->osr ? ws->osr : 1u;
 }
 
+static const dsp_kernels* get_kernels(const lora_workspace* ws) {
+    return ws->kernels ? ws->kernels : get_dsp_kernels(cpu_backend::scalar);
+}
+
+// Derotate, dechirp and window symbol @p s, whose decimated samples start
+// at @p sym, into ws->fft_in.  @p chirp is N samples of room for the
+// downchirp when the workspace has no dechirp table.
+static void dechirp_symbol(lora_workspace* ws, const dsp_kernels* k, nco& osc, double rate,
+                           size_t N, unsigned osr, int t_off, size_t s,
+                           const std::complex<float>* sym, std::complex<float>* chirp) {
+    // The reference table already carries the window.
+    const std::complex<float>* ref = ws->dechirp;
+    if (!ref) {
+        float tmp = 0.0f;
+        float bw_scale = lora_phy::bw_scale(ws->bw);
+        genChirp(chirp, static_cast<int>(N), 1, static_cast<int>(N),
+                 0.0f, true, 1.0f, tmp, bw_scale, k->polar);
+        ref = chirp;
+    }
+    // Derotate and dechirp the decimated symbol straight into the detector
+    // input in one pass.  A zero rate rotates by exactly one and needs only
+    // the dechirp multiply.
+    if (rate != 0.0) {
+        osc.seek(rate * (static_cast<double>(s * N) +
+                         static_cast<double>(t_off) / static_cast<double>(osr)));
+        osc.dechirp(ws->fft_in, sym, osr, ref, N);
+    } else {
+        k->cmul(ws->fft_in, sym, osr, ref, N);
+    }
+    if (!ws->dechirp && ws->window_kind != window_type::window_none && ws->window) {
+        for (size_t i = 0; i < N; ++i)
+            ws->fft_in[i] *= ws->window[i];
+    }
+}
+
+// Dechirp symbol @p sym against the upchirp, the reference's conjugate,
+// into ws->fft_in, where the SFD's downchirps land on one bin.
+static void updechirp_symbol(lora_workspace* ws, const dsp_kernels* k, size_t N, unsigned osr,
+                             const std::complex<float>* sym, std::complex<float>* chirp) {
+    const std::complex<float>* ref = ws->dechirp;
+    if (!ref) {
+        float tmp = 0.0f;
+        genChirp(chirp, static_cast<int>(N), 1, static_cast<int>(N),
+                 0.0f, true, 1.0f, tmp, lora_phy::bw_scale(ws->bw), k->polar);
+        ref = chirp;
+    }
+    for (size_t i = 0; i < N; ++i)
+        ws->fft_in[i] = sym[i * osr] * std::conj(ref[i]);
+    if (!ws->dechirp && ws->window_kind != window_type::window_none && ws->window) {
+        for (size_t i = 0; i < N; ++i)
+            ws->fft_in[i] *= ws->window[i];
+    }
+}
+
 } // namespace
 
 int init(lora_workspace* ws, const lora_params* cfg) {
     if (!ws || !cfg) return -EINVAL;
+    if (cfg->sf > 12) return -EINVAL; // N = 2^sf must fit KISSFFT_MAX_N
     const int N = 1 << cfg->sf;
-    kissfft<float>::init(ws->plan_fwd, N, false);
-    kissfft<float>::init(ws->plan_inv, N, true);
+    ws->kernels = get_dsp_kernels(cfg->backend);
+    if (!ws->kernels) return -ENOTSUP;
+#if LORA_PHY_EMBEDDED_PLANS
+    plan_fft(ws->plan_fwd_storage, N, false, ws->plan_fwd_storage.twiddle_storage,
+             ws->plan_fwd_storage.bitrev_storage, cfg->planning, ws->kernels);
+    plan_fft(ws->plan_inv_storage, N, true, ws->plan_inv_storage.twiddle_storage,
+             ws->plan_inv_storage.bitrev_storage, cfg->planning, ws->kernels);
+    ws->plan_fwd = &ws->plan_fwd_storage;
+    ws->plan_inv = &ws->plan_inv_storage;
+#else
+    ws->plan_fwd = shared_fft_plan(N, false, cfg->planning, ws->kernels);
+    ws->plan_inv = shared_fft_plan(N, true, cfg->planning, ws->kernels);
+#endif
     ws->metrics = {};
     ws->osr = cfg->osr ? cfg->osr : 1u;
     ws->bw = cfg->bw;
     ws->sync_word = cfg->sync_word;
+    ws->symbol_metrics = cfg->symbol_metrics;
+    ws->chirp = {};
+    if (ws->chirp_buf) {
+        const int rc = lora_chirp_table_init(&ws->chirp, ws->chirp_buf, size_t(N) * ws->osr,
+                                             cfg->sf, ws->osr, ws->bw);
+        if (rc != 0) return rc;
+    }
+    ws->preamble_len = cfg->preamble_len;
+    ws->sfd_quarters = cfg->sfd_quarters;
+    ws->frame_header_len = 0;
+    if (ws->frame_buf) {
+        const size_t hdr = lora_frame_header_len(cfg->sf, ws->osr, ws->preamble_len,
+                                                 ws->sfd_quarters);
+        if (ws->frame_buf_len < hdr) return -ERANGE;
+        ws->frame_header_len =
+            lora_frame_header(ws->frame_buf, cfg->sf, ws->osr, ws->bw, ws->preamble_len,
+                              ws->sfd_quarters, 1.0f, ws->sync_word, ws->kernels,
+                              &ws->frame_phase);
+    }
     ws->window_kind = cfg->window;
     if (ws->window_kind != window_type::window_none && !ws->window)
         return -ENOMEM;
@@ -48,6 +135,14 @@ int init(lora_workspace* ws, const lora_params* cfg) {
             for (int i = 0; i < N; ++i) ws->window[i] = 1.0f;
         }
     }
+    if (ws->dechirp) {
+        float phase = 0.0f;
+        genChirp(ws->dechirp, N, 1, N, 0.0f, true, 1.0f, phase, bw_scale(ws->bw),
+                 ws->kernels->polar);
+        if (ws->window_kind != window_type::window_none && ws->window) {
+            for (int i = 0; i < N; ++i) ws->dechirp[i] *= ws->window[i];
+        }
+    }
     return 0;
 }
 
@@ -55,6 +150,10 @@ void reset(lora_workspace* ws) {
     if (ws) ws->metrics = {};
 }
 
+cpu_backend get_backend(const lora_workspace* ws) {
+    return ws ? get_kernels(ws)->backend : cpu_backend::scalar;
+}
+
 ssize_t encode(lora_workspace* ws,
                const uint8_t* payload, size_t payload_len,
                uint16_t* symbols, size_t symbol_cap) {
@@ -71,17 +170,63 @@ ssize_t modulate(lora_workspace* ws,
     if (!ws || !symbols || !iq) return -EINVAL;
     unsigned sf = deduce_sf(ws);
     unsigned osr = get_osr(ws);
+    if ((symbol_count + 2) * (size_t(1) << sf) * osr > iq_cap) return -ERANGE;
+    if (ws->chirp.samples)
+        return static_cast<ssize_t>(lora_modulate_table(&ws->chirp, symbols, symbol_count, iq,
+                                                        1.0f, ws->sync_word, get_kernels(ws)));
     size_t produced =
         lora_modulate(symbols, symbol_count, iq, sf, osr, ws->bw, 1.0f,
-                      ws->sync_word);
-    if (produced > iq_cap) return -ERANGE;
+                      ws->sync_word, get_kernels(ws));
     return static_cast<ssize_t>(produced);
 }
+
+ssize_t modulate_frame(lora_workspace* ws,
+                       const uint16_t* symbols, size_t symbol_count,
+                       std::complex<float>* iq, size_t iq_cap) {
+    if (!ws || !symbols || !iq) return -EINVAL;
+    unsigned sf = deduce_sf(ws);
+    unsigned osr = get_osr(ws);
+    const size_t hdr = lora_frame_header_len(sf, osr, ws->preamble_len, ws->sfd_quarters);
+    if (hdr + symbol_count * (size_t(1) << sf) * osr > iq_cap) return -ERANGE;
+    float phase = ws->frame_phase;
+    if (ws->frame_header_len == hdr)
+        std::copy_n(ws->frame_buf, hdr, iq);
+    else
+        lora_frame_header(iq, sf, osr, ws->bw, ws->preamble_len, ws->sfd_quarters, 1.0f,
+                          ws->sync_word, get_kernels(ws), &phase);
+    return static_cast<ssize_t>(hdr + lora_modulate_payload(symbols, symbol_count, iq + hdr, sf,
+                                                            osr, ws->bw, phase, 1.0f,
+                                                            get_kernels(ws)));
+}
+
+ssize_t modulate_sc16(lora_workspace* ws,
+                      const uint16_t* symbols, size_t symbol_count,
+                      std::complex<int16_t>* iq, size_t iq_cap, float full_scale) {
+    if (!ws || !symbols || !iq || !(full_scale > 0.0f)) return -EINVAL;
+    unsigned sf = deduce_sf(ws);
+    unsigned osr = get_osr(ws);
+    if ((symbol_count + 2) * (size_t(1) << sf) * osr > iq_cap) return -ERANGE;
+    return static_cast<ssize_t>(lora_modulate_sc16(symbols, symbol_count, iq, sf, osr, ws->bw,
+                                                   full_scale, ws->sync_word,
+                                                   get_kernels(ws)));
+}
+
+ssize_t modulate_cs8(lora_workspace* ws,
+                     const uint16_t* symbols, size_t symbol_count,
+                     std::complex<int8_t>* iq, size_t iq_cap, float full_scale) {
+    if (!ws || !symbols || !iq || !(full_scale > 0.0f)) return -EINVAL;
+    unsigned sf = deduce_sf(ws);
+    unsigned osr = get_osr(ws);
+    if ((symbol_count + 2) * (size_t(1) << sf) * osr > iq_cap) return -ERANGE;
+    return static_cast<ssize_t>(lora_modulate_cs8(symbols, symbol_count, iq, sf, osr, ws->bw,
+                                                  full_scale, ws->sync_word,
+                                                  get_kernels(ws)));
+}
 
 void estimate_offsets(lora_workspace* ws,
                       const std::complex<float>* samples,
                       size_t sample_count) {
-    if (!ws || !samples || sample_count == 0) return;
+    if (!ws || !samples || sample_count == 0 || !ws->plan_fwd) return;
     unsigned sf = deduce_sf(ws);
     unsigned osr = get_osr(ws);
     size_t N = size_t(1) << sf;
@@ -89,8 +234,10 @@ void estimate_offsets(lora_workspace* ws,
     size_t symbols = sample_count / step;
     if (symbols == 0) return;
 
-    kissfft<float> fft(ws->plan_fwd);
-    LoRaDetector<float> detector(N, ws->fft_in, ws->fft_out, fft);
+    const dsp_kernels* k = get_kernels(ws);
+    kissfft<float> fft(*ws->plan_fwd, k->fft_radix4);
+    LoRaDetector<float> detector(N, ws->fft_in, ws->fft_out, fft, k->mag2_argmax);
+    const std::complex<float>* spectrum = detector.inPlace() ? ws->fft_in : ws->fft_out;
 
     float sum_index = 0.0f;
     float phase_diff = 0.0f;
@@ -118,9 +265,20 @@ void estimate_offsets(lora_workspace* ws,
                 best_idx = idx;
                 best_f = findex;
                 best_t = t;
-                best_bin = ws->fft_out[idx];
+                best_bin = spectrum[idx];
             }
         }
+        // Zoom in on the winning phase; fft_in still holds it when it was
+        // the last one examined and the detector runs out of place.
+        if (best_t != osr - 1 || detector.inPlace()) {
+            for (size_t i = 0; i < N; ++i) {
+                std::complex<float> samp = sym[best_t + i * osr];
+                if (ws->window_kind != window_type::window_none && ws->window)
+                    samp *= ws->window[i];
+                detector.feed(i, samp);
+            }
+        }
+        best_f = detector.refine(best_idx);
         sum_t += best_t;
         sum_index += static_cast<float>(best_idx) + best_f;
         float phase = std::arg(best_bin);
@@ -156,14 +314,10 @@ void compensate_offsets(const lora_workspace* ws,
     size_t N = size_t(1) << sf;
     float cfo = ws->metrics.cfo;
     float to = ws->metrics.time_offset;
-    float rate = -2.0f * PI * cfo /
-                 (static_cast<float>(N) * static_cast<float>(osr));
-    for (size_t n = 0; n < sample_count; ++n) {
-        float ph = rate * static_cast<float>(n);
-        float cs = std::cos(ph);
-        float sn = std::sin(ph);
-        samples[n] *= std::complex<float>(cs, sn);
-    }
+    const double rate = -2.0 * PI_D * cfo /
+                        (static_cast<double>(N) * static_cast<double>(osr));
+    nco osc(get_kernels(ws), rate);
+    osc.mix(samples, samples, 1, sample_count);
     int offset = static_cast<int>(std::round(to));
     if (offset > 0 && size_t(offset) < sample_count) {
         for (size_t n = sample_count; n-- > size_t(offset);)
@@ -182,7 +336,13 @@ void compensate_offsets(const lora_workspace* ws,
 ssize_t demodulate(lora_workspace* ws,
                    const std::complex<float>* iq, size_t sample_count,
                    uint16_t* symbols, size_t symbol_cap) {
-    if (!ws || !iq || !symbols) return -EINVAL;
+    return demodulate_soft(ws, iq, sample_count, symbols, symbol_cap, nullptr);
+}
+
+ssize_t demodulate_soft(lora_workspace* ws,
+                        const std::complex<float>* iq, size_t sample_count,
+                        uint16_t* symbols, size_t symbol_cap, float* llrs) {
+    if (!ws || !iq || !symbols || !ws->plan_fwd) return -EINVAL;
     unsigned sf = deduce_sf(ws);
     unsigned osr = get_osr(ws);
     size_t N = size_t(1) << sf;
@@ -196,50 +356,499 @@ ssize_t demodulate(lora_workspace* ws,
     size_t est_samples = std::min(sample_count, step * size_t(2));
     estimate_offsets(ws, iq, est_samples);
 
-    kissfft<float> fft(ws->plan_fwd);
-    LoRaDetector<float> detector(N, ws->fft_in, ws->fft_out, fft);
+    const dsp_kernels* k = get_kernels(ws);
+    kissfft<float> fft(*ws->plan_fwd, k->fft_radix4, k->fft_radix4_batch);
+    // Per-symbol quality needs the noise floor whatever the level.
+    const metrics_level level = ws->quality ? metrics_level::full : ws->symbol_metrics;
+    LoRaDetector<float> detector(N, ws->fft_in, ws->fft_out, fft, k->mag2_argmax, level);
     int t_off = static_cast<int>(std::round(ws->metrics.time_offset));
-    float rate = -2.0f * PI * ws->metrics.cfo / static_cast<float>(N);
+    const double rate = -2.0 * PI_D * ws->metrics.cfo /
+                        static_cast<double>(N);
+    nco osc(k, rate);
+    // Without fft_out the downchirp is built in fft_in and the symbol is
+    // dechirped and transformed there too.
+    const bool in_place = detector.inPlace();
+    std::complex<float>* chirp = in_place ? ws->fft_in : ws->fft_out;
+    // With offsets known every symbol is independent, so when the caller
+    // supplied batch buffers the dechirped symbols are interleaved into
+    // batch_in and transformed together.
+    size_t batch = 1;
+    if (ws->batch_in)
+        batch = std::max<size_t>(1, std::min(ws->batch_len / N, MAX_DEMOD_BATCH));
+    std::complex<float>* batch_out = ws->batch_out ? ws->batch_out : ws->batch_in;
+    size_t idx[MAX_DEMOD_BATCH];
+    float power[MAX_DEMOD_BATCH], power_avg[MAX_DEMOD_BATCH], findex[MAX_DEMOD_BATCH];
+    const bool want_power = level != metrics_level::none;
+    float sum_power = 0.0f, sum_noise = 0.0f;
     uint16_t sw0 = 0, sw1 = 0;
-    for (size_t s = 0; s < total_symbols; ++s) {
-        float tmp = 0.0f;
-        float bw_scale = lora_phy::bw_scale(ws->bw);
-        genChirp(ws->fft_out, static_cast<int>(N), 1, static_cast<int>(N),
-                 0.0f, true, 1.0f, tmp, bw_scale);
-        size_t base = s * step;
-        if (t_off > 0) {
-            if (base + size_t(t_off) + step <= sample_count)
-                base += size_t(t_off);
-        } else if (t_off < 0) {
-            size_t off = size_t(-t_off);
-            if (off <= base) base -= off;
+    for (size_t s0 = 0; s0 < total_symbols; s0 += batch) {
+        const size_t count = std::min(batch, total_symbols - s0);
+        for (size_t b = 0; b < count; ++b) {
+            const size_t s = s0 + b;
+            const size_t base = detail::symbol_base(s, step, t_off, sample_count);
+            dechirp_symbol(ws, k, osc, rate, N, osr, t_off, s, iq + base, chirp);
+            if (count > 1) {
+                for (size_t i = 0; i < N; ++i)
+                    ws->batch_in[i * count + b] = ws->fft_in[i];
+            }
         }
-        const std::complex<float>* sym = iq + base;
-        float start = rate * (static_cast<float>(s * N) +
-                               static_cast<float>(t_off) / static_cast<float>(osr));
-        for (size_t i = 0; i < N; ++i) {
-            float ph = start + rate * static_cast<float>(i);
-            float cs = std::cos(ph);
-            float sn = std::sin(ph);
-            std::complex<float> samp =
-                sym[i * osr] * ws->fft_out[i] * std::complex<float>(cs, sn);
-            if (ws->window_kind != window_type::window_none && ws->window)
-                samp *= ws->window[i];
-            detector.feed(i, samp);
+        if (count == 1) {
+            idx[0] = detector.detect(power[0], power_avg[0], findex[0]);
+        } else if (want_power) {
+            detector.detectBatch(ws->batch_in, batch_out, count, idx, power, power_avg, findex);
+        } else {
+            detector.detectBatch(ws->batch_in, batch_out, count, idx);
         }
+        for (size_t b = 0; b < count; ++b) {
+            const size_t s = s0 + b;
+            if (s == 0)
+                sw0 = static_cast<uint16_t>(idx[b]);
+            else if (s == 1)
+                sw1 = static_cast<uint16_t>(idx[b]);
+            else {
+                // Spectra are where detect()/detectBatch() left them.
+                const std::complex<float>* spectrum =
+                    count == 1 ? (in_place ? ws->fft_in : ws->fft_out) : batch_out + b;
+                if (llrs) detector.softBits(spectrum, count, llrs + (s - 2) * sf);
+                if (s - 2 < ws->quality_len && ws->quality) {
+                    lora_symbol_quality& q = ws->quality[s - 2];
+                    q.peak_power = power[b];
+                    q.noise_power = power_avg[b];
+                    q.peak_to_second = detector.peakToSecond(spectrum, count);
+                }
+                if (want_power) {
+                    sum_power += power[b];
+                    sum_noise += power_avg[b];
+                }
+                symbols[s - 2] = static_cast<uint16_t>(idx[b]);
+            }
+        }
+    }
+    detail::payload_metrics(ws->metrics, level, sum_power, sum_noise, num_symbols);
+    ws->sync_word = detail::pack_sync(N, sw0, sw1);
+    return static_cast<ssize_t>(num_symbols);
+}
+
+namespace {
+
+// Start of symbol @p s's window in the stream, shifted by the timing offset
+// as in demodulate().  Windows the shift pushed past the end of the packet
+// are read unshifted by lora_demod_stream_flush().
+size_t stream_window(const lora_demod_stream* st, size_t s, size_t step) {
+    const size_t base = s * step;
+    if (st->t_off > 0) return base + size_t(st->t_off);
+    const size_t off = size_t(-st->t_off);
+    return off <= base ? base - off : base;
+}
+
+// Forget the packet, keeping the workspace and buffer.
+void stream_restart(lora_demod_stream* st) {
+    st->start = st->len = st->received = st->symbol = st->payload = 0;
+    st->estimated = false;
+    st->t_off = 0;
+    st->rate = 0.0;
+    st->sum_power = st->sum_noise = 0.0f;
+}
+
+// Drop the carried samples before stream index @p from; also serves
+// lora_frame_sync's history.
+template <typename Stream>
+void stream_drop(Stream* st, size_t from) {
+    const size_t have = st->start + st->len;
+    if (from >= have) {
+        st->len = 0;
+    } else if (from > st->start) {
+        std::copy(st->buf + (from - st->start), st->buf + st->len, st->buf);
+        st->len = have - from;
+    } else {
+        return;
+    }
+    st->start = from;
+}
+
+// Receiver state that lives for one push or flush call.
+struct stream_rx {
+    lora_demod_stream* st;
+    const dsp_kernels* k;
+    unsigned sf, osr;
+    kissfft<float> fft;
+    LoRaDetector<float> detector;
+    nco osc;
+
+    stream_rx(lora_demod_stream* s, unsigned sf_, unsigned osr_)
+        : st(s), k(get_kernels(s->ws)), sf(sf_), osr(osr_),
+          fft(*s->ws->plan_fwd, k->fft_radix4),
+          detector(size_t(1) << sf_, s->ws->fft_in, s->ws->fft_out, fft, k->mag2_argmax,
+                   s->ws->symbol_metrics),
+          osc(k, s->rate) {}
+
+    // Decide the stream's next symbol from @p window; a payload symbol is
+    // appended to @p symbols at @p n.
+    void decide(const std::complex<float>* window, uint16_t* symbols, size_t& n) {
+        lora_workspace* ws = st->ws;
+        std::complex<float>* chirp = detector.inPlace() ? ws->fft_in : ws->fft_out;
+        dechirp_symbol(ws, k, osc, st->rate, size_t(1) << sf, osr, st->t_off, st->symbol,
+                       window, chirp);
         float p, pav, findex;
-        size_t idx = detector.detect(p, pav, findex);
-        if (s == 0)
-            sw0 = static_cast<uint16_t>(idx);
-        else if (s == 1)
-            sw1 = static_cast<uint16_t>(idx);
+        const uint16_t idx = static_cast<uint16_t>(detector.detect(p, pav, findex));
+        if (st->symbol < 2) {
+            st->sync[st->symbol] = idx;
+            if (st->symbol == 1)
+                ws->sync_word = detail::pack_sync(size_t(1) << sf, st->sync[0], st->sync[1]);
+        } else {
+            symbols[n++] = idx;
+            st->sum_power += p;
+            st->sum_noise += pav;
+            ++st->payload;
+            detail::payload_metrics(ws->metrics, ws->symbol_metrics, st->sum_power, st->sum_noise,
+                            st->payload);
+        }
+        ++st->symbol;
+    }
+};
+
+} // namespace
+
+size_t lora_demod_stream_buffer_len(const lora_workspace* ws) {
+    if (!ws || !ws->plan_fwd) return 0;
+    return 2 * (size_t(1) << deduce_sf(ws)) * get_osr(ws);
+}
+
+int lora_demod_stream_init(lora_demod_stream* st, lora_workspace* ws,
+                           std::complex<float>* buf, size_t buf_len) {
+    if (!st || !ws || !buf || !ws->plan_fwd) return -EINVAL;
+    if (buf_len < lora_demod_stream_buffer_len(ws)) return -ERANGE;
+    st->ws = ws;
+    st->buf = buf;
+    st->buf_len = buf_len;
+    stream_restart(st);
+    return 0;
+}
+
+ssize_t lora_demod_stream_push(lora_demod_stream* st,
+                               const std::complex<float>* iq, size_t sample_count,
+                               uint16_t* symbols, size_t symbol_cap) {
+    if (!st || !st->ws || !symbols || (!iq && sample_count)) return -EINVAL;
+    lora_workspace* ws = st->ws;
+    const unsigned sf = deduce_sf(ws);
+    const unsigned osr = get_osr(ws);
+    const size_t N = size_t(1) << sf;
+    const size_t step = N * osr;
+    // Payload windows are one step apart, so a chunk completes at most
+    // one more than it holds.
+    if (symbol_cap < sample_count / step + 1) return -ERANGE;
+
+    size_t pos = 0;
+    if (!st->estimated) {
+        pos = std::min(sample_count, 2 * step - st->len);
+        std::copy(iq, iq + pos, st->buf + st->len);
+        st->len += pos;
+        st->received += pos;
+        if (st->len < 2 * step) return 0;
+        estimate_offsets(ws, st->buf, 2 * step);
+        st->t_off = static_cast<int>(std::round(ws->metrics.time_offset));
+        st->rate = -2.0 * PI_D * ws->metrics.cfo / static_cast<double>(N);
+        st->estimated = true;
+        detail::payload_metrics(ws->metrics, ws->symbol_metrics, 0.0f, 0.0f, 0);
+    }
+
+    // The rest of the chunk covers stream indices [c0, end).
+    const std::complex<float>* chunk = iq + pos;
+    const size_t c0 = st->received;
+    const size_t end = c0 + (sample_count - pos);
+    size_t n = 0;
+    if (stream_window(st, st->symbol, step) + step <= end) {
+        stream_rx rx(st, sf, osr);
+        for (;;) {
+            const size_t b = stream_window(st, st->symbol, step);
+            if (b + step > end) break;
+            const std::complex<float>* window;
+            if (b >= c0) {
+                window = chunk + (b - c0);
+            } else if (b + step <= st->start + st->len) {
+                window = st->buf + (b - st->start);
+            } else {
+                // The window straddles the carry and the chunk: drop what
+                // precedes it and complete it from the chunk.
+                stream_drop(st, b);
+                const size_t have = st->start + st->len;
+                std::copy(chunk + (have - c0), chunk + (b + step - c0), st->buf + st->len);
+                st->len = step;
+                window = st->buf;
+            }
+            rx.decide(window, symbols, n);
+        }
+    }
+
+    // Carry what the next window, or its unshifted fallback, still needs.
+    const size_t keep = std::min(stream_window(st, st->symbol, step), st->symbol * step);
+    stream_drop(st, keep);
+    const size_t have = st->start + st->len;
+    std::copy(chunk + (have - c0), chunk + (end - c0), st->buf + st->len);
+    st->len += end - have;
+    st->received = end;
+    return static_cast<ssize_t>(n);
+}
+
+ssize_t lora_demod_stream_flush(lora_demod_stream* st, uint16_t* symbols, size_t symbol_cap) {
+    if (!st || !st->ws || !symbols) return -EINVAL;
+    if (!st->estimated) {
+        stream_restart(st);
+        return -ERANGE;
+    }
+    const unsigned sf = deduce_sf(st->ws);
+    const unsigned osr = get_osr(st->ws);
+    const size_t step = (size_t(1) << sf) * osr;
+    const size_t total = st->received / step;
+    size_t n = 0;
+    if (st->symbol < total) {
+        const size_t first = std::max<size_t>(st->symbol, 2);
+        if (total > first && total - first > symbol_cap) return -ERANGE;
+        stream_rx rx(st, sf, osr);
+        // Only a positive timing offset leaves windows behind; demodulate()
+        // reads those at their unshifted position.
+        while (st->symbol < total)
+            rx.decide(st->buf + (st->symbol * step - st->start), symbols, n);
+    }
+    stream_restart(st);
+    return static_cast<ssize_t>(n);
+}
+
+namespace {
+
+// Peak of one synchroniser window.
+struct sync_peak {
+    size_t bin;  ///< FFT argmax
+    float at;    ///< fractional peak position, wrapped to (-N/2, N/2]
+    float ratio; ///< peak to mean of the other bins, dB
+};
+
+// Search and alignment state that lives for one push call.
+struct sync_rx {
+    lora_frame_sync* fs;
+    const dsp_kernels* k;
+    size_t N;
+    unsigned osr;
+    kissfft<float> fft;
+    LoRaDetector<float> detector;
+    nco osc;
+    float mean_db; ///< noise total to mean, 10 log10(N - 1)
+
+    sync_rx(lora_frame_sync* f, unsigned sf, unsigned osr_)
+        : fs(f), k(get_kernels(f->ws)), N(size_t(1) << sf), osr(osr_),
+          fft(*f->ws->plan_fwd, k->fft_radix4),
+          detector(N, f->ws->fft_in, f->ws->fft_out, fft, k->mag2_argmax,
+                   metrics_level::full),
+          osc(k, 0.0), mean_db(10.0f * std::log10(static_cast<float>(N - 1))) {}
+
+    // Dechirp @p window for upchirps or, with @p down, for downchirps.
+    void dechirp(const std::complex<float>* window, bool down) {
+        lora_workspace* ws = fs->ws;
+        std::complex<float>* chirp = detector.inPlace() ? ws->fft_in : ws->fft_out;
+        if (down)
+            updechirp_symbol(ws, k, N, osr, window, chirp);
         else
-            symbols[s - 2] = static_cast<uint16_t>(idx);
+            dechirp_symbol(ws, k, osc, 0.0, N, osr, 0, 0, window, chirp);
     }
-    unsigned shift = sf > 4 ? (sf - 4) : 0;
-    ws->sync_word = static_cast<uint8_t>(((sw0 >> shift) & 0x0f) << 4 |
-                                         ((sw1 >> shift) & 0x0f));
-    return static_cast<ssize_t>(num_symbols);
+
+    // Peak of @p window dechirped as above; @p fine zooms in on its position
+    // instead of interpolating.  Silence yields a NaN ratio, which no
+    // threshold passes.
+    sync_peak peak(const std::complex<float>* window, bool down, bool fine) {
+        dechirp(window, down);
+        float p, pav, findex;
+        const size_t idx = detector.detect(p, pav, findex);
+        ++fs->stats.windows;
+        if (fine) {
+            if (detector.inPlace()) dechirp(window, down);
+            findex = detector.refine(idx);
+        }
+        float at = static_cast<float>(idx) + findex;
+        if (at > 0.5f * static_cast<float>(N)) at -= static_cast<float>(N);
+        return {idx, at, p - pav + mean_db};
+    }
+};
+
+// Search again from stream index @p from.
+void sync_search(lora_frame_sync* fs, size_t from) {
+    fs->state = frame_sync_state::search;
+    fs->next = from;
+    fs->run = 0;
+    fs->run_snr = 0.0f;
+}
+
+// Search window at fs->next: extend or restart the run of agreeing peaks,
+// and once it is long enough move onto the preamble's symbol grid.
+void sync_search_window(lora_frame_sync* fs, sync_rx& rx, size_t step) {
+    const sync_peak up = rx.peak(fs->buf + (fs->next - fs->start), false, false);
+    if (up.ratio >= fs->threshold) {
+        const size_t d = (up.bin - fs->run_bin) & (rx.N - 1);
+        if (fs->run != 0 && d > 1 && d != rx.N - 1) {
+            fs->run = 0;
+            fs->run_snr = 0.0f;
+        }
+        ++fs->run;
+        fs->run_snr += up.ratio;
+        fs->run_bin = static_cast<uint16_t>(up.bin);
+    } else {
+        fs->run = 0;
+        fs->run_snr = 0.0f;
+    }
+    if (fs->run < fs->min_preamble) {
+        fs->next += step;
+        return;
+    }
+    ++fs->stats.detections;
+    fs->frame.snr = fs->run_snr / static_cast<float>(fs->run);
+    // Taking the CFO as zero, the peak is how many chips the window lags
+    // the upchirps; the next window starts on the following boundary.
+    const long shift = std::lround(up.at * static_cast<float>(rx.osr));
+    const float residual = up.at - static_cast<float>(shift) / static_cast<float>(rx.osr);
+    fs->next = static_cast<size_t>(static_cast<long>(fs->next + step) - shift);
+    fs->up_bins[0] = fs->up_bins[1] = fs->up_bins[2] = residual;
+    fs->aligned = 0;
+    fs->state = frame_sync_state::preamble;
+}
+
+// Aligned window at fs->next: a preamble or sync word upchirp, or the
+// first SFD downchirp.  Upchirps peak at cfo + lag and downchirps at
+// cfo - lag, lag being how many chips the window starts after the chirp,
+// so the SFD and the last preamble window before the sync word give both.
+// Returns true when the frame is confirmed, with fs->frame filled in.
+bool sync_preamble_window(lora_frame_sync* fs, sync_rx& rx, size_t step) {
+    const size_t w = fs->next;
+    const std::complex<float>* window = fs->buf + (w - fs->start);
+    const sync_peak up = rx.peak(window, false, true);
+    const sync_peak down = rx.peak(window, true, true);
+    ++fs->aligned;
+    if (!(down.ratio >= fs->threshold) || !(down.ratio > up.ratio)) {
+        if (up.ratio >= fs->threshold && fs->aligned <= fs->ws->preamble_len + 3) {
+            fs->up_bins[0] = fs->up_bins[1];
+            fs->up_bins[1] = fs->up_bins[2];
+            fs->up_bins[2] = up.at;
+            fs->next += step;
+            return false;
+        }
+        // Lost the chirps, or no SFD where one was due.
+        ++fs->stats.false_alarms;
+        sync_search(fs, w + step);
+        return false;
+    }
+    const float cfo = 0.5f * (fs->up_bins[0] + down.at);
+    const float lag = 0.5f * (fs->up_bins[0] - down.at);
+    const double sync = static_cast<double>(w) -
+                        static_cast<double>(lag) * static_cast<double>(rx.osr) -
+                        2.0 * static_cast<double>(step);
+    if (sync < static_cast<double>(fs->start)) {
+        ++fs->stats.false_alarms;
+        sync_search(fs, w + step);
+        return false;
+    }
+    lora_rx_frame& f = fs->frame;
+    f.start = static_cast<size_t>(std::llround(sync));
+    f.time_offset = static_cast<float>(sync - static_cast<double>(f.start));
+    f.cfo = cfo;
+    f.confirmed = w + step;
+    ++fs->stats.frames;
+    fs->stats.latency_sum += f.confirmed - f.start;
+    fs->stats.latency_max = std::max(fs->stats.latency_max, f.confirmed - f.start);
+    return true;
+}
+
+} // namespace
+
+size_t lora_frame_sync_buffer_len(const lora_workspace* ws) {
+    if (!ws || !ws->plan_fwd) return 0;
+    return 6 * (size_t(1) << deduce_sf(ws)) * get_osr(ws);
+}
+
+int lora_frame_sync_init(lora_frame_sync* fs, lora_workspace* ws,
+                         std::complex<float>* buf, size_t buf_len,
+                         uint16_t* payload, size_t payload_symbols) {
+    if (!fs || !ws || !buf || !payload || payload_symbols == 0 || !ws->plan_fwd)
+        return -EINVAL;
+    if (buf_len < lora_frame_sync_buffer_len(ws)) return -ERANGE;
+    *fs = lora_frame_sync{};
+    fs->ws = ws;
+    fs->buf = buf;
+    fs->buf_len = buf_len;
+    fs->payload = payload;
+    fs->payload_symbols = payload_symbols;
+    fs->demod.ws = ws;
+    return 0;
+}
+
+ssize_t lora_frame_sync_push(lora_frame_sync* fs,
+                             const std::complex<float>* iq, size_t sample_count,
+                             lora_rx_frame* frames, size_t frame_cap, uint16_t* symbols) {
+    if (!fs || !fs->ws || !frames || !symbols || (!iq && sample_count)) return -EINVAL;
+    lora_workspace* ws = fs->ws;
+    const unsigned sf = deduce_sf(ws);
+    const unsigned osr = get_osr(ws);
+    const size_t N = size_t(1) << sf;
+    const size_t step = N * osr;
+    const size_t frame_len = fs->payload_symbols * step;
+    // Consecutive frames end at least their sync word and payload apart.
+    if (frame_cap < sample_count / (frame_len + step) + 1) return -ERANGE;
+
+    sync_rx rx(fs, sf, osr);
+    lora_demod_stream* st = &fs->demod;
+    size_t count = 0;
+    for (size_t pos = 0; pos < sample_count;) {
+        const size_t take = std::min(sample_count - pos, fs->buf_len - fs->len);
+        std::copy(iq + pos, iq + pos + take, fs->buf + fs->len);
+        fs->len += take;
+        pos += take;
+        fs->stats.samples += take;
+        const size_t have = fs->start + fs->len;
+
+        while (fs->next + step <= have) {
+            if (fs->state == frame_sync_state::search) {
+                sync_search_window(fs, rx, step);
+                continue;
+            }
+            if (fs->state == frame_sync_state::preamble) {
+                if (!sync_preamble_window(fs, rx, step)) continue;
+                // Hand the sync word to the demodulator at the frame's
+                // offsets; the SFD is skipped.
+                ws->metrics.cfo = fs->frame.cfo;
+                ws->metrics.time_offset = fs->frame.time_offset;
+                stream_restart(st);
+                st->estimated = true;
+                st->rate = -2.0 * PI_D * fs->frame.cfo / static_cast<double>(N);
+                detail::payload_metrics(ws->metrics, ws->symbol_metrics, 0.0f, 0.0f, 0);
+                stream_rx drx(st, sf, osr);
+                size_t n = 0;
+                drx.decide(fs->buf + (fs->frame.start - fs->start), fs->payload, n);
+                drx.decide(fs->buf + (fs->frame.start + step - fs->start), fs->payload, n);
+                fs->next = fs->frame.start + 2 * step + size_t(ws->sfd_quarters) * step / 4;
+                fs->state = frame_sync_state::payload;
+                continue;
+            }
+            stream_rx drx(st, sf, osr);
+            size_t n = st->payload;
+            while (n < fs->payload_symbols && fs->next + step <= have) {
+                drx.decide(fs->buf + (fs->next - fs->start), fs->payload, n);
+                fs->next += step;
+            }
+            if (n < fs->payload_symbols) break;
+            lora_rx_frame& f = frames[count];
+            f = fs->frame;
+            f.sync_word = ws->sync_word;
+            f.symbols = symbols + count * fs->payload_symbols;
+            std::copy(fs->payload, fs->payload + n, f.symbols);
+            ++count;
+            sync_search(fs, fs->next);
+        }
+
+        // Keep the next window and, before a frame is confirmed, the three
+        // symbols its sync word may lie in.  Past the SFD the next window
+        // may start beyond what arrived.
+        size_t keep = std::min(fs->next, have);
+        if (fs->state != frame_sync_state::payload) keep = keep > 3 * step ? keep - 3 * step : 0;
+        stream_drop(fs, keep);
+    }
+    return static_cast<ssize_t>(count);
 }
 
 ssize_t decode(lora_workspace* ws,
@@ -0,0 +1,133 @@
+#include <lora_phy/phy.hpp>
+#include <cerrno>
+#include <cmath>
+#include <complex>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+// The chirp table modulator must reproduce lora_modulate (genChirp with
+// std::polar) for every SF, OSR and bandwidth, on every backend, and through
+// the high level workspace.  genChirp accumulates frequency and phase in
+// float, so its absolute phase drifts along long chirps, and at the one
+// sample per symbol where the sweep wraps its float compare may wrap a step
+// early.  The comparison is therefore on the instantaneous frequency (the
+// phase step between samples), allowing one wrap sample per symbol, plus
+// the absolute samples where the wrap is a whole turn and genChirp's drift
+// is still small.
+
+using namespace lora_phy;
+
+// Largest phase step difference outside the samples where the two differ
+// by more than wrap_tol (at most one per symbol is allowed).
+static float step_error(const std::vector<std::complex<float>>& a,
+                        const std::vector<std::complex<float>>& b, size_t len, bool& ok) {
+    const float pi = std::acos(-1.0f);
+    float err = 0.0f;
+    size_t outliers = 0;
+    for (size_t i = 1; i < a.size(); ++i) {
+        float d = std::arg(a[i] * std::conj(a[i - 1])) - std::arg(b[i] * std::conj(b[i - 1]));
+        d -= 2.0f * pi * std::round(d / (2.0f * pi));
+        if (std::abs(d) > 0.1f)
+            ++outliers;
+        else
+            err = std::max(err, std::abs(d));
+    }
+    ok = outliers <= a.size() / len;
+    return err;
+}
+
+static float max_error(const std::vector<std::complex<float>>& a,
+                       const std::vector<std::complex<float>>& b) {
+    float err = 0.0f;
+    for (size_t i = 0; i < a.size(); ++i) err = std::max(err, std::abs(a[i] - b[i]));
+    return err;
+}
+
+int main() {
+    bool ok = true;
+    const size_t n_syms = 8;
+    for (unsigned sf : {7u, 9u, 12u}) {
+        const size_t N = size_t(1) << sf;
+        std::vector<uint16_t> syms(n_syms);
+        for (size_t i = 0; i < n_syms; ++i)
+            syms[i] = static_cast<uint16_t>((i * 0x9e37u + 1) % N);
+        syms[0] = 0;
+        syms[1] = static_cast<uint16_t>(N - 1);
+        for (unsigned osr : {1u, 2u, 4u}) {
+            for (bandwidth bw : {bandwidth::bw_125, bandwidth::bw_250, bandwidth::bw_500}) {
+                const size_t len = N * osr;
+                std::vector<std::complex<float>> table_buf(len), want((n_syms + 2) * len),
+                    got(want.size());
+                lora_chirp_table table;
+                if (lora_chirp_table_init(&table, table_buf.data(), len, sf, osr, bw) != 0) {
+                    std::cerr << "table init failed\n";
+                    return 1;
+                }
+                lora_modulate(syms.data(), n_syms, want.data(), sf, osr, bw, 0.8f, 0x34);
+                lora_modulate_table(&table, syms.data(), n_syms, got.data(), 0.8f, 0x34);
+                bool wraps_ok = true;
+                const float err = step_error(want, got, len, wraps_ok);
+                // At 125 kHz without oversampling a wrap is a whole turn.
+                if (err > 2e-3f || !wraps_ok ||
+                    (sf == 7 && osr == 1 && bw == bandwidth::bw_125 &&
+                     max_error(want, got) > 5e-3f)) {
+                    std::cerr << "sf " << sf << " osr " << osr << " bw " << unsigned(bw)
+                              << ": table modulator step error " << err << ", sample error "
+                              << max_error(want, got) << "\n";
+                    ok = false;
+                }
+                for (cpu_backend b : {cpu_backend::sse42, cpu_backend::avx2,
+                                      cpu_backend::avx512}) {
+                    const dsp_kernels* k = get_dsp_kernels(b);
+                    if (!k) continue;
+                    std::vector<std::complex<float>> vec(got.size());
+                    lora_modulate_table(&table, syms.data(), n_syms, vec.data(), 0.8f, 0x34, k);
+                    if (max_error(vec, got) > 1e-6f) {
+                        std::cerr << cpu_backend_name(b) << " table modulator differs\n";
+                        ok = false;
+                    }
+                }
+            }
+        }
+    }
+
+    std::complex<float> small[16];
+    lora_chirp_table table;
+    if (lora_chirp_table_init(&table, small, 16, 7, 1, bandwidth::bw_125) != -ERANGE ||
+        lora_chirp_table_init(&table, small, 16, 13, 1, bandwidth::bw_125) != -EINVAL ||
+        lora_chirp_table_init(&table, small, 16, 4, 0, bandwidth::bw_125) != -EINVAL) {
+        std::cerr << "bad table parameters accepted\n";
+        ok = false;
+    }
+
+    // modulate() uses the table when the workspace carries one.
+    const unsigned sf = 8;
+    const unsigned osr = 2;
+    const size_t M = (size_t(1) << sf) * osr;
+    std::vector<std::complex<float>> fft_buf(M), chirp(M), plain((n_syms + 2) * M),
+        fast(plain.size());
+    std::vector<uint16_t> syms(n_syms);
+    for (size_t i = 0; i < n_syms; ++i) syms[i] = static_cast<uint16_t>(i * 31);
+    lora_params cfg{};
+    cfg.sf = sf;
+    cfg.osr = osr;
+    cfg.bw = bandwidth::bw_250;
+    lora_workspace ws{};
+    ws.fft_in = fft_buf.data();
+    bool wraps_ok = true;
+    if (init(&ws, &cfg) != 0 ||
+        modulate(&ws, syms.data(), n_syms, plain.data(), plain.size()) != ssize_t(plain.size())) {
+        std::cerr << "workspace setup failed\n";
+        return 1;
+    }
+    ws.chirp_buf = chirp.data();
+    if (init(&ws, &cfg) != 0 || ws.chirp.len != M ||
+        modulate(&ws, syms.data(), n_syms, fast.data(), fast.size()) != ssize_t(fast.size()) ||
+        step_error(plain, fast, M, wraps_ok) > 2e-3f || !wraps_ok) {
+        std::cerr << "workspace table modulation differs\n";
+        ok = false;
+    }
+
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,95 @@
+#include <lora_phy/LoRaDetector.hpp>
+#include <lora_phy/phy.hpp>
+#include <algorithm>
+#include <chrono>
+#include <complex>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "signal_utils.hpp"
+#ifdef __x86_64__
+#include <x86intrin.h>
+#endif
+
+// Microbenchmark of the post-FFT stage of LoRaDetector::detect: the fused
+// magnitude/argmax/energy kernel of every backend the host runs, and the
+// whole detect() call (FFT included) for scale, with full metrics and with
+// DetectorMetrics::none.  Cycles per bin are written to
+// logs/detect_perf_<RUN_ID>.csv.
+
+using namespace lora_phy;
+
+static unsigned long long ticks() {
+#ifdef __x86_64__
+    return __rdtsc();
+#else
+    return static_cast<unsigned long long>(
+        std::chrono::high_resolution_clock::now().time_since_epoch().count());
+#endif
+}
+
+int main() {
+    const char* env_run = std::getenv("RUN_ID");
+    std::string run_id = env_run ? env_run : "run";
+    std::string path = "logs/detect_perf_" + run_id + ".csv";
+
+    std::system("mkdir -p logs");
+    std::ofstream csv(path);
+    csv << "run_id,backend,N,kernel_cycles_per_bin,detect_cycles_per_bin,"
+           "detect_none_cycles_per_bin\n";
+
+    bool ok = true;
+    for (cpu_backend b : {cpu_backend::scalar, cpu_backend::sse42, cpu_backend::avx2,
+                          cpu_backend::avx512}) {
+        const dsp_kernels* k = get_dsp_kernels(b);
+        if (!k) continue;
+        for (size_t N : {size_t(128), size_t(1024), size_t(4096)}) {
+            const size_t reps = (size_t(1) << 22) / N;
+            detector_fixture fx(N, k);
+            const std::vector<std::complex<float>> input = random_vector(N, 1);
+            std::copy(input.begin(), input.end(), fx.in.begin());
+            LoRaDetector<float>& detector = fx.detector;
+            std::vector<std::complex<float>>& out = fx.out;
+            fx.fft.transform(fx.in.data(), out.data());
+
+            float v;
+            double total;
+            size_t peak = 0;
+            unsigned long long t0 = ticks();
+            for (size_t r = 0; r < reps; ++r)
+                peak = k->mag2_argmax(out.data(), N, &v, &total);
+            unsigned long long t1 = ticks();
+            const double kernel = double(t1 - t0) / double(reps * N);
+
+            float p, pav, fi;
+            size_t found = 0;
+            t0 = ticks();
+            for (size_t r = 0; r < reps; ++r)
+                found = detector.detect(p, pav, fi);
+            t1 = ticks();
+            const double whole = double(t1 - t0) / double(reps * N);
+            detector.setMetrics(DetectorMetrics::none);
+            size_t bare = 0;
+            t0 = ticks();
+            for (size_t r = 0; r < reps; ++r)
+                bare = detector.detect(p, pav, fi);
+            t1 = ticks();
+            const double argmax_only = double(t1 - t0) / double(reps * N);
+            if (found != peak || bare != peak) {
+                std::cerr << "detect and mag2_argmax disagree on " << cpu_backend_name(b) << "\n";
+                ok = false;
+            }
+
+            csv << run_id << ',' << cpu_backend_name(b) << ',' << N << ',' << kernel << ','
+                << whole << ',' << argmax_only << '\n';
+            std::cout << '[' << run_id << "] detect " << cpu_backend_name(b) << " N=" << N
+                      << ": " << kernel << " cycles/bin kernel, " << whole
+                      << " cycles/bin detect, " << argmax_only << " without metrics" << std::endl;
+        }
+    }
+
+    return ok ? 0 : 1;
+}
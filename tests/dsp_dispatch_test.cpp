@@ -0,0 +1,150 @@
+#include <lora_phy/phy.hpp>
+#include <lora_phy/dsp_kernels.hpp>
+#include <cmath>
+#include <complex>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+#include "signal_utils.hpp"
+
+// Every backend the host can run must agree with the scalar kernels: exact
+// argmax decisions (including the lowest-index tie rule) and tolerance
+// matches for the floating point kernels.
+
+static bool check_backend(const lora_phy::dsp_kernels* ref,
+                          const lora_phy::dsp_kernels* k) {
+    using namespace lora_phy;
+    const char* name = cpu_backend_name(k->backend);
+    bool ok = true;
+
+    static kissfft_embedded_plan<float> plan;
+    for (int n = 4; n <= 4096; n *= 2) {
+        kissfft<float>::init(plan, n, false);
+        auto in = random_vector(size_t(n), uint32_t(n));
+        std::vector<std::complex<float>> a(in.size());
+        std::vector<std::complex<float>> b(in.size());
+        kissfft<float>(plan, ref->fft_radix4).transform(in.data(), a.data());
+        kissfft<float>(plan, k->fft_radix4).transform(in.data(), b.data());
+        float err = 0.0f, peak = 1.0f;
+        for (size_t i = 0; i < in.size(); ++i) {
+            err = std::max(err, std::abs(a[i] - b[i]));
+            peak = std::max(peak, std::abs(a[i]));
+        }
+        if (err / peak > 1e-5f) {
+            std::cerr << name << ": fft N=" << n << " error " << err / peak << "\n";
+            ok = false;
+        }
+    }
+
+    for (size_t stride : {size_t(1), size_t(3)}) {
+        const size_t n = 37;
+        auto a = random_vector(n * stride, 7u);
+        auto b = random_vector(n, 11u);
+        std::vector<std::complex<float>> r(n), v(n);
+        ref->cmul(r.data(), a.data(), stride, b.data(), n);
+        k->cmul(v.data(), a.data(), stride, b.data(), n);
+        for (size_t i = 0; i < n; ++i) {
+            if (std::abs(r[i] - v[i]) > 1e-6f) {
+                std::cerr << name << ": cmul stride " << stride << " bin " << i << "\n";
+                ok = false;
+                break;
+            }
+        }
+    }
+
+    for (size_t stride : {size_t(1), size_t(3)}) {
+        const size_t n = 37;
+        auto a = random_vector(n * stride, 13u);
+        auto b = random_vector(n, 17u);
+        auto c = random_vector(n, 19u);
+        const std::complex<float> z(0.6f, -0.8f);
+        std::vector<std::complex<float>> r(n), v(n);
+        ref->derotate(r.data(), a.data(), stride, b.data(), c.data(), &z, n);
+        k->derotate(v.data(), a.data(), stride, b.data(), c.data(), &z, n);
+        for (size_t i = 0; i < n; ++i) {
+            if (std::abs(r[i] - v[i]) > 1e-6f) {
+                std::cerr << name << ": derotate stride " << stride << " bin " << i << "\n";
+                ok = false;
+                break;
+            }
+        }
+    }
+
+    for (size_t n : {size_t(5), size_t(128), size_t(1000), size_t(4096)}) {
+        auto x = random_vector(n, uint32_t(n) * 3u);
+        // Plant a tie: two equal maxima, the lower index must win.
+        x[n / 3] = std::complex<float>(4.0f, 0.0f);
+        x[n - 1] = std::complex<float>(0.0f, 4.0f);
+        float rv, kv;
+        double rt, kt;
+        size_t ri = ref->mag2_argmax(x.data(), n, &rv, &rt);
+        size_t ki = k->mag2_argmax(x.data(), n, &kv, &kt);
+        if (ri != ki || rv != kv || std::abs(rt - kt) > 1e-6 * rt) {
+            std::cerr << name << ": argmax n=" << n << " got " << ki
+                      << " expected " << ri << "\n";
+            ok = false;
+        }
+    }
+
+    std::vector<float> ph(1001);
+    for (size_t i = 0; i < ph.size(); ++i)
+        ph[i] = -8000.0f + 16.0f * static_cast<float>(i) + 0.001f * static_cast<float>(i * i % 97);
+    std::vector<std::complex<float>> out(ph.size());
+    k->polar(out.data(), ph.data(), 0.5f, ph.size());
+    for (size_t i = 0; i < ph.size(); ++i) {
+        const double p = ph[i];
+        const std::complex<double> exact(0.5 * std::cos(p), 0.5 * std::sin(p));
+        if (std::abs(std::complex<double>(out[i]) - exact) > 1e-6) {
+            std::cerr << name << ": polar phase " << ph[i] << "\n";
+            ok = false;
+            break;
+        }
+    }
+    return ok;
+}
+
+int main() {
+    using namespace lora_phy;
+    bool ok = true;
+
+    const dsp_kernels* best = get_dsp_kernels();
+    if (!best || best->backend != detect_cpu_backend()) {
+        std::cerr << "automatic backend does not match detection\n";
+        return 1;
+    }
+    std::cout << "DSP backend: " << cpu_backend_name(best->backend) << std::endl;
+
+    const dsp_kernels* ref = get_dsp_kernels(cpu_backend::scalar);
+    for (cpu_backend b : {cpu_backend::sse42, cpu_backend::avx2, cpu_backend::avx512}) {
+        const dsp_kernels* k = get_dsp_kernels(b);
+        if (k) ok = check_backend(ref, k) && ok;
+    }
+
+    // The selection made at init time is reported back through the API.
+    std::vector<std::complex<float>> fft_in(128), fft_out(128);
+    lora_workspace ws{};
+    ws.fft_in = fft_in.data();
+    ws.fft_out = fft_out.data();
+    lora_params cfg{};
+    cfg.sf = 7;
+    cfg.backend = cpu_backend::scalar;
+    if (init(&ws, &cfg) != 0 || get_backend(&ws) != cpu_backend::scalar) {
+        std::cerr << "init did not honour the scalar backend\n";
+        ok = false;
+    }
+    cfg.backend = cpu_backend::automatic;
+    if (init(&ws, &cfg) != 0 || get_backend(&ws) != best->backend) {
+        std::cerr << "init did not select the detected backend\n";
+        ok = false;
+    }
+
+    lora_demod_workspace dws{};
+    lora_demod_init(&dws, 7);
+    if (lora_demod_backend(&dws) != best->backend) {
+        std::cerr << "lora_demod_init did not select the detected backend\n";
+        ok = false;
+    }
+    lora_demod_free(&dws);
+
+    return ok ? 0 : 1;
+}
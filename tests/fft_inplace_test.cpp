@@ -0,0 +1,114 @@
+#include <lora_phy/LoRaDetector.hpp>
+#include <lora_phy/phy.hpp>
+#include <cmath>
+#include <complex>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+#include "signal_utils.hpp"
+
+// In-place transforms must match out-of-place ones for both engines, single
+// and batched, and a demodulator without fft_out must decide the same
+// symbols as one with both buffers.
+
+using namespace lora_phy;
+
+static bool close(const std::vector<std::complex<float>>& a,
+                  const std::vector<std::complex<float>>& b) {
+    for (size_t i = 0; i < a.size(); ++i)
+        if (std::abs(a[i] - b[i]) > 1e-6f * (1.0f + std::abs(a[i]))) return false;
+    return true;
+}
+
+int main() {
+    bool ok = true;
+    static kissfft_embedded_plan<float> plan;
+    const dsp_kernels* k = get_dsp_kernels();
+
+    for (int n : {1, 2, 8, 32, 256, 2048, 4096, 12, 60, 100}) {
+        kissfft<float>::init(plan, n, false);
+        const kissfft<float> fft(plan, k->fft_radix4, k->fft_radix4_batch);
+        auto in = random_vector(size_t(n), uint32_t(n));
+        std::vector<std::complex<float>> ref(in.size());
+        fft.transform(in.data(), ref.data());
+        auto x = in;
+        fft.transform_inplace(x.data());
+        if (!close(ref, x)) {
+            std::cerr << "transform_inplace mismatch at N=" << n << "\n";
+            ok = false;
+        }
+        if (n > 256) continue;
+        const size_t count = 5;
+        auto batch = random_vector(size_t(n) * count, 3u);
+        std::vector<std::complex<float>> bref(batch.size());
+        fft.transform_batch(batch.data(), bref.data(), count);
+        fft.transform_batch(batch.data(), batch.data(), count);
+        if (!close(bref, batch)) {
+            std::cerr << "in-place transform_batch mismatch at N=" << n << "\n";
+            ok = false;
+        }
+    }
+
+    // Detector in-place mode reports the same peak and stats.
+    const size_t N = 128;
+    kissfft<float>::init(plan, int(N), false);
+    kissfft<float> fft(plan);
+    std::vector<std::complex<float>> a(N), b(N);
+    LoRaDetector<float> two(N, a.data(), b.data(), fft);
+    LoRaDetector<float> one(N, a.data(), nullptr, fft);
+    if (two.inPlace() || !one.inPlace()) {
+        std::cerr << "inPlace() misreported\n";
+        ok = false;
+    }
+    auto sym = random_vector(N, 9u);
+    sym[41] += std::complex<float>(3.0f, 1.0f);
+    for (size_t i = 0; i < N; ++i) two.feed(i, sym[i]);
+    float p0, a0, f0, p1, a1, f1;
+    const size_t i0 = two.detect(p0, a0, f0);
+    for (size_t i = 0; i < N; ++i) one.feed(i, sym[i]);
+    const size_t i1 = one.detect(p1, a1, f1);
+    if (i0 != i1 || std::abs(p0 - p1) > 1e-4f || std::abs(f0 - f1) > 1e-5f ||
+        std::abs(a[i1] - b[i0]) > 1e-5f) {
+        std::cerr << "in-place detect mismatch\n";
+        ok = false;
+    }
+
+    // demodulate() and estimate_offsets() without fft_out.
+    const unsigned sf = 8;
+    const size_t n_syms = 9;
+    const size_t M = size_t(1) << sf;
+    std::vector<uint16_t> tx(n_syms);
+    for (size_t i = 0; i < n_syms; ++i) tx[i] = static_cast<uint16_t>((i * 71 + 3) % M);
+    std::vector<std::complex<float>> iq((n_syms + 2) * M);
+    std::vector<std::complex<float>> ws_in(M), ws_out(M);
+    lora_workspace ws{};
+    ws.fft_in = ws_in.data();
+    ws.fft_out = ws_out.data();
+    lora_params cfg{};
+    cfg.sf = sf;
+    if (init(&ws, &cfg) != 0 ||
+        modulate(&ws, tx.data(), n_syms, iq.data(), iq.size()) != ssize_t(iq.size())) {
+        std::cerr << "workspace setup failed\n";
+        return 1;
+    }
+    std::vector<uint16_t> two_buf(n_syms), one_buf(n_syms), one_batch(n_syms);
+    demodulate(&ws, iq.data(), iq.size(), two_buf.data(), two_buf.size());
+    const lora_metrics ref_metrics = ws.metrics;
+    ws.fft_out = nullptr;
+    demodulate(&ws, iq.data(), iq.size(), one_buf.data(), one_buf.size());
+    if (one_buf != two_buf || std::abs(ws.metrics.cfo - ref_metrics.cfo) > 1e-6f ||
+        ws.metrics.time_offset != ref_metrics.time_offset) {
+        std::cerr << "in-place demodulate mismatch\n";
+        ok = false;
+    }
+    std::vector<std::complex<float>> batch_buf(M * 4);
+    ws.batch_in = batch_buf.data();
+    ws.batch_len = batch_buf.size();
+    demodulate(&ws, iq.data(), iq.size(), one_batch.data(), one_batch.size());
+    if (one_batch != two_buf) {
+        std::cerr << "in-place batched demodulate mismatch\n";
+        ok = false;
+    }
+
+    return ok ? 0 : 1;
+}
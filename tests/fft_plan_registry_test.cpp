@@ -0,0 +1,102 @@
+#include <lora_phy/phy.hpp>
+#include <atomic>
+#include <cerrno>
+#include <complex>
+#include <cstdint>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+// Workspaces share read-only plans from the process-wide registry.  Plans
+// handed out to concurrent callers must be the same object and transform
+// exactly like a privately initialised embedded plan.
+
+int main() {
+    using namespace lora_phy;
+#if LORA_PHY_EMBEDDED_PLANS
+    std::cout << "FFT plan registry disabled (embedded plans)" << std::endl;
+    return 0;
+#else
+    bool ok = true;
+
+    if (shared_fft_plan(12, false) || shared_fft_plan(8192, false) ||
+        shared_fft_plan(0, true)) {
+        std::cerr << "registry accepted an unsupported length\n";
+        ok = false;
+    }
+
+    // Race first use of every length from several threads.
+    const int threads = 8;
+    std::vector<const kissfft_plan<float>*> seen(threads * 26);
+    std::atomic<int> start{0};
+    std::vector<std::thread> pool;
+    for (int t = 0; t < threads; ++t) {
+        pool.emplace_back([&, t]() {
+            start.fetch_add(1);
+            while (start.load() < threads) {}
+            for (int k = 0; k <= 12; ++k) {
+                seen[size_t(t * 26 + 2 * k)] = shared_fft_plan(1 << k, false);
+                seen[size_t(t * 26 + 2 * k + 1)] = shared_fft_plan(1 << k, true);
+            }
+        });
+    }
+    for (auto& th : pool) th.join();
+    for (int t = 1; t < threads; ++t) {
+        for (int i = 0; i < 26; ++i) {
+            if (seen[size_t(t * 26 + i)] != seen[size_t(i)]) {
+                std::cerr << "threads received different plans\n";
+                ok = false;
+            }
+        }
+    }
+
+    static kissfft_embedded_plan<float> ref_plan;
+    for (int k = 0; k <= 12; ++k) {
+        const int n = 1 << k;
+        for (int inv = 0; inv < 2; ++inv) {
+            const kissfft_plan<float>* plan = shared_fft_plan(n, inv != 0);
+            if (!plan || plan->nfft != n || plan->inverse != (inv != 0)) {
+                std::cerr << "N=" << n << " bad shared plan\n";
+                ok = false;
+                continue;
+            }
+            kissfft<float>::init(ref_plan, n, inv != 0);
+            std::vector<std::complex<float>> in(static_cast<size_t>(n));
+            for (int i = 0; i < n; ++i)
+                in[size_t(i)] = std::complex<float>(float(i % 7) - 3.0f, float(i % 5) - 2.0f);
+            std::vector<std::complex<float>> a(in.size());
+            std::vector<std::complex<float>> b(in.size());
+            kissfft<float>(*plan).transform(in.data(), a.data());
+            kissfft<float>(ref_plan).transform(in.data(), b.data());
+            if (a != b) {
+                std::cerr << "N=" << n << " shared plan differs from embedded plan\n";
+                ok = false;
+            }
+        }
+    }
+
+    // Two workspaces at the same SF reference one plan.
+    std::vector<std::complex<float>> in0(256), out0(256), in1(256), out1(256);
+    lora_workspace ws0{};
+    lora_workspace ws1{};
+    ws0.fft_in = in0.data();
+    ws0.fft_out = out0.data();
+    ws1.fft_in = in1.data();
+    ws1.fft_out = out1.data();
+    lora_params cfg{};
+    cfg.sf = 8;
+    if (init(&ws0, &cfg) != 0 || init(&ws1, &cfg) != 0 ||
+        ws0.plan_fwd != ws1.plan_fwd || ws0.plan_inv != ws1.plan_inv ||
+        ws0.plan_fwd != shared_fft_plan(256, false)) {
+        std::cerr << "workspaces do not share plans\n";
+        ok = false;
+    }
+    cfg.sf = 13;
+    if (init(&ws0, &cfg) != -EINVAL) {
+        std::cerr << "init accepted sf beyond KISSFFT_MAX_N\n";
+        ok = false;
+    }
+
+    return ok ? 0 : 1;
+#endif
+}
@@ -0,0 +1,169 @@
+#include <lora_phy/phy.hpp>
+#include <lora_phy/fft_plans.hpp>
+#include <cerrno>
+#include <cmath>
+#include <complex>
+#include <cstdio>
+#include <iostream>
+#include <vector>
+
+// Measured planning may pick a different engine or factor order, but every
+// plan it produces must compute the same transform as the estimate plan.
+// Wisdom written by save_fft_wisdom() must be honoured after a reload.
+
+using namespace lora_phy;
+
+static std::vector<std::complex<float>> make_input(size_t n) {
+    std::vector<std::complex<float>> v(n);
+    for (size_t i = 0; i < n; ++i)
+        v[i] = std::complex<float>(std::cos(0.37f * float(i)), std::sin(0.11f * float(i * i % 251)));
+    return v;
+}
+
+static bool same_transform(const kissfft_plan<float>& a, const kissfft_plan<float>& b) {
+    auto in = make_input(size_t(a.nfft));
+    std::vector<std::complex<float>> x(in.size()), y(in.size());
+    kissfft<float>(a).transform(in.data(), x.data());
+    kissfft<float>(b).transform(in.data(), y.data());
+    float err = 0.0f, peak = 1.0f;
+    for (size_t i = 0; i < in.size(); ++i) {
+        err = std::max(err, std::abs(x[i] - y[i]));
+        peak = std::max(peak, std::abs(x[i]));
+    }
+    return err / peak < 1e-4f;
+}
+
+static bool same_layout(const kissfft_plan<float>& a, const kissfft_plan<float>& b) {
+    if (a.nfft != b.nfft || a.engine != b.engine || a.stages != b.stages) return false;
+    for (int s = 0; s < a.stages; ++s)
+        if (a.stageRadix[s] != b.stageRadix[s]) return false;
+    return true;
+}
+
+int main() {
+    bool ok = true;
+    static kissfft_embedded_plan<float> ref, got;
+
+    for (int n : {1, 2, 8, 128, 512, 4096, 12, 60, 100}) {
+        for (bool inverse : {false, true}) {
+            kissfft<float>::init(ref, n, inverse);
+            if (plan_fft(got, n, inverse, got.twiddle_storage, got.bitrev_storage,
+                         fft_planning::estimate) != 0 || !same_layout(ref, got)) {
+                std::cerr << "estimate plan differs from kissfft::init at N=" << n << "\n";
+                ok = false;
+            }
+            if (plan_fft(got, n, inverse, got.twiddle_storage, got.bitrev_storage,
+                         fft_planning::measure) != 0 || !same_transform(ref, got)) {
+                std::cerr << "measured plan is wrong at N=" << n << "\n";
+                ok = false;
+            }
+        }
+    }
+    if (plan_fft(got, 0, false, got.twiddle_storage, got.bitrev_storage,
+                 fft_planning::measure) != -EINVAL ||
+        plan_fft(got, 8192, false, got.twiddle_storage, got.bitrev_storage,
+                 fft_planning::estimate) != -EINVAL) {
+        std::cerr << "out of range lengths accepted\n";
+        ok = false;
+    }
+
+    const int bad_radix[] = {4, 3};
+    if (kissfft<float>::init_factors(got, 16, false, got.twiddle_storage, bad_radix, 2)) {
+        std::cerr << "init_factors accepted a factorization of the wrong length\n";
+        ok = false;
+    }
+
+    // Force a choice through a wisdom file and check it is used.
+    const char* path = "fft_planner_test.wisdom";
+    const dsp_kernels* k = get_dsp_kernels();
+    FILE* f = std::fopen(path, "w");
+    std::fprintf(f, "# lora_phy fft wisdom v1\n256 fwd %s mixed 2 2 2 2 2 2 2 2\n",
+                 cpu_backend_name(k->backend));
+    std::fclose(f);
+    forget_fft_wisdom();
+    if (load_fft_wisdom(path) != 0) {
+        std::cerr << "wisdom file rejected\n";
+        ok = false;
+    }
+    plan_fft(got, 256, false, got.twiddle_storage, got.bitrev_storage,
+             fft_planning::measure, k);
+    if (got.engine != kissfft_utils::fft_engine::mixed_radix || got.stages != 8) {
+        std::cerr << "loaded wisdom was not honoured\n";
+        ok = false;
+    }
+
+    // Round trip: save, forget, reload, same plan without measuring.
+    plan_fft(got, 1024, true, got.twiddle_storage, got.bitrev_storage,
+             fft_planning::measure, k);
+    static kissfft_embedded_plan<float> before;
+    plan_fft(before, 1024, true, before.twiddle_storage, before.bitrev_storage,
+             fft_planning::measure, k);
+    if (save_fft_wisdom(path) != 0) {
+        std::cerr << "save_fft_wisdom failed\n";
+        ok = false;
+    }
+    forget_fft_wisdom();
+    if (load_fft_wisdom(path) != 0) {
+        std::cerr << "saved wisdom could not be reloaded\n";
+        ok = false;
+    }
+    plan_fft(got, 1024, true, got.twiddle_storage, got.bitrev_storage,
+             fft_planning::measure, k);
+    if (!same_layout(before, got)) {
+        std::cerr << "reloaded wisdom picked a different plan\n";
+        ok = false;
+    }
+
+    for (const char* bad : {"256 fwd nosuchisa pow2\n", "12 fwd scalar pow2\n",
+                            "16 inv scalar mixed 4 3\n", "garbage\n"}) {
+        f = std::fopen(path, "w");
+        std::fputs(bad, f);
+        std::fclose(f);
+        if (load_fft_wisdom(path) != -EINVAL) {
+            std::cerr << "malformed wisdom accepted: " << bad;
+            ok = false;
+        }
+    }
+    std::remove(path);
+    if (load_fft_wisdom(path) != -ENOENT) {
+        std::cerr << "missing wisdom file not reported\n";
+        ok = false;
+    }
+    forget_fft_wisdom();
+
+    // The high level API plans with the requested mode.
+    std::vector<std::complex<float>> fft_in(256), fft_out(256);
+    lora_workspace ws{};
+    ws.fft_in = fft_in.data();
+    ws.fft_out = fft_out.data();
+    lora_params cfg{};
+    cfg.sf = 8;
+    cfg.planning = fft_planning::measure;
+    kissfft<float>::init(ref, 256, false);
+    if (init(&ws, &cfg) != 0 || !ws.plan_fwd || !same_transform(ref, *ws.plan_fwd)) {
+        std::cerr << "init with measured planning failed\n";
+        ok = false;
+    }
+#if !LORA_PHY_EMBEDDED_PLANS
+    if (shared_fft_plan(256, false, fft_planning::measure) != ws.plan_fwd) {
+        std::cerr << "measured registry plan not shared\n";
+        ok = false;
+    }
+
+    // Measured plans are timed per backend, so a workspace pinned to scalar
+    // must not reuse the plan measured for the host's best backend.
+    const dsp_kernels* scalar = get_dsp_kernels(cpu_backend::scalar);
+    if (k->backend != cpu_backend::scalar &&
+        shared_fft_plan(256, false, fft_planning::measure, scalar) == ws.plan_fwd) {
+        std::cerr << "measured registry plan shared across backends\n";
+        ok = false;
+    }
+    if (shared_fft_plan(256, false, fft_planning::measure, scalar) !=
+        shared_fft_plan(256, false, fft_planning::measure, scalar)) {
+        std::cerr << "scalar measured registry plan not shared\n";
+        ok = false;
+    }
+#endif
+
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,86 @@
+#include <lora_phy/kissfft.hh>
+#include <cmath>
+#include <complex>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+#include "signal_utils.hpp"
+
+// Compare the iterative power-of-two engine against the generic mixed-radix
+// KISS FFT path (and a double precision DFT for short lengths).  The engines
+// round differently, so agreement is checked against a tolerance relative to
+// the peak output magnitude.
+
+static float max_abs(const std::vector<std::complex<float>>& v) {
+    float m = 0.0f;
+    for (const auto& x : v) m = std::max(m, std::abs(x));
+    return m;
+}
+
+int main() {
+    using fft = kissfft<float>;
+    using kissfft_utils::fft_engine;
+    bool ok = true;
+
+    static kissfft_embedded_plan<float> pow2_plan;
+    static kissfft_embedded_plan<float> ref_plan;
+
+    for (int log2n = 0; log2n <= 12; ++log2n) {
+        const int n = 1 << log2n;
+        for (int inv = 0; inv < 2; ++inv) {
+            fft::init(pow2_plan, n, inv != 0);
+            fft::init(ref_plan, n, inv != 0, fft_engine::mixed_radix);
+            if (pow2_plan.engine != fft_engine::pow2) {
+                std::cerr << "N=" << n << " not bound to pow2 engine\n";
+                ok = false;
+                continue;
+            }
+            auto in = random_vector(size_t(n), 0x1234u + uint32_t(n) + uint32_t(inv));
+            std::vector<std::complex<float>> out(static_cast<size_t>(n));
+            std::vector<std::complex<float>> ref(static_cast<size_t>(n));
+            fft(pow2_plan).transform(in.data(), out.data());
+            fft(ref_plan).transform(in.data(), ref.data());
+
+            const float scale = std::max(max_abs(ref), 1.0f);
+            float err = 0.0f;
+            for (int i = 0; i < n; ++i)
+                err = std::max(err, std::abs(out[size_t(i)] - ref[size_t(i)]));
+            const float tol = 2e-6f * static_cast<float>(log2n + 1);
+            if (err / scale > tol) {
+                std::cerr << "N=" << n << (inv ? " inverse" : " forward")
+                          << " pow2 vs mixed-radix error " << err / scale
+                          << " exceeds " << tol << "\n";
+                ok = false;
+            }
+
+            if (n <= 64) {
+                const double sign = inv ? 2.0 : -2.0;
+                const double pi = std::acos(-1.0);
+                for (int k = 0; k < n; ++k) {
+                    std::complex<double> acc(0.0, 0.0);
+                    for (int t = 0; t < n; ++t) {
+                        const double ph = sign * pi * double(k) * double(t) / double(n);
+                        acc += std::complex<double>(in[size_t(t)]) *
+                               std::complex<double>(std::cos(ph), std::sin(ph));
+                    }
+                    const double d = std::abs(acc - std::complex<double>(out[size_t(k)]));
+                    if (d / scale > tol) {
+                        std::cerr << "N=" << n << " bin " << k
+                                  << " differs from DFT by " << d << "\n";
+                        ok = false;
+                        break;
+                    }
+                }
+            }
+        }
+    }
+
+    // Non power-of-two lengths must keep using the generic path.
+    fft::init(ref_plan, 12, false);
+    if (ref_plan.engine != fft_engine::mixed_radix) {
+        std::cerr << "N=12 not bound to mixed-radix engine\n";
+        ok = false;
+    }
+
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,198 @@
+#include <lora_phy/LoRaDetector.hpp>
+#include <lora_phy/phy.hpp>
+#include <cmath>
+#include <complex>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+#include "signal_utils.hpp"
+
+// The Q15 FFT (block floating point on the power-of-two engine, 1/N scaling
+// on the mixed-radix one) must track the float transform, every backend's
+// Q15 kernels must reproduce the scalar reference bit for bit, and the int16
+// detector and lora_demodulate_sc16 must decide like their float versions.
+
+using namespace lora_phy;
+using cq15 = std::complex<int16_t>;
+
+static std::vector<std::complex<float>> make_input(size_t n, uint32_t seed, float ampl) {
+    auto v = random_vector(n, seed);
+    for (auto& x : v) x *= 2.0f * ampl;
+    return v;
+}
+
+static std::vector<cq15> to_q15(const std::vector<std::complex<float>>& v) {
+    std::vector<cq15> q(v.size());
+    for (size_t i = 0; i < v.size(); ++i)
+        q[i] = cq15(kissfft_utils::q15_unit(v[i].real()), kissfft_utils::q15_unit(v[i].imag()));
+    return q;
+}
+
+static std::vector<std::complex<float>> from_q15(const std::vector<cq15>& q) {
+    std::vector<std::complex<float>> v(q.size());
+    for (size_t i = 0; i < q.size(); ++i)
+        v[i] = std::complex<float>(q[i].real(), q[i].imag()) / 32768.0f;
+    return v;
+}
+
+// RMS deviation of the rescaled Q15 spectrum from the float spectrum of the
+// same (quantised) input, relative to the float spectrum's RMS.
+static float q15_error(const kissfft<float>& ref, const kissfft<int16_t>& fft,
+                       const std::vector<std::complex<float>>& in) {
+    auto q = to_q15(in);
+    const auto exact = from_q15(q);
+    std::vector<std::complex<float>> want(in.size());
+    ref.transform(exact.data(), want.data());
+    const int e = fft.transform_scaled(q.data(), q.data());
+    const float scale = std::ldexp(1.0f, e) / 32768.0f;
+    double err = 0.0, power = 0.0;
+    for (size_t i = 0; i < in.size(); ++i) {
+        const std::complex<float> got(q[i].real() * scale, q[i].imag() * scale);
+        err += std::norm(got - want[i]);
+        power += std::norm(want[i]);
+    }
+    return float(std::sqrt(err / power));
+}
+
+int main() {
+    bool ok = true;
+    static kissfft_embedded_plan<float> fplan;
+    static kissfft_embedded_plan<int16_t> qplan;
+
+    // Full-scale noise and a weak input: block floating point keeps both
+    // within a few LSB of the float result.
+    for (int n : {2, 8, 32, 128, 512, 4096}) {
+        kissfft<float>::init(fplan, n, false);
+        kissfft<int16_t>::init(qplan, n, false);
+        const kissfft<float> ref(fplan);
+        const kissfft<int16_t> fft(qplan);
+        for (float ampl : {0.99f, 0.01f}) {
+            const float err = q15_error(ref, fft, make_input(size_t(n), uint32_t(n), ampl));
+            if (err > 2e-3f) {
+                std::cerr << "Q15 FFT error " << err << " at N=" << n << " ampl " << ampl << "\n";
+                ok = false;
+            }
+        }
+    }
+    kissfft<float>::init(fplan, 12, false);
+    kissfft<int16_t>::init(qplan, 12, false);
+    {
+        const kissfft<float> ref(fplan);
+        const kissfft<int16_t> fft(qplan);
+        auto in = make_input(12, 5u, 0.9f);
+        std::vector<std::complex<float>> want(in.size());
+        ref.transform(in.data(), want.data());
+        auto q = to_q15(in);
+        fft.transform(q.data(), q.data());
+        float err = 0.0f;
+        for (size_t i = 0; i < in.size(); ++i)
+            err = std::max(err, std::abs(std::complex<float>(q[i].real(), q[i].imag()) * 12.0f / 32768.0f -
+                                         want[i]));
+        if (err > 2e-2f) {
+            std::cerr << "mixed-radix Q15 FFT error " << err << "\n";
+            ok = false;
+        }
+    }
+
+    // Vector kernels against the scalar table.
+    const dsp_kernels* scalar = get_dsp_kernels(cpu_backend::scalar);
+    for (cpu_backend b : {cpu_backend::sse42, cpu_backend::avx2, cpu_backend::avx512}) {
+        const dsp_kernels* k = get_dsp_kernels(b);
+        if (!k) continue;
+        for (int n : {4, 16, 64, 256, 2048}) {
+            kissfft<int16_t>::init(qplan, n, n == 64);
+            const kissfft<int16_t> ref(qplan, scalar->fft_radix4_q15);
+            const kissfft<int16_t> vec(qplan, k->fft_radix4_q15);
+            auto in = to_q15(make_input(size_t(n), 7u, 0.99f));
+            std::vector<cq15> x(in.size()), y(in.size());
+            const int ex = ref.transform_scaled(in.data(), x.data());
+            const int ey = vec.transform_scaled(in.data(), y.data());
+            if (ex != ey || x != y) {
+                std::cerr << cpu_backend_name(b) << " Q15 radix-4 differs at N=" << n << "\n";
+                ok = false;
+            }
+        }
+        for (size_t stride : {size_t(1), size_t(3)}) {
+            const size_t n = 37;
+            auto a = to_q15(make_input(n * stride, 11u, 0.99f));
+            auto w = to_q15(make_input(n, 13u, 0.99f));
+            std::vector<cq15> x(n), y(n);
+            scalar->cmul_q15(x.data(), a.data(), stride, w.data(), n);
+            k->cmul_q15(y.data(), a.data(), stride, w.data(), n);
+            if (x != y) {
+                std::cerr << cpu_backend_name(b) << " Q15 cmul differs, stride " << stride << "\n";
+                ok = false;
+            }
+        }
+    }
+
+    // The int16 detector finds the float detector's peak at the same power.
+    const size_t N = 256;
+    kissfft<float>::init(fplan, int(N), false);
+    kissfft<int16_t>::init(qplan, int(N), false);
+    kissfft<float> ffft(fplan);
+    kissfft<int16_t> qfft(qplan);
+    std::vector<std::complex<float>> fin(N), fout(N);
+    std::vector<cq15> qin(N);
+    LoRaDetector<float> fdet(N, fin.data(), fout.data(), ffft);
+    LoRaDetector<int16_t> qdet(N, qin.data(), nullptr, qfft);
+    const double pi = std::acos(-1.0);
+    for (float ampl : {0.9f, 0.02f}) {
+        auto noise = make_input(N, 17u, 0.05f * ampl);
+        for (size_t i = 0; i < N; ++i) {
+            const double ph = 2.0 * pi * 77.3 * double(i) / double(N);
+            fin[i] = ampl * std::complex<float>(float(std::cos(ph)), float(std::sin(ph))) + noise[i];
+        }
+        auto q = to_q15(fin);
+        for (size_t i = 0; i < N; ++i) qdet.feed(i, q[i]);
+        float fp, fa, ff, qp, qa, qf;
+        const size_t fi = fdet.detect(fp, fa, ff);
+        const size_t qi = qdet.detect(qp, qa, qf);
+        if (fi != qi || std::abs(fp - qp) > 0.1f || std::abs(ff - qf) > 0.01f) {
+            std::cerr << "Q15 detect " << qi << " " << qp << " dB, float " << fi << " "
+                      << fp << " dB\n";
+            ok = false;
+        }
+    }
+
+    // lora_demodulate_sc16 on an int16 dechirped capture; the float reference
+    // demodulates the same quantised samples.
+    const unsigned sf = 9;
+    const size_t M = size_t(1) << sf;
+    const size_t n_syms = 12;
+    std::vector<uint16_t> tx(n_syms);
+    for (size_t i = 0; i < n_syms; ++i) tx[i] = static_cast<uint16_t>((i * 97 + 5) % M);
+    for (unsigned osr : {1u, 2u}) {
+        std::vector<std::complex<float>> iq((n_syms + 2) * M * osr);
+        std::vector<uint16_t> syms(n_syms + 2);
+        syms[0] = 0x10 << (sf - 4);
+        syms[1] = 0x20 << (sf - 4);
+        for (size_t i = 0; i < n_syms; ++i) syms[i + 2] = tx[i];
+        for (size_t s = 0; s < syms.size(); ++s)
+            for (size_t i = 0; i < M * osr; ++i) {
+                const double ph = 2.0 * pi * (syms[s] + 0.2) * double(s * M * osr + i) /
+                                  double(M * osr);
+                iq[s * M * osr + i] = 0.9f * std::complex<float>(float(std::cos(ph)),
+                                                                 float(std::sin(ph)));
+            }
+        const auto iq16 = to_q15(iq);
+        iq = from_q15(iq16);
+        static lora_demod_workspace ws{};
+        lora_demod_init(&ws, sf, window_type::window_hann);
+        std::vector<uint16_t> want(n_syms), got(n_syms);
+        uint8_t sync_want = 0, sync_got = 0;
+        const ssize_t nw = lora_demodulate(&ws, iq.data(), iq.size(), want.data(), osr, &sync_want);
+        const float cfo = ws.metrics.cfo;
+        const ssize_t ng = lora_demodulate_sc16(&ws, iq16.data(), iq16.size(), got.data(), osr,
+                                                &sync_got);
+        if (nw != ssize_t(n_syms) || ng != nw || got != want || sync_got != sync_want ||
+            std::abs(ws.metrics.cfo - cfo) > 1e-6f) {
+            std::cerr << "lora_demodulate_sc16 disagrees with lora_demodulate at osr " << osr
+                      << "\n";
+            ok = false;
+        }
+        lora_demod_free(&ws);
+    }
+
+    return ok ? 0 : 1;
+}
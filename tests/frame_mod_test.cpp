@@ -0,0 +1,139 @@
+#include <lora_phy/ChirpGenerator.hpp>
+#include <lora_phy/phy.hpp>
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <complex>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+// A frame is preamble upchirps, the sync word, a downchirp SFD and the
+// payload, each section the right chirp up to a constant phase.  The cached
+// header must give the same samples as synthesising it per packet.
+
+using namespace lora_phy;
+
+// Largest deviation of x[i] * conj(ref[i]) from its first value, i.e. of x
+// from ref times a constant phasor.
+static float chirp_deviation(const std::complex<float>* x, const std::complex<float>* ref,
+                             size_t n) {
+    const std::complex<float> c = x[0] * std::conj(ref[0]);
+    float dev = 0.0f;
+    for (size_t i = 0; i < n; ++i) dev = std::max(dev, std::abs(x[i] * std::conj(ref[i]) - c));
+    return dev;
+}
+
+int main() {
+    bool ok = true;
+    const unsigned sf = 8, osr = 2;
+    const size_t N = size_t(1) << sf;
+    const size_t step = N * osr;
+    const bandwidth bw = bandwidth::bw_250;
+    std::vector<uint16_t> symbols = {0, 17, 200, 255, 128};
+
+    // Reference chirps from the plain modulator: its first two symbols are
+    // the sync word, the rest are payload.
+    std::vector<std::complex<float>> plain((symbols.size() + 2) * step);
+    lora_modulate(symbols.data(), symbols.size(), plain.data(), sf, osr, bw, 1.0f, 0x34);
+    std::vector<std::complex<float>> zero(step), down(9 * step / 4);
+    float ph = 0.0f;
+    genChirp(zero.data(), int(N), int(osr), int(step), 0.0f, false, 1.0f, ph, bw_scale(bw));
+    ph = 0.0f;
+    genChirp(down.data(), int(N), int(osr), int(down.size()), 0.0f, true, 1.0f, ph,
+             bw_scale(bw));
+
+    for (unsigned preamble : {8u, 12u}) {
+        const unsigned sfd_quarters = 9;
+        const size_t hdr = lora_frame_header_len(sf, osr, preamble, sfd_quarters);
+        if (hdr != (preamble + 2) * step + 9 * step / 4) {
+            std::cerr << "frame header length " << hdr << "\n";
+            ok = false;
+        }
+        std::vector<std::complex<float>> frame(hdr + symbols.size() * step);
+        if (lora_modulate_frame(symbols.data(), symbols.size(), frame.data(), sf, osr, bw,
+                                preamble, sfd_quarters, 1.0f, 0x34) != frame.size()) {
+            std::cerr << "lora_modulate_frame size\n";
+            ok = false;
+            continue;
+        }
+        float dev = 0.0f;
+        for (unsigned p = 0; p < preamble; ++p)
+            dev = std::max(dev, chirp_deviation(&frame[p * step], zero.data(), step));
+        for (size_t s = 0; s < 2; ++s)
+            dev = std::max(dev, chirp_deviation(&frame[(preamble + s) * step], &plain[s * step],
+                                                step));
+        const std::complex<float>* sfd = &frame[(preamble + 2) * step];
+        dev = std::max(dev, chirp_deviation(sfd, down.data(), down.size()));
+        for (size_t s = 0; s < symbols.size(); ++s)
+            dev = std::max(dev, chirp_deviation(&frame[hdr + s * step], &plain[(s + 2) * step],
+                                                step));
+        if (dev > 2e-3f) {
+            std::cerr << "frame sections deviate by " << dev << " with preamble " << preamble
+                      << "\n";
+            ok = false;
+        }
+        // No phase jump into the payload: the step across the SFD/payload
+        // boundary is a normal chirp step.
+        const std::complex<float> a = frame[hdr - 1], b = frame[hdr];
+        if (std::abs(std::arg(b * std::conj(a))) > 2.0f * PI / float(osr)) {
+            std::cerr << "phase jump between SFD and payload\n";
+            ok = false;
+        }
+    }
+
+    // High level API, with and without the header cache.
+    std::vector<std::complex<float>> ws_in(N), ws_out(N), hdr_buf(16 * step);
+    lora_params cfg{};
+    cfg.sf = sf;
+    cfg.osr = osr;
+    cfg.bw = bw;
+    cfg.sync_word = 0x34;
+    cfg.preamble_len = 10;
+    cfg.sfd_quarters = 9;
+    const size_t hdr = lora_frame_header_len(sf, osr, 10, 9);
+    std::vector<std::complex<float>> want(hdr + symbols.size() * step), got(want.size());
+    // init() binds the kernels of cfg.backend, which the workspace
+    // evaluates its chirps with.
+    lora_modulate_frame(symbols.data(), symbols.size(), want.data(), sf, osr, bw, 10, 9, 1.0f,
+                        0x34, get_dsp_kernels(cfg.backend));
+    for (bool cached : {false, true}) {
+        lora_workspace ws{};
+        ws.fft_in = ws_in.data();
+        ws.fft_out = ws_out.data();
+        if (cached) {
+            ws.frame_buf = hdr_buf.data();
+            ws.frame_buf_len = hdr_buf.size();
+        }
+        if (init(&ws, &cfg) != 0 || ws.frame_header_len != (cached ? hdr : 0)) {
+            std::cerr << "init with frame cache " << cached << " failed\n";
+            ok = false;
+            continue;
+        }
+        for (int rep = 0; rep < 2; ++rep) {
+            std::fill(got.begin(), got.end(), std::complex<float>());
+            if (modulate_frame(&ws, symbols.data(), symbols.size(), got.data(), got.size()) !=
+                    ssize_t(want.size()) ||
+                got != want) {
+                std::cerr << "modulate_frame differs, cached " << cached << "\n";
+                ok = false;
+            }
+        }
+        if (modulate_frame(&ws, symbols.data(), symbols.size(), got.data(), got.size() - 1) !=
+            -ERANGE) {
+            std::cerr << "short frame buffer accepted\n";
+            ok = false;
+        }
+    }
+    lora_workspace small{};
+    small.fft_in = ws_in.data();
+    small.fft_out = ws_out.data();
+    small.frame_buf = hdr_buf.data();
+    small.frame_buf_len = hdr - 1;
+    if (init(&small, &cfg) != -ERANGE) {
+        std::cerr << "short frame cache accepted\n";
+        ok = false;
+    }
+
+    return ok ? 0 : 1;
+}
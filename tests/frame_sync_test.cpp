@@ -0,0 +1,234 @@
+#include <lora_phy/phy.hpp>
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <complex>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+#include "signal_utils.hpp"
+
+// lora_frame_sync must find every modulate_frame() frame in a continuous
+// capture of silence, noise and frames at arbitrary sample offsets and
+// carrier offsets, decide their payloads exactly, report the same frames
+// whatever the chunk sizes, and find nothing in noise alone.
+//
+// Above OSR 1 the frames are not taken from modulate_frame() at that rate:
+// its oversampled chirp, decimated, sweeps about a bin below the base rate
+// chirp (1.125 bins at OSR 4), which would blur a chip of timing into every
+// symbol.  They are the OSR 1 frame with its phase interpolated linearly
+// between base rate samples, so decimating at offset 0 returns it exactly.
+
+using namespace lora_phy;
+
+// Raise @p base to @p osr samples per chip.  Each base sample step turns by
+// its own phase increment in osr equal parts.
+static std::vector<std::complex<float>> upsample(const std::vector<std::complex<float>>& base,
+                                                 unsigned osr) {
+    std::vector<std::complex<float>> out(base.size() * osr);
+    for (size_t k = 0; k < base.size(); ++k) {
+        const std::complex<float> next = k + 1 < base.size() ? base[k + 1] : base[k];
+        const float turn = std::arg(next * std::conj(base[k]));
+        for (unsigned m = 0; m < osr; ++m)
+            out[k * osr + m] = base[k] * std::polar(1.0f, turn * float(m) / float(osr));
+    }
+    return out;
+}
+
+struct config {
+    unsigned sf, osr;
+    window_type window;
+    bool table;
+    bool in_place;
+};
+
+struct sent {
+    size_t sync_start; ///< first sync word sample in the capture
+    float cfo;         ///< bins
+    std::vector<uint16_t> symbols;
+};
+
+static bool check(const config& c) {
+    bool ok = true;
+    const size_t N = size_t(1) << c.sf;
+    const size_t step = N * c.osr;
+    const size_t payload_len = 10;
+    lora_params cfg{};
+    cfg.sf = c.sf;
+    cfg.osr = c.osr;
+    cfg.bw = bandwidth::bw_125;
+    cfg.window = c.window;
+
+    std::vector<std::complex<float>> fft_in(N), fft_out(N), dechirp(N);
+    std::vector<float> window(N);
+    lora_workspace ws{};
+    ws.fft_in = fft_in.data();
+    if (!c.in_place) ws.fft_out = fft_out.data();
+    ws.window = window.data();
+    if (c.table) ws.dechirp = dechirp.data();
+    if (init(&ws, &cfg) != 0) {
+        std::cerr << "init failed\n";
+        return false;
+    }
+    // Base rate transmitter for the test frames.
+    lora_params tx_cfg = cfg;
+    tx_cfg.osr = 1;
+    tx_cfg.window = window_type::window_none;
+    std::vector<std::complex<float>> tx_fft(N);
+    lora_workspace tx_ws{};
+    tx_ws.fft_in = tx_fft.data();
+    if (init(&tx_ws, &tx_cfg) != 0) {
+        std::cerr << "tx init failed\n";
+        return false;
+    }
+
+    // Silence, then noise throughout, with three frames placed off the
+    // symbol and sample grids.
+    const size_t hdr = lora_frame_header_len(c.sf, c.osr, cfg.preamble_len, cfg.sfd_quarters);
+    const size_t frame_len = hdr + payload_len * step;
+    const size_t quiet = 1000;
+    const float cfos[] = {2.3f, -9.6f, 0.4f};
+    const size_t gaps[] = {quiet + 3 * step + 7, 10 * step + step / 3, 5 * step + 1};
+    std::vector<sent> tx;
+    size_t at = 0;
+    for (size_t f = 0; f < 3; ++f) {
+        at += gaps[f];
+        sent s{at + (hdr - step * cfg.sfd_quarters / 4 - 2 * step), cfos[f], {}};
+        for (size_t i = 0; i < payload_len; ++i)
+            s.symbols.push_back(static_cast<uint16_t>((i * 211 + 31 * f + 5) % N));
+        tx.push_back(s);
+        at += frame_len;
+    }
+    const size_t total = at + 7 * step + 3;
+    std::vector<std::complex<float>> iq(total), frame(frame_len / c.osr);
+    uint32_t lcg = 4242;
+    for (size_t i = quiet; i < total; ++i) {
+        const float a = uniform(lcg) * 0.3f;
+        const float b = uniform(lcg) * 0.3f;
+        iq[i] = std::complex<float>(a, b);
+    }
+    at = 0;
+    for (size_t f = 0; f < 3; ++f) {
+        at += gaps[f];
+        if (modulate_frame(&tx_ws, tx[f].symbols.data(), payload_len, frame.data(),
+                           frame.size()) != ssize_t(frame.size())) {
+            std::cerr << "modulate_frame failed\n";
+            return false;
+        }
+        const std::vector<std::complex<float>> rx = upsample(frame, c.osr);
+        for (size_t i = 0; i < frame_len; ++i)
+            iq[at + i] += rx[i] * std::polar(1.0f, float(2.0 * PI_D * double(cfos[f]) *
+                                                         double(i) / double(step)));
+        at += frame_len;
+    }
+
+    std::vector<std::complex<float>> history(lora_frame_sync_buffer_len(&ws));
+    std::vector<uint16_t> payload(payload_len);
+    std::vector<lora_rx_frame> first;
+    std::vector<uint16_t> first_symbols;
+    for (size_t chunk : {size_t(1), size_t(333), step - 1, total}) {
+        lora_frame_sync fs;
+        if (lora_frame_sync_init(&fs, &ws, history.data(), history.size(), payload.data(),
+                                 payload_len) != 0) {
+            std::cerr << "lora_frame_sync_init failed\n";
+            return false;
+        }
+        std::vector<lora_rx_frame> got;
+        std::vector<uint16_t> got_symbols;
+        const size_t cap = chunk / ((payload_len + 1) * step) + 1;
+        std::vector<lora_rx_frame> frames(cap);
+        std::vector<uint16_t> symbols(cap * payload_len);
+        for (size_t i = 0; i < total; i += chunk) {
+            const ssize_t n = lora_frame_sync_push(&fs, iq.data() + i, std::min(chunk, total - i),
+                                                   frames.data(), frames.size(), symbols.data());
+            if (n < 0) {
+                std::cerr << "lora_frame_sync_push failed: " << n << "\n";
+                return false;
+            }
+            for (ssize_t f = 0; f < n; ++f) {
+                got.push_back(frames[f]);
+                got_symbols.insert(got_symbols.end(), frames[f].symbols,
+                                   frames[f].symbols + payload_len);
+            }
+        }
+
+        // Payloads must be exact and the frame found within half a sample.
+        bool match = got.size() == tx.size();
+        for (size_t f = 0; match && f < tx.size(); ++f) {
+            size_t wrong = 0;
+            for (size_t i = 0; i < payload_len; ++i)
+                wrong += got_symbols[f * payload_len + i] != tx[f].symbols[i];
+            const double lag = double(got[f].start) + double(got[f].time_offset) -
+                               double(tx[f].sync_start);
+            match = wrong == 0 && std::abs(got[f].cfo - tx[f].cfo) < 0.15f &&
+                    std::abs(lag) < 0.5 && got[f].sync_word == 0x12 &&
+                    got[f].confirmed > got[f].start &&
+                    got[f].confirmed - got[f].start <= 4 * step;
+            if (!match)
+                std::cerr << "frame " << f << ": lag " << lag << ", cfo " << got[f].cfo
+                          << " want " << tx[f].cfo << ", " << wrong << " symbols wrong\n";
+        }
+        const lora_sync_stats& s = fs.stats;
+        if (!match || s.samples != total || s.frames != tx.size() ||
+            s.detections != s.frames + s.false_alarms || s.latency_max > 4 * step ||
+            s.latency_sum > s.frames * s.latency_max) {
+            std::cerr << "frame sync sf " << c.sf << " osr " << c.osr << " chunk " << chunk
+                      << ": " << got.size() << " frames, " << s.detections << " detections, "
+                      << s.false_alarms << " false alarms\n";
+            ok = false;
+        }
+        if (first.empty()) {
+            first = got;
+            first_symbols = got_symbols;
+        } else {
+            bool same = got.size() == first.size() && got_symbols == first_symbols;
+            for (size_t f = 0; same && f < got.size(); ++f)
+                same = got[f].start == first[f].start && got[f].cfo == first[f].cfo &&
+                       got[f].time_offset == first[f].time_offset;
+            if (!same) {
+                std::cerr << "frame sync chunk " << chunk << " differs from chunk 1\n";
+                ok = false;
+            }
+        }
+    }
+
+    // Noise alone holds no frame.
+    lora_frame_sync fs;
+    lora_frame_sync_init(&fs, &ws, history.data(), history.size(), payload.data(), payload_len);
+    std::vector<lora_rx_frame> frames(2);
+    std::vector<uint16_t> symbols(2 * payload_len);
+    std::vector<std::complex<float>> noise(8 * step);
+    for (size_t r = 0; r < 100; ++r) {
+        for (auto& x : noise) {
+            const float a = uniform(lcg) * 0.3f;
+            x = std::complex<float>(a, uniform(lcg) * 0.3f);
+        }
+        lora_frame_sync_push(&fs, noise.data(), noise.size(), frames.data(), frames.size(),
+                             symbols.data());
+    }
+    if (fs.stats.frames != 0 || fs.stats.windows < 790) {
+        std::cerr << "noise: " << fs.stats.frames << " frames, " << fs.stats.detections
+                  << " detections in " << fs.stats.windows << " windows\n";
+        ok = false;
+    }
+
+    if (lora_frame_sync_init(&fs, &ws, history.data(), history.size() - 1, payload.data(),
+                             payload_len) != -ERANGE ||
+        lora_frame_sync_init(&fs, &ws, history.data(), history.size(), payload.data(), 0) !=
+            -EINVAL ||
+        lora_frame_sync_push(&fs, iq.data(), (payload_len + 1) * step, frames.data(), 1,
+                             symbols.data()) != -ERANGE) {
+        std::cerr << "frame sync accepted bad sizes\n";
+        ok = false;
+    }
+    return ok;
+}
+
+int main() {
+    bool ok = true;
+    for (const config& c : {config{7, 4, window_type::window_none, true, false},
+                            config{8, 2, window_type::window_hann, false, true},
+                            config{9, 1, window_type::window_none, true, false}})
+        ok = check(c) && ok;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,92 @@
+#include <lora_phy/phy.hpp>
+#include <chrono>
+#include <cmath>
+#include <complex>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "signal_utils.hpp"
+#ifdef __x86_64__
+#include <x86intrin.h>
+#endif
+
+// Throughput of soft-decision output: lora_demodulate with and without
+// per-bit LLRs on the same capture, and the softBits pass alone.  Cycles
+// per payload symbol are written to logs/llr_perf_<RUN_ID>.csv.
+
+using namespace lora_phy;
+
+static unsigned long long ticks() {
+#ifdef __x86_64__
+    return __rdtsc();
+#else
+    return static_cast<unsigned long long>(
+        std::chrono::high_resolution_clock::now().time_since_epoch().count());
+#endif
+}
+
+int main() {
+    const char* env_run = std::getenv("RUN_ID");
+    std::string run_id = env_run ? env_run : "run";
+    std::string path = "logs/llr_perf_" + run_id + ".csv";
+
+    std::system("mkdir -p logs");
+    std::ofstream csv(path);
+    csv << "run_id,sf,hard_cycles_per_symbol,soft_cycles_per_symbol,llr_cycles_per_symbol\n";
+
+    bool ok = true;
+    for (unsigned sf : {7u, 9u, 11u, 12u}) {
+        const size_t M = size_t(1) << sf;
+        const size_t n_syms = 32;
+        const size_t reps = std::max<size_t>(1, (size_t(1) << 20) / (M * n_syms));
+        std::vector<std::complex<float>> iq((n_syms + 2) * M);
+        uint32_t seed = sf;
+        for (size_t s = 0; s < n_syms + 2; ++s) {
+            const uint32_t r = lcg_next(seed);
+            const size_t bin = s < 2 ? 0 : (r >> 8) % M;
+            add_tone(iq.data() + s * M, M, M, double(bin), 0.5f);
+        }
+        static lora_demod_workspace ws{};
+        lora_demod_init(&ws, sf);
+        std::vector<uint16_t> hard(n_syms), soft(n_syms);
+        std::vector<float> llrs(n_syms * sf);
+
+        unsigned long long t0 = ticks();
+        for (size_t r = 0; r < reps; ++r)
+            lora_demodulate(&ws, iq.data(), iq.size(), hard.data(), 1);
+        unsigned long long t1 = ticks();
+        const double hard_cycles = double(t1 - t0) / double(reps * n_syms);
+
+        t0 = ticks();
+        for (size_t r = 0; r < reps; ++r)
+            lora_demodulate(&ws, iq.data(), iq.size(), soft.data(), 1, nullptr, nullptr, 0,
+                            llrs.data());
+        t1 = ticks();
+        const double soft_cycles = double(t1 - t0) / double(reps * n_syms);
+
+        // softBits alone on the last spectrum left in fft_out.
+        const size_t llr_reps = reps * n_syms;
+        t0 = ticks();
+        for (size_t r = 0; r < llr_reps; ++r)
+            ws.detector->softBits(ws.fft_out, 1, llrs.data());
+        t1 = ticks();
+        const double llr_cycles = double(t1 - t0) / double(llr_reps);
+
+        if (soft != hard) {
+            std::cerr << "soft and hard demodulation disagree at sf " << sf << "\n";
+            ok = false;
+        }
+        lora_demod_free(&ws);
+
+        csv << run_id << ',' << sf << ',' << hard_cycles << ',' << soft_cycles << ','
+            << llr_cycles << '\n';
+        std::cout << '[' << run_id << "] llr sf=" << sf << ": " << hard_cycles
+                  << " cycles/symbol hard, " << soft_cycles << " with LLRs, " << llr_cycles
+                  << " softBits" << std::endl;
+    }
+
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,161 @@
+#include <lora_phy/LoRaDetector.hpp>
+#include <lora_phy/phy.hpp>
+#include <cmath>
+#include <complex>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+#include "signal_utils.hpp"
+
+// The detector metrics level only trims what is reported beside the argmax:
+// decisions must not change, peak must match full on power and fIndex, and
+// the demodulators must average exactly the metrics the level asks for.
+
+using namespace lora_phy;
+
+static std::vector<std::complex<float>> make_symbol(size_t N, double bin, uint32_t seed) {
+    std::vector<std::complex<float>> v(N);
+    add_tone(v.data(), N, N, bin, 0.5f);
+    for (auto& x : v) {
+        const float n = uniform(seed);
+        x += std::complex<float>(0.05f * n, -0.03f * n);
+    }
+    return v;
+}
+
+int main() {
+    bool ok = true;
+    const size_t N = 256;
+    detector_fixture fx(N);
+    LoRaDetector<float>& detector = fx.detector;
+    std::vector<std::complex<float>>& in = fx.in;
+    if (detector.metrics() != DetectorMetrics::full) {
+        std::cerr << "detector does not default to full metrics\n";
+        ok = false;
+    }
+
+    const auto sym = make_symbol(N, 93.3, 5u);
+    float fp, fa, ff;
+    in = sym;
+    const size_t fidx = detector.detect(fp, fa, ff);
+    for (DetectorMetrics level : {DetectorMetrics::none, DetectorMetrics::peak}) {
+        detector.setMetrics(level);
+        in = sym;
+        float p = -1.0f, pav = -1.0f, fi = -1.0f;
+        const size_t idx = detector.detect(p, pav, fi);
+        const bool peak = level == DetectorMetrics::peak;
+        if (idx != fidx || pav != 0.0f || p != (peak ? fp : 0.0f) || fi != (peak ? ff : 0.0f)) {
+            std::cerr << "detect at level " << int(level) << " reported " << idx << " " << p
+                      << " " << pav << " " << fi << "\n";
+            ok = false;
+        }
+    }
+
+    // Batched detection honours the level as well.
+    const size_t count = 4;
+    std::vector<std::complex<float>> batch(N * count), spectra(N * count);
+    for (size_t b = 0; b < count; ++b) {
+        const auto x = make_symbol(N, 10.0 + 50.0 * b, uint32_t(b + 1));
+        for (size_t i = 0; i < N; ++i) batch[i * count + b] = x[i];
+    }
+    size_t full_idx[count], idx[count];
+    float full_p[count], full_a[count], full_f[count], p[count], a[count], f[count];
+    detector.setMetrics(DetectorMetrics::full);
+    detector.detectBatch(batch.data(), spectra.data(), count, full_idx, full_p, full_a, full_f);
+    detector.setMetrics(DetectorMetrics::peak);
+    detector.detectBatch(batch.data(), spectra.data(), count, idx, p, a, f);
+    for (size_t b = 0; b < count; ++b)
+        if (idx[b] != full_idx[b] || p[b] != full_p[b] || f[b] != full_f[b] || a[b] != 0.0f) {
+            std::cerr << "peak-level detectBatch differs for symbol " << b << "\n";
+            ok = false;
+        }
+
+    // lora_demodulate and lora_demodulate_sc16 at every level.
+    const unsigned sf = 8;
+    const size_t M = size_t(1) << sf;
+    const size_t n_syms = 12;
+    std::vector<std::complex<float>> iq((n_syms + 2) * M);
+    std::vector<std::complex<int16_t>> iq16(iq.size());
+    for (size_t s = 0; s < n_syms + 2; ++s) {
+        const auto x = make_symbol(M, s < 2 ? 0.0 : double((s * 53 + 7) % M), uint32_t(s + 9));
+        for (size_t i = 0; i < M; ++i) iq[s * M + i] = x[i];
+    }
+    for (size_t i = 0; i < iq.size(); ++i)
+        iq16[i] = std::complex<int16_t>(kissfft_utils::q15_unit(iq[i].real()),
+                                        kissfft_utils::q15_unit(iq[i].imag()));
+    std::vector<uint16_t> ref(n_syms);
+    float ref_peak = 0.0f, ref_noise = 0.0f;
+    for (metrics_level level : {metrics_level::full, metrics_level::peak, metrics_level::none}) {
+        static lora_demod_workspace ws{};
+        lora_demod_init(&ws, sf, window_type::window_none, nullptr, 0, cpu_backend::automatic,
+                        fft_planning::estimate, level);
+        std::vector<uint16_t> got(n_syms), got16(n_syms);
+        const ssize_t n = lora_demodulate(&ws, iq.data(), iq.size(), got.data(), 1);
+        const lora_metrics m = ws.metrics;
+        const ssize_t n16 = lora_demodulate_sc16(&ws, iq16.data(), iq16.size(), got16.data(), 1);
+        if (level == metrics_level::full) {
+            ref = got;
+            ref_peak = m.peak_power;
+            ref_noise = m.noise_power;
+            if (!(ref_peak > ref_noise + 10.0f)) {
+                std::cerr << "full metrics: peak " << ref_peak << " dB, noise " << ref_noise
+                          << " dB\n";
+                ok = false;
+            }
+        }
+        const float want_peak = level == metrics_level::none ? 0.0f : ref_peak;
+        const float want_noise = level == metrics_level::full ? ref_noise : 0.0f;
+        if (n != ssize_t(n_syms) || got != ref || m.peak_power != want_peak ||
+            m.noise_power != want_noise) {
+            std::cerr << "lora_demodulate at level " << int(level) << ": peak " << m.peak_power
+                      << " noise " << m.noise_power << "\n";
+            ok = false;
+        }
+        if (n16 != n || got16 != ref || std::abs(ws.metrics.peak_power - want_peak) > 0.1f ||
+            std::abs(ws.metrics.noise_power - want_noise) > 0.5f) {
+            std::cerr << "lora_demodulate_sc16 at level " << int(level) << ": peak "
+                      << ws.metrics.peak_power << " noise " << ws.metrics.noise_power << "\n";
+            ok = false;
+        }
+        lora_demod_free(&ws);
+    }
+
+    // High level API, batched and not: same decisions at every level.
+    std::vector<std::complex<float>> ws_in(M), ws_out(M), batch_buf(M * 4);
+    for (bool batched : {false, true}) {
+        std::vector<uint16_t> first;
+        for (metrics_level level : {metrics_level::none, metrics_level::full}) {
+            lora_workspace ws{};
+            ws.fft_in = ws_in.data();
+            ws.fft_out = ws_out.data();
+            if (batched) {
+                ws.batch_in = batch_buf.data();
+                ws.batch_len = batch_buf.size();
+            }
+            lora_params cfg{};
+            cfg.sf = sf;
+            cfg.symbol_metrics = level;
+            std::vector<uint16_t> tx(n_syms), rx(n_syms);
+            for (size_t i = 0; i < n_syms; ++i) tx[i] = static_cast<uint16_t>((i * 29 + 4) % M);
+            std::vector<std::complex<float>> sig((n_syms + 2) * M);
+            if (init(&ws, &cfg) != 0 ||
+                modulate(&ws, tx.data(), n_syms, sig.data(), sig.size()) != ssize_t(sig.size()) ||
+                demodulate(&ws, sig.data(), sig.size(), rx.data(), rx.size()) != ssize_t(n_syms)) {
+                std::cerr << "high level round trip failed\n";
+                ok = false;
+                continue;
+            }
+            const bool full = level == metrics_level::full;
+            if (first.empty()) first = rx;
+            if (rx != first || (full ? !(ws.metrics.peak_power > ws.metrics.noise_power)
+                                  : ws.metrics.peak_power != 0.0f)) {
+                std::cerr << "demodulate at level " << int(level) << (batched ? " batched" : "")
+                          << ": peak " << ws.metrics.peak_power << " noise "
+                          << ws.metrics.noise_power << "\n";
+                ok = false;
+            }
+        }
+    }
+
+    return ok ? 0 : 1;
+}
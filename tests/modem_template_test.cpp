@@ -0,0 +1,126 @@
+#include <lora_phy/modem.hpp>
+#include <lora_phy/phy.hpp>
+#include <cerrno>
+#include <cmath>
+#include <complex>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+#include "signal_utils.hpp"
+
+// Every specialisation reached through find_modem() must modulate and decide
+// exactly as the generic API does on the same configuration, and find it
+// for exactly the compiled (sf, osr) pairs.
+
+using namespace lora_phy;
+
+struct config {
+    unsigned sf, osr;
+    bandwidth bw;
+    window_type window;
+};
+
+static bool check(const config& c) {
+    bool ok = true;
+    const size_t N = size_t(1) << c.sf;
+    const size_t step = N * c.osr;
+    lora_params cfg{};
+    cfg.sf = c.sf;
+    cfg.osr = c.osr;
+    cfg.bw = c.bw;
+    cfg.window = c.window;
+    cfg.sync_word = 0x34;
+
+    std::vector<std::complex<float>> fft_in(N), fft_out(N), chirp(step), dechirp(N);
+    std::vector<float> window(N);
+    lora_workspace ws{};
+    ws.fft_in = fft_in.data();
+    ws.fft_out = fft_out.data();
+    ws.window = window.data();
+    ws.chirp_buf = chirp.data();
+    ws.dechirp = dechirp.data();
+    if (init(&ws, &cfg) != 0) {
+        std::cerr << "generic init failed at sf " << c.sf << "\n";
+        return false;
+    }
+
+    const modem_ops* ops = find_modem(&cfg);
+    if (!ops || ops->sf != c.sf || ops->osr != c.osr) {
+        std::cerr << "no specialisation for sf " << c.sf << " osr " << c.osr << "\n";
+        return false;
+    }
+    std::vector<std::max_align_t> storage(ops->size / sizeof(std::max_align_t) + 1);
+    void* m = storage.data();
+    if (ops->align > alignof(std::max_align_t) || ops->init(m, &cfg) != 0) {
+        std::cerr << "modem init failed at sf " << c.sf << "\n";
+        return false;
+    }
+
+    std::vector<uint16_t> symbols(12);
+    for (size_t i = 0; i < symbols.size(); ++i)
+        symbols[i] = static_cast<uint16_t>((i * 389 + 7) % N);
+    const size_t len = (symbols.size() + 2) * step;
+    std::vector<std::complex<float>> want(len), got(len);
+    if (modulate(&ws, symbols.data(), symbols.size(), want.data(), want.size()) !=
+            ssize_t(len) ||
+        ops->modulate(m, symbols.data(), symbols.size(), got.data(), got.size()) !=
+            ssize_t(len) ||
+        got != want) {
+        std::cerr << "specialised modulate differs at sf " << c.sf << " osr " << c.osr << "\n";
+        ok = false;
+    }
+
+    // A CFO and some noise so both paths estimate and derotate.
+    uint32_t lcg = 12345;
+    auto noise = [&]() { return uniform(lcg) * 0.2f; };
+    for (size_t i = 0; i < len; ++i)
+        want[i] = want[i] * std::polar(1.0f, float(0.9 * 2.0 * PI_D * double(i % (4 * step)) /
+                                                   double(step))) +
+                  std::complex<float>(noise(), noise());
+    std::vector<uint16_t> generic(symbols.size()), special(symbols.size());
+    const ssize_t n_generic =
+        demodulate(&ws, want.data(), want.size(), generic.data(), generic.size());
+    const ssize_t n_special =
+        ops->demodulate(m, want.data(), want.size(), special.data(), special.size());
+    const lora_metrics* mm = ops->metrics(m);
+    if (n_generic != ssize_t(symbols.size()) || n_special != n_generic || special != generic ||
+        mm->cfo != ws.metrics.cfo || mm->time_offset != ws.metrics.time_offset ||
+        ops->workspace(m)->sync_word != ws.sync_word) {
+        std::cerr << "specialised demodulate differs at sf " << c.sf << " osr " << c.osr << "\n";
+        ok = false;
+    }
+    if (ops->demodulate(m, want.data(), want.size(), special.data(), special.size() - 1) !=
+            -ERANGE ||
+        ops->demodulate(m, want.data(), want.size() - 1, special.data(), special.size()) !=
+            -EINVAL) {
+        std::cerr << "specialised demodulate accepted bad sizes\n";
+        ok = false;
+    }
+    return ok;
+}
+
+int main() {
+    bool ok = true;
+    for (const config& c : {config{7, 1, bandwidth::bw_125, window_type::window_none},
+                            config{8, 2, bandwidth::bw_250, window_type::window_hann},
+                            config{10, 4, bandwidth::bw_125, window_type::window_none},
+                            config{12, 8, bandwidth::bw_500, window_type::window_none}})
+        ok = check(c) && ok;
+
+    lora_params cfg{};
+    cfg.sf = 13;
+    const modem_ops* none13 = find_modem(&cfg);
+    cfg.sf = 9;
+    cfg.osr = 3;
+    const modem_ops* none3 = find_modem(&cfg);
+    cfg.osr = 0;
+    const modem_ops* osr1 = find_modem(&cfg);
+    modem<9, 2> wrong;
+    if (none13 || none3 || !osr1 || osr1->osr != 1 || wrong.init(&cfg) != -EINVAL) {
+        std::cerr << "find_modem() dispatch wrong\n";
+        ok = false;
+    }
+
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,257 @@
+#include <lora_phy/LoRaDetector.hpp>
+#include <lora_phy/ChirpGenerator.hpp>
+#include <lora_phy/nco.hpp>
+#include <lora_phy/phy.hpp>
+#include <cmath>
+#include <complex>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <vector>
+
+// The NCO must stay within its documented 3e-7 of the exact phasor on every
+// backend however long it runs and however the output is chunked, the
+// polar kernel within 1e-6 over |phase| < 32768, and offset compensation
+// built on the NCO must undo a known CFO on the golden detection captures
+// without changing a single decision.
+
+using namespace lora_phy;
+
+struct detection_vector {
+    unsigned sf;
+    std::vector<uint32_t> symbols;
+    std::vector<std::complex<double>> samples;
+};
+
+template <typename T>
+static bool get(const std::vector<char>& buf, size_t& pos, T& v) {
+    if (pos + sizeof(T) > buf.size()) return false;
+    std::memcpy(&v, buf.data() + pos, sizeof(T));
+    pos += sizeof(T);
+    return true;
+}
+
+// detection_tests.bin: u32 count, then per test u8 flag, u32 sf, u32 bw
+// (kHz), u32 osr, u32 symbol count, the symbols, u32 sample count and the
+// samples as complex doubles.
+static std::vector<detection_vector> load_detection_vectors(const char* path) {
+    std::ifstream f(path, std::ios::binary);
+    std::vector<char> buf((std::istreambuf_iterator<char>(f)), std::istreambuf_iterator<char>());
+    std::vector<detection_vector> out;
+    size_t pos = 0;
+    uint32_t count = 0;
+    if (!get(buf, pos, count)) return out;
+    for (uint32_t t = 0; t < count; ++t) {
+        uint8_t flag;
+        uint32_t sf, bw, osr, ns, cnt;
+        detection_vector v;
+        if (!get(buf, pos, flag) || !get(buf, pos, sf) || !get(buf, pos, bw) ||
+            !get(buf, pos, osr) || !get(buf, pos, ns))
+            break;
+        v.sf = sf;
+        v.symbols.resize(ns);
+        for (auto& s : v.symbols)
+            if (!get(buf, pos, s)) return out;
+        if (!get(buf, pos, cnt)) break;
+        v.samples.resize(cnt);
+        for (auto& x : v.samples) {
+            double re, im;
+            if (!get(buf, pos, re) || !get(buf, pos, im)) return out;
+            x = std::complex<double>(re, im);
+        }
+        out.push_back(std::move(v));
+    }
+    return out;
+}
+
+static double max_error(const std::vector<std::complex<float>>& got, double start, double rate) {
+    double err = 0.0;
+    for (size_t i = 0; i < got.size(); ++i) {
+        const double ph = start + rate * static_cast<double>(i);
+        err = std::max(err, std::abs(std::complex<double>(got[i]) - std::polar(1.0, ph)));
+    }
+    return err;
+}
+
+int main() {
+    bool ok = true;
+    const double pi = std::acos(-1.0);
+
+    for (cpu_backend b : {cpu_backend::scalar, cpu_backend::sse42, cpu_backend::avx2,
+                          cpu_backend::avx512}) {
+        const dsp_kernels* k = get_dsp_kernels(b);
+        if (!k) continue;
+
+        // A million samples in one call and in ragged chunks, no drift at the
+        // end of the run.  Chunks shorter than a vector take the kernels'
+        // scalar tails, so the two runs agree to rounding only.
+        for (double rate : {0.0, 1e-5, -0.0123, 0.7, -2.9}) {
+            const double start = 1000.25;
+            std::vector<std::complex<float>> one(size_t(1) << 20), chunked(one.size());
+            nco a(k, rate, start);
+            a.generate(one.data(), one.size());
+            nco c(k, rate, start);
+            for (size_t i = 0, n = 1; i < chunked.size(); i += n, n = n * 7 % 131 + 1)
+                c.generate(chunked.data() + i, std::min(n, chunked.size() - i));
+            const double err = max_error(one, start, rate);
+            double split = 0.0;
+            for (size_t i = 0; i < one.size(); ++i)
+                split = std::max(split, double(std::abs(one[i] - chunked[i])));
+            if (err > 3e-7 || split > 3e-7) {
+                std::cerr << cpu_backend_name(b) << " nco rate " << rate << ": error " << err
+                          << ", chunked output off by " << split << "\n";
+                ok = false;
+            }
+            const double want = start + rate * static_cast<double>(one.size());
+            if (std::abs(a.phase() - want) > 1e-9 * std::abs(want)) {
+                std::cerr << cpu_backend_name(b) << " nco phase " << a.phase() << " want "
+                          << want << "\n";
+                ok = false;
+            }
+        }
+
+        // mix() with a stride, in place and after a seek.
+        const size_t n = 300, stride = 3;
+        std::vector<std::complex<float>> src(n * stride), ph(n), got(n), want(n);
+        for (size_t i = 0; i < src.size(); ++i)
+            src[i] = std::complex<float>(float(i % 17) / 17.0f, -float(i % 5) / 5.0f);
+        nco m(k, 0.37);
+        m.generate(ph.data(), 10);
+        m.seek(-5.0);
+        m.mix(got.data(), src.data(), stride, n);
+        nco r(k, 0.37, -5.0);
+        r.generate(ph.data(), n);
+        for (size_t i = 0; i < n; ++i) want[i] = src[i * stride] * ph[i];
+        std::vector<std::complex<float>> inplace(src.begin(), src.begin() + n);
+        m.seek(-5.0);
+        m.mix(inplace.data(), inplace.data(), 1, n);
+        for (size_t i = 0; i < n; ++i) {
+            if (std::abs(got[i] - want[i]) > 1e-6f ||
+                std::abs(inplace[i] - src[i] * ph[i]) > 1e-6f) {
+                std::cerr << cpu_backend_name(b) << " nco mix differs at " << i << "\n";
+                ok = false;
+                break;
+            }
+        }
+
+        // dechirp() against the exact product, strided and in place over the
+        // reference, from a mid-block position.
+        std::vector<std::complex<float>> ref(n), fused(n);
+        for (size_t i = 0; i < n; ++i)
+            ref[i] = std::polar(0.5f + float(i % 7) / 14.0f, 0.01f * float(i * i % 613));
+        m.seek(-5.0);
+        m.generate(ph.data(), 10);
+        m.dechirp(fused.data(), src.data(), stride, ref.data(), n);
+        std::vector<std::complex<float>> alias(ref);
+        m.seek(-5.0 + 0.37 * 10.0);
+        m.dechirp(alias.data(), src.data(), stride, alias.data(), n);
+        for (size_t i = 0; i < n; ++i) {
+            const std::complex<double> exact =
+                std::complex<double>(src[i * stride]) * std::complex<double>(ref[i]) *
+                std::polar(1.0, -5.0 + 0.37 * double(i + 10));
+            if (std::abs(std::complex<double>(fused[i]) - exact) > 1e-6 ||
+                std::abs(alias[i] - fused[i]) > 1e-6f) {
+                std::cerr << cpu_backend_name(b) << " nco dechirp differs at " << i << "\n";
+                ok = false;
+                break;
+            }
+        }
+
+        // The polar kernel over the whole range genChirp feeds it.
+        std::vector<float> phase(4096);
+        std::vector<std::complex<float>> out(phase.size());
+        double perr = 0.0;
+        for (size_t i = 0; i < phase.size(); ++i)
+            phase[i] = 32767.0f * (2.0f * float(i * 2654435761u % 65536u) / 65536.0f - 1.0f);
+        k->polar(out.data(), phase.data(), 1.0f, phase.size());
+        for (size_t i = 0; i < phase.size(); ++i)
+            perr = std::max(perr, std::abs(std::complex<double>(out[i]) -
+                                           std::polar(1.0, double(phase[i]))));
+        if (perr > 1e-6) {
+            std::cerr << cpu_backend_name(b) << " polar error " << perr << "\n";
+            ok = false;
+        }
+    }
+
+    // genChirp without a kernel argument evaluates std::polar per sample,
+    // whatever the host runs: the same as a block kernel built on it.
+    {
+        auto std_polar = [](std::complex<float>* out, const float* phase, float ampl,
+                            size_t n) {
+            for (size_t i = 0; i < n; ++i) out[i] = std::polar(ampl, phase[i]);
+        };
+        std::vector<std::complex<float>> a(4096), b(4096);
+        float pa = 0.5f, pb = 0.5f;
+        genChirp(a.data(), 1024, 4, 4096, 0.3f, false, 1.0f, pa, 4.0f);
+        genChirp(b.data(), 1024, 4, 4096, 0.3f, false, 1.0f, pb, 4.0f, +std_polar);
+        if (a != b || pa != pb) {
+            std::cerr << "genChirp default path differs from std::polar\n";
+            ok = false;
+        }
+    }
+
+    // Golden detection captures: apply a CFO in double precision and let
+    // compensate_offsets() remove it again; every symbol must then decide
+    // as the untouched capture does.
+    const auto vectors = load_detection_vectors("vectors/golden/detection_tests.bin");
+    if (vectors.empty()) {
+        std::cerr << "no detection vectors\n";
+        return 1;
+    }
+    for (const auto& v : vectors) {
+        const size_t N = size_t(1) << v.sf;
+        std::vector<std::complex<float>> ws_in(N), ws_out(N);
+        lora_workspace ws{};
+        ws.fft_in = ws_in.data();
+        ws.fft_out = ws_out.data();
+        lora_params cfg{};
+        cfg.sf = v.sf;
+        if (init(&ws, &cfg) != 0) {
+            std::cerr << "init failed at sf " << v.sf << "\n";
+            ok = false;
+            continue;
+        }
+        kissfft<float> fft(*ws.plan_fwd);
+        LoRaDetector<float> detector(N, ws_in.data(), ws_out.data(), fft);
+        std::vector<size_t> decided;
+        for (size_t s = 0; (s + 1) * N <= v.samples.size(); ++s) {
+            for (size_t i = 0; i < N; ++i)
+                detector.feed(i, std::complex<float>(v.samples[s * N + i]));
+            float p, pav, fi;
+            decided.push_back(detector.detect(p, pav, fi));
+        }
+        for (double cfo : {0.31, -2.7, 17.5}) {
+            std::vector<std::complex<float>> x(v.samples.size());
+            double peak = 0.0;
+            for (size_t i = 0; i < x.size(); ++i) {
+                const std::complex<double> y =
+                    v.samples[i] * std::polar(1.0, 2.0 * pi * cfo * double(i) / double(N));
+                x[i] = std::complex<float>(y);
+                peak = std::max(peak, std::abs(v.samples[i]));
+            }
+            ws.metrics.cfo = static_cast<float>(cfo);
+            ws.metrics.time_offset = 0.0f;
+            compensate_offsets(&ws, x.data(), x.size());
+            double err = 0.0;
+            for (size_t i = 0; i < x.size(); ++i)
+                err = std::max(err, std::abs(std::complex<double>(x[i]) - v.samples[i]));
+            if (err > 1e-5 * peak) {
+                std::cerr << "sf " << v.sf << " cfo " << cfo << ": residual " << err << "\n";
+                ok = false;
+            }
+            for (size_t s = 0; s < decided.size(); ++s) {
+                for (size_t i = 0; i < N; ++i) detector.feed(i, x[s * N + i]);
+                float p, pav, fi;
+                if (detector.detect(p, pav, fi) != decided[s]) {
+                    std::cerr << "sf " << v.sf << " cfo " << cfo << ": symbol " << s
+                              << " decided differently\n";
+                    ok = false;
+                }
+            }
+        }
+    }
+
+    return ok ? 0 : 1;
+}
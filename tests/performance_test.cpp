@@ -1,7 +1,9 @@
 #include <lora_phy/phy.hpp>
+#include <lora_phy/modem.hpp>
 #include <lora_phy/ChirpGenerator.hpp>
 #include <chrono>
 #include <complex>
+#include <cstddef>
 #include <cstdint>
 #include <cstdlib>
 #include <fstream>
@@ -156,6 +158,61 @@ int main() {
 #endif
     }
 
+    // Generic high level demodulate() against the compile time specialised
+    // modem for the same configuration, on the same packet.
+    std::ofstream modem_csv("logs/modem_" + run_id + ".csv");
+    modem_csv << "run_id,profile,sf,osr,generic_sps,specialized_sps\n";
+    const size_t MODEM_PACKETS = 200;
+    for (const auto& p : profiles) {
+        for (unsigned osr : {1u, 4u}) {
+            lora_phy::lora_params cfg{};
+            cfg.sf = p.sf;
+            cfg.osr = osr;
+            cfg.bw = static_cast<lora_phy::bandwidth>(p.bw);
+            const lora_phy::modem_ops* ops = lora_phy::find_modem(&cfg);
+            if (!ops) continue;
+            std::vector<std::max_align_t> storage(ops->size / sizeof(std::max_align_t) + 1);
+            if (ops->init(storage.data(), &cfg) != 0) continue;
+
+            // The generic path gets the same precomputed dechirp and window
+            // tables as the modem, so only the specialisation differs.
+            const size_t N = size_t(1) << p.sf;
+            std::vector<std::complex<float>> fft_in(N), fft_out(N), chirp(N * osr), dechirp(N);
+            std::vector<float> window(N);
+            lora_phy::lora_workspace ws{};
+            ws.fft_in = fft_in.data();
+            ws.fft_out = fft_out.data();
+            ws.window = window.data();
+            ws.chirp_buf = chirp.data();
+            ws.dechirp = dechirp.data();
+            if (lora_phy::init(&ws, &cfg) != 0) continue;
+
+            std::vector<uint16_t> symbols(PAYLOAD_SIZE * 2);
+            for (size_t i = 0; i < symbols.size(); ++i)
+                symbols[i] = static_cast<uint16_t>((i * 131) % N);
+            std::vector<std::complex<float>> iq((symbols.size() + 2) * N * osr);
+            ops->modulate(storage.data(), symbols.data(), symbols.size(), iq.data(), iq.size());
+            std::vector<uint16_t> out(symbols.size());
+
+            auto t0 = std::chrono::high_resolution_clock::now();
+            for (size_t pkt = 0; pkt < MODEM_PACKETS; ++pkt)
+                lora_phy::demodulate(&ws, iq.data(), iq.size(), out.data(), out.size());
+            auto t1 = std::chrono::high_resolution_clock::now();
+            for (size_t pkt = 0; pkt < MODEM_PACKETS; ++pkt)
+                ops->demodulate(storage.data(), iq.data(), iq.size(), out.data(), out.size());
+            auto t2 = std::chrono::high_resolution_clock::now();
+
+            const double syms = static_cast<double>((symbols.size() + 2) * MODEM_PACKETS);
+            const double generic = syms / std::chrono::duration<double>(t1 - t0).count();
+            const double special = syms / std::chrono::duration<double>(t2 - t1).count();
+            modem_csv << run_id << ',' << p.name << ',' << p.sf << ',' << osr << ','
+                      << generic << ',' << special << '\n';
+            std::cout << '[' << run_id << "] " << p.name << " osr " << osr
+                      << ": generic " << generic << " sym/s, modem<" << p.sf << ',' << osr
+                      << "> " << special << " sym/s" << std::endl;
+        }
+    }
+
     return 0;
 }
 
@@ -0,0 +1,74 @@
+#pragma once
+#include <lora_phy/LoRaDetector.hpp>
+#include <lora_phy/dsp_kernels.hpp>
+#include <lora_phy/kissfft.hh>
+#include <cmath>
+#include <complex>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Deterministic test signals and an FFT/detector fixture for the DSP tests.
+
+// Advance the 32-bit LCG state @p s and return it.
+inline uint32_t lcg_next(uint32_t& s) {
+    s = s * 1664525u + 1013904223u;
+    return s;
+}
+
+// Next LCG draw, uniform in [-0.5, 0.5).
+inline float uniform(uint32_t& s) {
+    return float(lcg_next(s) >> 8) / float(1u << 24) - 0.5f;
+}
+
+// Roughly Gaussian draw with unit variance: four uniforms, rescaled.
+inline float gauss(uint32_t& s) {
+    float acc = 0.0f;
+    for (int i = 0; i < 4; ++i) acc += uniform(s);
+    return acc * std::sqrt(3.0f);
+}
+
+// @p n samples with real and imaginary parts drawn by uniform() from @p seed.
+inline std::vector<std::complex<float>> random_vector(size_t n, uint32_t seed) {
+    std::vector<std::complex<float>> v(n);
+    for (auto& x : v) {
+        const float re = uniform(seed);
+        const float im = uniform(seed);
+        x = std::complex<float>(re, im);
+    }
+    return v;
+}
+
+// x[i] += ampl * exp(j*2*pi*bin*i/N) for the first @p n samples.
+inline void add_tone(std::complex<float>* x, size_t n, size_t N, double bin, float ampl = 1.0f) {
+    const double pi = std::acos(-1.0);
+    for (size_t i = 0; i < n; ++i) {
+        const double ph = 2.0 * pi * bin * double(i) / double(N);
+        x[i] += ampl * std::complex<float>(float(std::cos(ph)), float(std::sin(ph)));
+    }
+}
+
+// An N-point forward FFT over its own plan and in/out buffers, and a
+// detector fed through `in`.  @p k selects the FFT and argmax kernels; by
+// default both run their portable paths.
+struct detector_fixture {
+    explicit detector_fixture(size_t N, const lora_phy::dsp_kernels* k = nullptr)
+        : plan(make_plan(N)),
+          fft(*plan, k ? k->fft_radix4 : nullptr, k ? k->fft_radix4_batch : nullptr),
+          in(N),
+          out(N),
+          detector(N, in.data(), out.data(), fft, k ? k->mag2_argmax : nullptr) {}
+
+    std::unique_ptr<kissfft_embedded_plan<float>> plan;
+    kissfft<float> fft;
+    std::vector<std::complex<float>> in, out;
+    LoRaDetector<float> detector;
+
+private:
+    static std::unique_ptr<kissfft_embedded_plan<float>> make_plan(size_t N) {
+        std::unique_ptr<kissfft_embedded_plan<float>> p(new kissfft_embedded_plan<float>);
+        kissfft<float>::init(*p, int(N), false);
+        return p;
+    }
+};
@@ -0,0 +1,144 @@
+#include <lora_phy/LoRaDetector.hpp>
+#include <lora_phy/phy.hpp>
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+#include "signal_utils.hpp"
+
+// Max-log bit LLRs: softBits must match a brute-force evaluation, agree in
+// sign with the hard decision, and the demodulators must emit sf of them per
+// symbol that shrink as the SNR drops.
+
+using namespace lora_phy;
+
+static void make_symbols(std::complex<float>* x, size_t n_syms, size_t M,
+                         const std::vector<uint16_t>& syms, float noise, uint32_t seed) {
+    for (size_t s = 0; s < n_syms; ++s) {
+        for (size_t i = 0; i < M; ++i)
+            x[s * M + i] = noise * std::complex<float>(gauss(seed), gauss(seed));
+        add_tone(x + s * M, M, M, syms[s], 0.25f);
+    }
+}
+
+int main() {
+    bool ok = true;
+    const size_t N = 512;
+    detector_fixture fx(N);
+    LoRaDetector<float>& detector = fx.detector;
+    std::vector<std::complex<float>>& in = fx.in;
+    std::vector<std::complex<float>>& out = fx.out;
+    if (detector.bitsPerSymbol() != 9) {
+        std::cerr << "bitsPerSymbol " << detector.bitsPerSymbol() << "\n";
+        ok = false;
+    }
+
+    make_symbols(in.data(), 1, N, {uint16_t(300)}, 0.3f, 3u);
+    float p, pav, fi;
+    const size_t idx = detector.detect(p, pav, fi);
+    float llr[9];
+    detector.softBits(out.data(), 1, llr);
+    double total = 0.0, peak = 0.0;
+    for (auto& x : out) {
+        total += std::norm(x);
+        peak = std::max(peak, double(std::norm(x)));
+    }
+    const double noise = (total - peak) / double(N - 1);
+    for (unsigned k = 0; k < 9; ++k) {
+        double best[2] = {0.0, 0.0};
+        for (size_t i = 0; i < N; ++i)
+            best[(i >> k) & 1] = std::max(best[(i >> k) & 1], double(std::norm(out[i])));
+        const double want = (best[0] - best[1]) / noise;
+        if (std::abs(llr[k] - want) > 1e-3 * (1.0 + std::abs(want)) ||
+            (llr[k] > 0.0f) != !((idx >> k) & 1)) {
+            std::cerr << "bit " << k << " llr " << llr[k] << ", want " << want << "\n";
+            ok = false;
+        }
+    }
+
+    // lora_demodulate, lora_demodulate_sc16 and demodulate_soft on clean and
+    // noisy dechirped symbols (two bin 0 symbols lead for the estimate).
+    const unsigned sf = 9;
+    const size_t n_syms = 16;
+    std::vector<uint16_t> tx(n_syms + 2, 0);
+    for (size_t i = 2; i < tx.size(); ++i) tx[i] = static_cast<uint16_t>((i * 151 + 17) % N);
+    float mean_abs[2] = {};
+    for (int noisy = 0; noisy < 2; ++noisy) {
+        std::vector<std::complex<float>> iq(tx.size() * N);
+        make_symbols(iq.data(), tx.size(), N, tx, noisy ? 0.2f : 0.01f, 11u);
+        std::vector<std::complex<int16_t>> iq16(iq.size());
+        for (size_t i = 0; i < iq.size(); ++i)
+            iq16[i] = std::complex<int16_t>(kissfft_utils::q15_unit(0.5f * iq[i].real()),
+                                            kissfft_utils::q15_unit(0.5f * iq[i].imag()));
+        static lora_demod_workspace ws{};
+        lora_demod_init(&ws, sf);
+        std::vector<uint16_t> hard(n_syms), hard16(n_syms), plain(n_syms);
+        std::vector<float> llrs(n_syms * sf), llrs16(n_syms * sf);
+        lora_demodulate(&ws, iq.data(), iq.size(), plain.data(), 1);
+        const ssize_t n = lora_demodulate(&ws, iq.data(), iq.size(), hard.data(), 1, nullptr,
+                                          nullptr, 0, llrs.data());
+        const ssize_t n16 = lora_demodulate_sc16(&ws, iq16.data(), iq16.size(), hard16.data(), 1,
+                                                 nullptr, llrs16.data());
+        if (n != ssize_t(n_syms) || n16 != n || hard != plain) {
+            std::cerr << "soft output changed lora_demodulate\n";
+            ok = false;
+        }
+        for (size_t i = 0; i < n_syms; ++i)
+            for (unsigned k = 0; k < sf; ++k) {
+                const bool zero = !((hard[i] >> k) & 1);
+                const bool zero16 = !((hard16[i] >> k) & 1);
+                mean_abs[noisy] += std::abs(llrs[i * sf + k]) / float(n_syms * sf);
+                if ((llrs[i * sf + k] >= 0.0f) != zero || (llrs16[i * sf + k] >= 0.0f) != zero16) {
+                    std::cerr << "llr sign disagrees with symbol " << i << " bit " << k << "\n";
+                    ok = false;
+                }
+            }
+        if (!noisy && (hard != std::vector<uint16_t>(tx.begin() + 2, tx.end()) || hard16 != hard)) {
+            std::cerr << "clean symbols misdecoded\n";
+            ok = false;
+        }
+        lora_demod_free(&ws);
+    }
+    if (!(mean_abs[0] > 10.0f * mean_abs[1])) {
+        std::cerr << "llr magnitude does not track SNR: " << mean_abs[0] << " vs " << mean_abs[1]
+                  << "\n";
+        ok = false;
+    }
+
+    // High level API: soft and hard decisions agree, in place and batched.
+    std::vector<std::complex<float>> ws_in(N), ws_out(N), batch_buf(N * 4);
+    for (int mode = 0; mode < 3; ++mode) {
+        lora_workspace ws{};
+        ws.fft_in = ws_in.data();
+        ws.fft_out = mode == 1 ? nullptr : ws_out.data();
+        if (mode == 2) {
+            ws.batch_in = batch_buf.data();
+            ws.batch_len = batch_buf.size();
+        }
+        lora_params cfg{};
+        cfg.sf = sf;
+        std::vector<uint16_t> syms(n_syms), hard(n_syms), soft(n_syms);
+        for (size_t i = 0; i < n_syms; ++i) syms[i] = static_cast<uint16_t>((i * 77 + 5) % N);
+        std::vector<std::complex<float>> sig((n_syms + 2) * N);
+        std::vector<float> llrs(n_syms * sf);
+        if (init(&ws, &cfg) != 0 ||
+            modulate(&ws, syms.data(), n_syms, sig.data(), sig.size()) != ssize_t(sig.size()) ||
+            demodulate(&ws, sig.data(), sig.size(), hard.data(), n_syms) != ssize_t(n_syms) ||
+            demodulate_soft(&ws, sig.data(), sig.size(), soft.data(), n_syms, llrs.data()) !=
+                ssize_t(n_syms)) {
+            std::cerr << "high level soft demodulation failed\n";
+            ok = false;
+            continue;
+        }
+        for (size_t i = 0; i < n_syms; ++i)
+            for (unsigned k = 0; k < sf; ++k)
+                if (soft[i] != hard[i] || (llrs[i * sf + k] >= 0.0f) != !((soft[i] >> k) & 1)) {
+                    std::cerr << "demodulate_soft mode " << mode << " symbol " << i << "\n";
+                    ok = false;
+                }
+    }
+
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,143 @@
+#include <lora_phy/phy.hpp>
+#include <cmath>
+#include <complex>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+#include "signal_utils.hpp"
+
+// Per-symbol quality and the packet SNR/RSSI: on dechirped tones in white
+// noise of known power they must read the true values, a colliding tone
+// must show up in peak_to_second, and asking for quality must neither change
+// decisions nor depend on the workspace metrics level.
+
+using namespace lora_phy;
+
+int main() {
+    bool ok = true;
+    const unsigned sf = 10;
+    const size_t M = size_t(1) << sf;
+    const size_t n_syms = 20;
+    const float ampl = 0.25f, sigma = 0.05f; // per I/Q component
+    const float want_snr = 10.0f * std::log10(ampl * ampl / (2.0f * sigma * sigma));
+    const float want_rssi = 10.0f * std::log10(ampl * ampl + 2.0f * sigma * sigma);
+    std::vector<std::complex<float>> iq((n_syms + 2) * M);
+    uint32_t seed = 7;
+    for (auto& x : iq) x = sigma * std::complex<float>(gauss(seed), gauss(seed));
+    add_tone(iq.data(), M, M, 0.0, ampl);
+    add_tone(iq.data() + M, M, M, 0.0, ampl);
+    std::vector<uint16_t> tx(n_syms);
+    for (size_t i = 0; i < n_syms; ++i) {
+        tx[i] = static_cast<uint16_t>((i * 331 + 9) % M);
+        add_tone(iq.data() + (i + 2) * M, M, M, tx[i], ampl);
+    }
+    // Symbol 5 collides with a tone 3 dB weaker.
+    add_tone(iq.data() + 7 * M, M, M, double((tx[5] + 200) % M), ampl / std::sqrt(2.0f));
+    std::vector<std::complex<int16_t>> iq16(iq.size());
+    for (size_t i = 0; i < iq.size(); ++i)
+        iq16[i] = std::complex<int16_t>(kissfft_utils::q15_unit(iq[i].real()),
+                                        kissfft_utils::q15_unit(iq[i].imag()));
+
+    static lora_demod_workspace ws{};
+    lora_demod_init(&ws, sf);
+    std::vector<uint16_t> plain(n_syms), got(n_syms), got16(n_syms);
+    std::vector<lora_symbol_quality> q(n_syms), q16(n_syms);
+    lora_demodulate(&ws, iq.data(), iq.size(), plain.data(), 1);
+    if (ws.metrics.snr != 0.0f || ws.metrics.rssi != 0.0f) {
+        std::cerr << "SNR/RSSI reported without metrics or quality\n";
+        ok = false;
+    }
+    const ssize_t n = lora_demodulate(&ws, iq.data(), iq.size(), got.data(), 1, nullptr, nullptr,
+                                      0, nullptr, q.data());
+    const lora_metrics m = ws.metrics;
+    const ssize_t n16 = lora_demodulate_sc16(&ws, iq16.data(), iq16.size(), got16.data(), 1,
+                                             nullptr, nullptr, q16.data());
+    if (n != ssize_t(n_syms) || n16 != n || got != plain || got != tx || got16 != tx) {
+        std::cerr << "quality output changed the decisions\n";
+        ok = false;
+    }
+    // The collision drags the packet mean down by about 0.4 dB.
+    if (std::abs(m.snr - want_snr) > 1.0f || std::abs(m.rssi - want_rssi) > 0.5f ||
+        std::abs(m.peak_power - 20.0f * std::log10(ampl)) > 0.5f) {
+        std::cerr << "packet SNR " << m.snr << " (want " << want_snr << "), RSSI " << m.rssi
+                  << " (want " << want_rssi << ")\n";
+        ok = false;
+    }
+    if (std::abs(ws.metrics.snr - m.snr) > 0.2f || std::abs(ws.metrics.rssi - m.rssi) > 0.2f) {
+        std::cerr << "sc16 SNR " << ws.metrics.snr << ", RSSI " << ws.metrics.rssi << "\n";
+        ok = false;
+    }
+    float sum_peak = 0.0f;
+    for (size_t i = 0; i < n_syms; ++i) {
+        sum_peak += q[i].peak_power;
+        const float snr = q[i].peak_power - q[i].noise_power;
+        // The colliding tone counts as noise for symbol 5.
+        const bool collided = i == 5;
+        const float want = collided ? 10.0f * std::log10(ampl * ampl /
+                                                         (0.5f * ampl * ampl + 2.0f * sigma * sigma))
+                                    : want_snr;
+        const bool ratio_ok = collided ? std::abs(q[i].peak_to_second - 3.0f) < 0.5f
+                                       : q[i].peak_to_second > 10.0f;
+        if (!ratio_ok || std::abs(snr - want) > 1.0f ||
+            std::abs(q16[i].peak_power - q[i].peak_power) > 0.2f ||
+            std::abs(q16[i].noise_power - q[i].noise_power) > 0.2f ||
+            std::abs(q16[i].peak_to_second - q[i].peak_to_second) > 0.2f) {
+            std::cerr << "symbol " << i << ": SNR " << snr << ", peak/second "
+                      << q[i].peak_to_second << " (sc16 " << q16[i].peak_to_second << ")\n";
+            ok = false;
+        }
+    }
+    if (std::abs(sum_peak / float(n_syms) - m.peak_power) > 1e-4f) {
+        std::cerr << "packet peak power is not the mean of the symbols'\n";
+        ok = false;
+    }
+    lora_demod_free(&ws);
+
+    // High level API: quality_len bounds the output, batching and levels
+    // do not change it.
+    std::vector<std::complex<float>> ws_in(M), ws_out(M), batch_buf(M * 4);
+    const size_t cap = n_syms - 3;
+    std::vector<lora_symbol_quality> ref;
+    for (int mode = 0; mode < 2; ++mode) {
+        lora_workspace hw{};
+        hw.fft_in = ws_in.data();
+        hw.fft_out = ws_out.data();
+        if (mode == 1) {
+            hw.batch_in = batch_buf.data();
+            hw.batch_len = batch_buf.size();
+        }
+        std::vector<lora_symbol_quality> hq(n_syms, lora_symbol_quality{-1.0f, -1.0f, -1.0f});
+        hw.quality = hq.data();
+        hw.quality_len = cap;
+        lora_params cfg{};
+        cfg.sf = sf;
+        cfg.symbol_metrics = mode == 1 ? metrics_level::peak : metrics_level::none;
+        std::vector<uint16_t> syms(n_syms);
+        std::vector<std::complex<float>> sig((n_syms + 2) * M);
+        if (init(&hw, &cfg) != 0 ||
+            modulate(&hw, tx.data(), n_syms, sig.data(), sig.size()) != ssize_t(sig.size()) ||
+            demodulate(&hw, sig.data(), sig.size(), syms.data(), n_syms) != ssize_t(n_syms)) {
+            std::cerr << "high level demodulation failed\n";
+            ok = false;
+            continue;
+        }
+        if (hw.metrics.snr <= 0.0f || hq[cap].peak_power != -1.0f ||
+            hq[cap - 1].peak_power == -1.0f) {
+            std::cerr << "high level quality mode " << mode << " wrong\n";
+            ok = false;
+        }
+        if (mode == 0) {
+            ref = hq;
+            continue;
+        }
+        for (size_t i = 0; i < cap; ++i)
+            if (std::abs(hq[i].peak_power - ref[i].peak_power) > 1e-3f ||
+                std::abs(hq[i].noise_power - ref[i].noise_power) > 1e-2f ||
+                std::abs(hq[i].peak_to_second - ref[i].peak_to_second) > 1e-2f) {
+                std::cerr << "batched quality differs at symbol " << i << "\n";
+                ok = false;
+            }
+    }
+
+    return ok ? 0 : 1;
+}
@@ -10,8 +10,32 @@ int equal_power_bin_test_main();
 int sync_word_test_main();
 int error_code_test_main();
 int odd_symbol_count_test_main();
-int scratch_buffer_error_test_main();
+int large_input_test_main();
 int lorawan_mic_test_main();
+int fft_pow2_test_main();
+int dsp_dispatch_test_main();
+int fft_plan_registry_test_main();
+int fft_batch_test_main();
+int fft_planner_test_main();
+int zoom_refine_test_main();
+int fft_inplace_test_main();
+int fft_q15_test_main();
+int detect_perf_test_main();
+int top_k_peaks_test_main();
+int metrics_level_test_main();
+int soft_llr_test_main();
+int llr_perf_test_main();
+int symbol_quality_test_main();
+int chirp_table_test_main();
+int nco_test_main();
+int mod_stream_test_main();
+int quantized_mod_test_main();
+int frame_mod_test_main();
+int wideband_synth_test_main();
+int modem_template_test_main();
+int dechirp_table_test_main();
+int demod_stream_test_main();
+int frame_sync_test_main();
 
 int main() {
     int result = 0;
@@ -25,8 +49,32 @@ int main() {
     result |= sync_word_test_main();
     result |= error_code_test_main();
     result |= odd_symbol_count_test_main();
-    result |= scratch_buffer_error_test_main();
+    result |= large_input_test_main();
     result |= lorawan_mic_test_main();
+    result |= fft_pow2_test_main();
+    result |= dsp_dispatch_test_main();
+    result |= fft_plan_registry_test_main();
+    result |= fft_batch_test_main();
+    result |= fft_planner_test_main();
+    result |= zoom_refine_test_main();
+    result |= fft_inplace_test_main();
+    result |= fft_q15_test_main();
+    result |= detect_perf_test_main();
+    result |= top_k_peaks_test_main();
+    result |= metrics_level_test_main();
+    result |= soft_llr_test_main();
+    result |= llr_perf_test_main();
+    result |= symbol_quality_test_main();
+    result |= chirp_table_test_main();
+    result |= nco_test_main();
+    result |= mod_stream_test_main();
+    result |= quantized_mod_test_main();
+    result |= frame_mod_test_main();
+    result |= wideband_synth_test_main();
+    result |= modem_template_test_main();
+    result |= dechirp_table_test_main();
+    result |= demod_stream_test_main();
+    result |= frame_sync_test_main();
     if (result != 0) {
         std::printf("Some tests failed\n");
     }
@@ -0,0 +1,169 @@
+#include <lora_phy/LoRaDetector.hpp>
+#include <lora_phy/phy.hpp>
+#include <cerrno>
+#include <cmath>
+#include <complex>
+#include <cstdint>
+#include <iostream>
+#include <limits>
+#include <vector>
+#include "signal_utils.hpp"
+
+// Two or three tones in one symbol: detectPeaks must return each of them,
+// strongest first, with the same sub-bin offsets the single-peak path would
+// report, and lora_demodulate must expose the weaker packet of a collision
+// as the runner-up peak of every payload symbol.
+
+using namespace lora_phy;
+
+int main() {
+    bool ok = true;
+    const size_t N = 256;
+    detector_fixture fx(N);
+    LoRaDetector<float>& detector = fx.detector;
+    std::vector<std::complex<float>>& in = fx.in;
+
+    add_tone(in.data(), N, N, 40.0, 1.0f);
+    add_tone(in.data(), N, N, 181.25, 0.5f);
+    add_tone(in.data(), N, N, 7.0, 0.2f);
+    const std::vector<std::complex<float>> sym = in;
+    LoRaDetector<float>::Peak peaks[3];
+    if (detector.detectPeaks(3, peaks) != 3 || peaks[0].index != 40 || peaks[1].index != 181 ||
+        peaks[2].index != 7) {
+        std::cerr << "detectPeaks missed a tone\n";
+        ok = false;
+    }
+    if (std::abs(peaks[0].magnitude - float(N)) > 0.05f * float(N) ||
+        !(peaks[1].magnitude > peaks[2].magnitude) || peaks[1].offset <= 0.0f) {
+        std::cerr << "detectPeaks magnitudes or offsets wrong\n";
+        ok = false;
+    }
+    in = sym;
+    float p, pav, fi;
+    const size_t idx = detector.detect(p, pav, fi);
+    if (idx != peaks[0].index || std::abs(fi - peaks[0].offset) > 1e-6f) {
+        std::cerr << "first peak differs from detect()\n";
+        ok = false;
+    }
+    // K is clamped to MAX_PEAKS and the result stays sorted; a little noise
+    // guarantees plenty of local maxima.
+    LoRaDetector<float>::Peak many[LoRaDetector<float>::MAX_PEAKS];
+    in = sym;
+    uint32_t seed = 1;
+    for (auto& x : in) x += std::complex<float>(uniform(seed), 0.0f) * 0.01f;
+    if (detector.detectPeaks(100, many) != LoRaDetector<float>::MAX_PEAKS) {
+        std::cerr << "detectPeaks did not clamp K\n";
+        ok = false;
+    }
+    for (size_t j = 1; j < LoRaDetector<float>::MAX_PEAKS; ++j)
+        if (many[j].magnitude > many[j - 1].magnitude) {
+            std::cerr << "peaks not sorted\n";
+            ok = false;
+        }
+
+    // A plateau wrapping from bin N-1 to bin 0 is one peak, reported at bin
+    // 0 like detect()'s argmax, however many bins before N-1 it spans.
+    for (size_t width : {1u, 3u}) {
+        std::vector<std::complex<float>> spec(N, std::complex<float>(1.0f, 0.0f));
+        spec[0] = std::complex<float>(5.0f, 0.0f);
+        for (size_t i = N - width; i < N; ++i) spec[i] = spec[0];
+        spec[100] = std::complex<float>(3.0f, 0.0f);
+        LoRaDetector<float>::Peak wrap[3];
+        const size_t found = detector.findPeaks(spec.data(), 1, 3, wrap);
+        if (found != 2 || wrap[0].index != 0 || wrap[1].index != 100) {
+            std::cerr << "wrapping plateau of " << width + 1 << " bins reported "
+                      << found << " peaks\n";
+            ok = false;
+        }
+    }
+
+    // A plateau is a peak only if it stands above the bins on both sides:
+    // not when it wraps next to a higher bin, nor when it rises again.
+    {
+        std::vector<std::complex<float>> spec(N, std::complex<float>(1.0f, 0.0f));
+        spec[0] = spec[N - 1] = std::complex<float>(5.0f, 0.0f);
+        spec[N - 2] = std::complex<float>(7.0f, 0.0f);
+        spec[100] = spec[101] = std::complex<float>(3.0f, 0.0f);
+        spec[102] = std::complex<float>(4.0f, 0.0f);
+        LoRaDetector<float>::Peak p[3];
+        const size_t found = detector.findPeaks(spec.data(), 1, 3, p);
+        if (found != 2 || p[0].index != N - 2 || p[1].index != 102) {
+            std::cerr << "plateau bordered by a higher bin reported " << found << " peaks\n";
+            ok = false;
+        }
+    }
+
+    // A tone over an all-zero background is the only peak, and a flat
+    // spectrum has none.
+    {
+        std::vector<std::complex<float>> spec(N);
+        spec[2] = std::complex<float>(1.0f, 0.0f);
+        LoRaDetector<float>::Peak p[2];
+        size_t found = detector.findPeaks(spec.data(), 1, 2, p);
+        if (found != 1 || p[0].index != 2) {
+            std::cerr << "tone over zeros reported " << found << " peaks\n";
+            ok = false;
+        }
+        if (detector.peakToSecond(spec.data(), 1) != std::numeric_limits<float>::infinity()) {
+            std::cerr << "tone over zeros has a runner-up\n";
+            ok = false;
+        }
+        spec[2] = 0.0f;
+        found = detector.findPeaks(spec.data(), 1, 2, p);
+        if (found != 0) {
+            std::cerr << "flat spectrum reported " << found << " peaks\n";
+            ok = false;
+        }
+    }
+
+    // Collision: a strong and a weak packet on the same SF, dechirped, after
+    // two clean bin 0 symbols for the timing/CFO estimate.  SF8 runs the
+    // batched FFT path, SF12 one symbol per FFT.
+    for (unsigned sf : {8u, 12u}) {
+        const size_t M = size_t(1) << sf;
+        const size_t n_syms = 10;
+        std::vector<std::complex<float>> iq((n_syms + 2) * M);
+        std::vector<uint16_t> strong(n_syms + 2), weak(n_syms + 2);
+        add_tone(iq.data(), 2 * M, M, 0.0, 0.6f);
+        for (size_t s = 2; s < n_syms + 2; ++s) {
+            strong[s] = static_cast<uint16_t>((s * 37 + 11) % M);
+            weak[s] = static_cast<uint16_t>((strong[s] + 50 + s * 13) % M);
+            add_tone(iq.data() + s * M, M, M, strong[s], 0.6f);
+            add_tone(iq.data() + s * M, M, M, weak[s], 0.3f);
+        }
+        static lora_demod_workspace ws{};
+        lora_demod_init(&ws, sf);
+        std::vector<uint16_t> symbols(n_syms);
+        std::vector<lora_peak> out_peaks(n_syms * 2);
+        const ssize_t n = lora_demodulate(&ws, iq.data(), iq.size(), symbols.data(), 1, nullptr,
+                                          out_peaks.data(), 2);
+        if (n != ssize_t(n_syms)) {
+            std::cerr << "lora_demodulate returned " << n << " at sf " << sf << "\n";
+            ok = false;
+        }
+        for (size_t i = 0; i < n_syms && n == ssize_t(n_syms); ++i) {
+            if (symbols[i] != strong[i + 2] || out_peaks[2 * i].index != symbols[i] ||
+                out_peaks[2 * i + 1].index != weak[i + 2]) {
+                std::cerr << "sf " << sf << " collision symbol " << i << ": got "
+                          << out_peaks[2 * i].index << "/" << out_peaks[2 * i + 1].index
+                          << ", sent " << strong[i + 2] << "/" << weak[i + 2] << "\n";
+                ok = false;
+            }
+        }
+        // Asking for peaks must not change the decisions.
+        std::vector<uint16_t> plain(n_syms);
+        lora_demodulate(&ws, iq.data(), iq.size(), plain.data(), 1);
+        if (plain != symbols) {
+            std::cerr << "peak output changed the decided symbols at sf " << sf << "\n";
+            ok = false;
+        }
+        if (lora_demodulate(&ws, iq.data(), iq.size(), symbols.data(), 1, nullptr,
+                            out_peaks.data(), MAX_DEMOD_PEAKS + 1) != -EINVAL) {
+            std::cerr << "oversized peaks_per_symbol accepted\n";
+            ok = false;
+        }
+        lora_demod_free(&ws);
+    }
+
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,126 @@
+#include <lora_phy/phy.hpp>
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <complex>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+// A wideband stream must be the sum of every packet's table modulated
+// samples mixed to its channel offset, silent elsewhere, whatever the chunk
+// sizes, and channel/packet parameters that cannot work must be refused.
+
+using namespace lora_phy;
+
+int main() {
+    bool ok = true;
+    const double rate = 1e6;
+    const double pi = std::acos(-1.0);
+
+    struct channel_config { unsigned sf; bandwidth bw; double offset; };
+    const channel_config configs[] = {{7, bandwidth::bw_125, -250e3},
+                                      {8, bandwidth::bw_250, 200e3},
+                                      {7, bandwidth::bw_125, 375e3}};
+    std::vector<std::vector<std::complex<float>>> bufs;
+    std::vector<lora_tx_channel> channels(3);
+    for (size_t c = 0; c < 3; ++c) {
+        const size_t osr = size_t(rate / bw_to_hz(configs[c].bw));
+        bufs.emplace_back((size_t(1) << configs[c].sf) * osr);
+        if (lora_tx_channel_init(&channels[c], bufs[c].data(), bufs[c].size(), configs[c].sf,
+                                 configs[c].bw, rate, configs[c].offset) != 0 ||
+            channels[c].osr != osr) {
+            std::cerr << "lora_tx_channel_init failed for channel " << c << "\n";
+            return 1;
+        }
+    }
+
+    std::vector<uint16_t> sym_a = {5, 127, 0, 64}, sym_b = {255, 1, 100}, sym_c = {33, 90};
+    std::vector<lora_tx_packet> packets(4);
+    packets[0] = {&channels[0], sym_a.data(), sym_a.size(), 100, 1.0f, 0x12};
+    packets[1] = {&channels[1], sym_b.data(), sym_b.size(), 3000, 0.5f, 0x34};
+    packets[2] = {&channels[2], sym_c.data(), sym_c.size(), 40, 0.25f, 0x12};
+    // Starts after the others end, leaving a silent gap.
+    packets[3] = {&channels[0], sym_c.data(), sym_c.size(), 12000, 1.0f, 0x12};
+
+    // Reference: each packet from the baseband chirp table, mixed up in
+    // double precision and summed.
+    size_t total = 0;
+    for (const auto& p : packets)
+        total = std::max(total, p.start + (p.symbol_count + 2) * p.channel->len);
+    std::vector<std::complex<double>> want(total);
+    for (size_t p = 0; p < packets.size(); ++p) {
+        const lora_tx_packet& pkt = packets[p];
+        const channel_config& cfg = configs[pkt.channel - channels.data()];
+        std::vector<std::complex<float>> table(pkt.channel->len);
+        lora_chirp_table chirp;
+        lora_chirp_table_init(&chirp, table.data(), table.size(), cfg.sf, pkt.channel->osr,
+                              cfg.bw);
+        std::vector<std::complex<float>> base((pkt.symbol_count + 2) * table.size());
+        lora_modulate_table(&chirp, pkt.symbols, pkt.symbol_count, base.data(), pkt.amplitude,
+                            pkt.sync_word);
+        for (size_t i = 0; i < base.size(); ++i)
+            want[pkt.start + i] += std::complex<double>(base[i]) *
+                                   std::polar(1.0, 2.0 * pi * cfg.offset * double(i) / rate);
+    }
+
+    std::vector<std::complex<float>> whole;
+    for (size_t chunk : {size_t(1), size_t(7), size_t(64), size_t(1000), total + 5}) {
+        lora_wideband_synth synth;
+        if (lora_wideband_init(&synth, packets.data(), packets.size()) != 0) {
+            std::cerr << "lora_wideband_init failed\n";
+            return 1;
+        }
+        std::vector<std::complex<float>> got, ring(chunk);
+        bool counted = lora_wideband_remaining(&synth) == total;
+        while (size_t n = lora_wideband_next(&synth, ring.data(), ring.size())) {
+            got.insert(got.end(), ring.begin(), ring.begin() + n);
+            counted = counted && lora_wideband_remaining(&synth) == total - got.size();
+        }
+        double err = 0.0;
+        for (size_t i = 0; i < std::min(got.size(), want.size()); ++i)
+            err = std::max(err, std::abs(std::complex<double>(got[i]) - want[i]));
+        if (got.size() != total || !counted || err > 1e-4) {
+            std::cerr << "wideband chunk " << chunk << ": " << got.size() << " of " << total
+                      << " samples" << (counted ? "" : ", miscounted") << ", error " << err
+                      << "\n";
+            ok = false;
+        }
+        if (whole.empty()) whole = got;
+        double split = 0.0;
+        for (size_t i = 0; i < std::min(got.size(), whole.size()); ++i)
+            split = std::max(split, double(std::abs(got[i] - whole[i])));
+        if (split > 1e-6) {
+            std::cerr << "wideband chunk " << chunk << " differs by " << split << "\n";
+            ok = false;
+        }
+    }
+    const size_t gap_end = packets[3].start;
+    const size_t gap_start = packets[1].start + (sym_b.size() + 2) * channels[1].len;
+    for (size_t i = gap_start; i < gap_end && i < whole.size(); ++i) {
+        if (whole[i] != std::complex<float>()) {
+            std::cerr << "wideband gap not silent at " << i << "\n";
+            ok = false;
+            break;
+        }
+    }
+
+    std::vector<std::complex<float>> small(1024);
+    lora_tx_channel ch;
+    lora_wideband_synth synth;
+    std::vector<lora_tx_packet> many(MAX_SYNTH_PACKETS + 1, packets[0]);
+    lora_tx_packet orphan{};
+    if (lora_tx_channel_init(&ch, small.data(), small.size(), 7, bandwidth::bw_125, 1.1e6,
+                             0.0) != -EINVAL ||
+        lora_tx_channel_init(&ch, small.data(), small.size(), 7, bandwidth::bw_125, rate,
+                             450e3) != -EINVAL ||
+        lora_tx_channel_init(&ch, small.data(), small.size() - 1, 7, bandwidth::bw_125, rate,
+                             0.0) != -ERANGE ||
+        lora_wideband_init(&synth, many.data(), many.size()) != -EINVAL ||
+        lora_wideband_init(&synth, &orphan, 1) != -EINVAL) {
+        std::cerr << "invalid wideband parameters accepted\n";
+        ok = false;
+    }
+
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,70 @@
+#include <lora_phy/LoRaDetector.hpp>
+#include <lora_phy/phy.hpp>
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <iostream>
+#include <vector>
+#include "signal_utils.hpp"
+
+// A tone between two FFT bins must be located to a small fraction of a bin by
+// LoRaDetector::refine(), well beyond the 3-point parabolic fIndex, and
+// estimate_offsets() must report the refined frequency.
+
+using namespace lora_phy;
+
+int main() {
+    bool ok = true;
+    const size_t N = 256;
+    detector_fixture fx(N);
+    LoRaDetector<float>& detector = fx.detector;
+    std::vector<std::complex<float>>& in = fx.in;
+
+    double worst_zoom = 0.0, worst_parabolic = 0.0;
+    for (double frac : {-0.47, -0.31, -0.12, 0.0, 0.05, 0.25, 0.38, 0.49}) {
+        const double bin = 37.0 + frac;
+        std::fill(in.begin(), in.end(), std::complex<float>());
+        add_tone(in.data(), N, N, bin);
+        float p, pav, fi;
+        const size_t idx = detector.detect(p, pav, fi);
+        std::complex<float> peak;
+        const float zf = detector.refine(idx, &peak);
+        const double zoom_err = std::abs(double(idx) + zf - bin);
+        const double para_err = std::abs(double(idx) + fi - bin);
+        worst_zoom = std::max(worst_zoom, zoom_err);
+        worst_parabolic = std::max(worst_parabolic, para_err);
+        // On-frequency the zoom bin holds the full tone energy.
+        if (std::abs(std::abs(peak) - float(N)) > 0.01f * float(N)) {
+            std::cerr << "refined peak magnitude " << std::abs(peak) << " at bin " << bin << "\n";
+            ok = false;
+        }
+    }
+    if (worst_zoom > 2e-3 || worst_zoom >= worst_parabolic) {
+        std::cerr << "zoom refinement error " << worst_zoom << " bins (parabolic "
+                  << worst_parabolic << ")\n";
+        ok = false;
+    }
+
+    // One symbol of preamble: the CFO estimate comes straight from the
+    // refined peak position.
+    std::vector<std::complex<float>> fft_in(N), fft_out(N), iq(N);
+    lora_workspace ws{};
+    ws.fft_in = fft_in.data();
+    ws.fft_out = fft_out.data();
+    lora_params cfg{};
+    cfg.sf = 8;
+    if (init(&ws, &cfg) != 0) {
+        std::cerr << "init failed\n";
+        return 1;
+    }
+    const double bin = 12.3;
+    add_tone(iq.data(), N, N, bin);
+    estimate_offsets(&ws, iq.data(), iq.size());
+    if (std::abs(double(ws.metrics.cfo) * double(N) - bin) > 2e-3) {
+        std::cerr << "estimate_offsets cfo " << ws.metrics.cfo * float(N)
+                  << " bins, expected " << bin << "\n";
+        ok = false;
+    }
+
+    return ok ? 0 : 1;
+}